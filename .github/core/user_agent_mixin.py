@@ -1,7 +1,15 @@
 USER_AGENT = "ALPACA-MCP-SERVER"
 
 class UserAgentMixin:
+    # Shared requests.Session installed into every signed client; None keeps the SDK's own
+    http_session = None
+
+    def __init__(self, *args, **kwargs):
+        super().__init__(*args, **kwargs)
+        if UserAgentMixin.http_session is not None:
+            self._session = UserAgentMixin.http_session
+
     def _get_default_headers(self) -> dict:
         headers = self._get_auth_headers()
         headers["User-Agent"] = USER_AGENT
-        return headers
\ No newline at end of file
+        return headers
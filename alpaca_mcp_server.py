@@ -1,18 +1,53 @@
+import argparse
+import asyncio
+import base64
+import bisect
+import contextvars
+import csv
+import difflib
+import enum
+import functools
+import hashlib
+import importlib
+import inspect
+import io
+import itertools
+import json
+import math
+import operator
 import os
+import random
 import re
+import socket
+import sqlite3
 import sys
+import threading
 import time
-from datetime import datetime, timedelta, date
+import uuid
+import weakref
+from collections import Counter, OrderedDict, defaultdict, deque
+from concurrent.futures import ThreadPoolExecutor
+from datetime import datetime, timedelta, timezone, date
 from typing import Dict, Any, List, Optional, Union
+from urllib.parse import urlparse
+from zoneinfo import ZoneInfo
 
+# Startup phase timestamps, reported on stderr when MCP_STARTUP_TIMING is set
+_startup_marks = [("start", time.perf_counter())]
+
+import requests
 from dotenv import load_dotenv
+from requests.adapters import HTTPAdapter
+from urllib3.connection import HTTPConnection
 
 from alpaca.common.enums import SupportedCurrencies
 from alpaca.common.exceptions import APIError
+from alpaca.common.rest import RESTClient
 from alpaca.data.enums import DataFeed, OptionsFeed
 from alpaca.data.historical.option import OptionHistoricalDataClient
 from alpaca.data.historical.stock import StockHistoricalDataClient, StockLatestTradeRequest
 from alpaca.data.live.stock import StockDataStream
+from alpaca.data.models import Bar, Trade
 from alpaca.data.requests import (
     OptionLatestQuoteRequest,
     OptionSnapshotRequest,
@@ -28,12 +63,14 @@ from alpaca.data.requests import (
 from alpaca.data.timeframe import TimeFrame, TimeFrameUnit
 from alpaca.trading.client import TradingClient
 from alpaca.trading.enums import (
+    AssetClass,
     AssetStatus,
     ContractType,
     CorporateActionDateType,
     CorporateActionType,
     OrderClass,
     OrderSide,
+    OrderStatus,
     OrderType,
     PositionIntent,
     QueryOrderStatus,
@@ -51,14 +88,27 @@ from alpaca.trading.requests import (
     LimitOrderRequest,
     MarketOrderRequest,
     OptionLegRequest,
+    ReplaceOrderRequest,
     StopLimitOrderRequest,
     StopOrderRequest,
     TrailingStopOrderRequest,
     UpdateWatchlistRequest,
 )
+from alpaca.trading.stream import TradingStream
 from mcp.server.fastmcp import FastMCP
+from starlette.responses import PlainTextResponse
+
+_startup_marks.append(("imports", time.perf_counter()))
 USER_AGENT = "ALPACA-MCP-SERVER"
 class UserAgentMixin:
+    # Shared requests.Session installed into every signed client; None keeps the SDK's own
+    http_session = None
+
+    def __init__(self, *args, **kwargs):
+        super().__init__(*args, **kwargs)
+        if UserAgentMixin.http_session is not None:
+            self._session = UserAgentMixin.http_session
+
     def _get_default_headers(self) -> dict:
         headers = self._get_auth_headers()
         headers["User-Agent"] = USER_AGENT
@@ -91,326 +141,2626 @@ log_level = "ERROR" if is_pycharm else "INFO"
 if not is_pycharm:
     print(f"MCP Server starting with log_level={log_level} (PyCharm detected: {is_pycharm})")
 
-mcp = FastMCP("alpaca-trading", log_level=log_level)
+class InstrumentedFastMCP(FastMCP):
+    """
+    FastMCP whose tools report call counts, latency, response size and errors to
+    tool_metrics, and observe the per-session concurrency limit.
+    """
+
+    def tool(self, *args, **kwargs):
+        register = super().tool(*args, **kwargs)
+        return lambda fn: register(_instrument_tool(fn))
+
+mcp = InstrumentedFastMCP("alpaca-trading", log_level=log_level)
 
 # Initialize Alpaca clients using environment variables
 # Import our .env file within the same directory
 load_dotenv()
 
+def _optional_env(name: str) -> Optional[str]:
+    """Read an optional setting, treating empty and "None" (as .env.example writes them) as unset."""
+    value = os.getenv(name, "").strip()
+    return None if value in ("", "None") else value
+
 TRADE_API_KEY = os.getenv("ALPACA_API_KEY")
 TRADE_API_SECRET = os.getenv("ALPACA_SECRET_KEY")
-ALPACA_PAPER_TRADE = os.getenv("ALPACA_PAPER_TRADE", "True")
-TRADE_API_URL = os.getenv("TRADE_API_URL")
-TRDE_API_WSS = os.getenv("TRDE_API_WSS")
-DATA_API_URL = os.getenv("DATA_API_URL")
-STREAM_DATA_WSS = os.getenv("STREAM_DATA_WSS")
+ALPACA_PAPER_TRADE = os.getenv("ALPACA_PAPER_TRADE", "True").lower() in ("1", "true", "yes")
+# Further accounts served by this process ("desk,live"): each NAME reads ALPACA_API_KEY_<NAME>,
+# ALPACA_SECRET_KEY_<NAME> and ALPACA_PAPER_TRADE_<NAME>; the pair above is the "default" account
+MCP_ACCOUNTS = os.getenv("MCP_ACCOUNTS", "")
+# Endpoint overrides, e.g. to point the server at a mock API (see benchmarks/)
+TRADE_API_URL = _optional_env("TRADE_API_URL")
+TRDE_API_WSS = _optional_env("TRDE_API_WSS")
+DATA_API_URL = _optional_env("DATA_API_URL")
+STREAM_DATA_WSS = _optional_env("STREAM_DATA_WSS")
+STREAM_DATA_FEED = os.getenv("STREAM_DATA_FEED", "iex")
+
+# Size of the worker pool used to run blocking SDK calls off the event loop
+MCP_MAX_WORKERS = int(os.getenv("MCP_MAX_WORKERS", "16"))
+# Default per-response budgets for paginated tools
+MCP_MAX_ROWS = int(os.getenv("MCP_MAX_ROWS", "1000"))
+MCP_MAX_BYTES = int(os.getenv("MCP_MAX_BYTES", "200000"))
+# Symbols per multi-symbol request for batch tools
+MCP_BATCH_CHUNK_SIZE = int(os.getenv("MCP_BATCH_CHUNK_SIZE", "100"))
+# Symbols per snapshot request when scan_market loads the universe, and how long the loaded table is reused
+MCP_SCAN_CHUNK_SIZE = int(os.getenv("MCP_SCAN_CHUNK_SIZE", "500"))
+MCP_SCAN_REFRESH_SECONDS = float(os.getenv("MCP_SCAN_REFRESH_SECONDS", "60"))
+# SQLite file for the local bar store; set to an empty value to disable it
+MCP_BAR_STORE_PATH = os.path.expanduser(os.getenv("MCP_BAR_STORE_PATH", "~/.cache/alpaca-mcp/bars.sqlite3"))
+# Directory export_market_data writes to, concurrent per-symbol downloads, and rows per part file
+MCP_EXPORT_DIR = os.path.expanduser(os.getenv("MCP_EXPORT_DIR", "~/alpaca-mcp-exports"))
+MCP_EXPORT_WORKERS = int(os.getenv("MCP_EXPORT_WORKERS", "4"))
+MCP_EXPORT_PART_ROWS = int(os.getenv("MCP_EXPORT_PART_ROWS", "1000000"))
+# Per-minute request budget per API key and API, the requests of it held back for
+# order entry and cancels, and how often a throttled (429) request is requeued
+MCP_RATE_LIMIT_PER_MIN = int(os.getenv("MCP_RATE_LIMIT_PER_MIN", "200"))
+MCP_RATE_LIMIT_RESERVE = int(os.getenv("MCP_RATE_LIMIT_RESERVE", "20"))
+MCP_RATE_LIMIT_RETRIES = int(os.getenv("MCP_RATE_LIMIT_RETRIES", "3"))
+# Seconds an upstream call may take across its retries, per SDK method overrides of it,
+# retries of idempotent reads after transient failures, and whether market data reads
+# fire a hedged second request once they run past their p95 latency
+MCP_API_DEADLINE = float(os.getenv("MCP_API_DEADLINE", "60"))
+MCP_API_DEADLINES = os.getenv(
+    "MCP_API_DEADLINES",
+    "get_stock_snapshot=5,get_option_snapshot=5,get_stock_latest_quote=5,get_stock_latest_trade=5,"
+    "get_stock_latest_bar=5,get_option_latest_quote=5"
+)
+MCP_API_RETRIES = int(os.getenv("MCP_API_RETRIES", "2"))
+MCP_API_HEDGE = os.getenv("MCP_API_HEDGE", "False").lower() in ("1", "true", "yes")
+# Pooled keep-alive connections per API host, and how many to open at startup (0 disables warm-up)
+MCP_HTTP_POOL_SIZE = int(os.getenv("MCP_HTTP_POOL_SIZE", str(max(MCP_MAX_WORKERS, 10))))
+MCP_HTTP_WARMUP_CONNECTIONS = int(os.getenv("MCP_HTTP_WARMUP_CONNECTIONS", "2"))
+# Oldest streamed quote, trade or bar served as "latest"; older values, and every value while the
+# market data stream is down, are fetched from REST instead
+MCP_STREAM_MAX_AGE_SECONDS = float(os.getenv("MCP_STREAM_MAX_AGE_SECONDS", "120"))
+# In-memory order/position mirror fed by the trade updates stream, and its REST reconcile interval
+MCP_ORDER_MIRROR = os.getenv("MCP_ORDER_MIRROR", "True").lower() in ("1", "true", "yes")
+MCP_MIRROR_RECONCILE_SECONDS = float(os.getenv("MCP_MIRROR_RECONCILE_SECONDS", "30"))
+# Daily in-memory prefetch of the market calendar and of held/watchlisted symbols' corporate actions
+MCP_EVENT_PREFETCH = os.getenv("MCP_EVENT_PREFETCH", "True").lower() in ("1", "true", "yes")
+# Recent calls per tool kept for the latency percentiles
+MCP_METRICS_SAMPLES = int(os.getenv("MCP_METRICS_SAMPLES", "1024"))
+# Ceiling for the in-memory caches, indexes and mirrors together; the coldest data is evicted
+# beyond it (0 only reports usage)
+MCP_MEMORY_BUDGET_MB = float(os.getenv("MCP_MEMORY_BUDGET_MB", "512"))
+# Transport ("stdio", "sse" or "streamable-http") and the listen address of the network transports
+MCP_TRANSPORT = os.getenv("MCP_TRANSPORT", "stdio")
+MCP_HOST = os.getenv("MCP_HOST", "127.0.0.1")
+MCP_PORT = int(os.getenv("MCP_PORT", "8000"))
+# Tool calls one MCP session may have in flight; further calls wait (0 disables the limit)
+MCP_SESSION_MAX_CONCURRENCY = int(os.getenv("MCP_SESSION_MAX_CONCURRENCY", "8"))
 
 # Check if keys are available
 if not TRADE_API_KEY or not TRADE_API_SECRET:
     raise ValueError("Alpaca API credentials not found in environment variables.")
 
+# All REST clients share one session so concurrent tool calls reuse pooled, already
+# handshaken TLS connections. requests' default adapter keeps only 10 connections per
+# host and discards the rest after use, which forced new handshakes once more than 10
+# calls ran at once. TCP keep-alive stops idle pooled connections being dropped silently.
+def _build_http_session() -> requests.Session:
+    """Create the shared HTTP session with a connection pool sized for the worker pool."""
+    class KeepAliveAdapter(HTTPAdapter):
+        def init_poolmanager(self, *args, **kwargs):
+            kwargs["socket_options"] = HTTPConnection.default_socket_options + [(socket.SOL_SOCKET, socket.SO_KEEPALIVE, 1)]
+            super().init_poolmanager(*args, **kwargs)
+
+        def send(self, request, timeout=None, **kwargs):
+            # Calls made through _call_api carry a deadline that no single request may outlive
+            deadline = getattr(_upstream_deadline, "at", None)
+            if deadline is not None and (timeout is None or isinstance(timeout, (int, float))):
+                remaining = max(deadline - time.monotonic(), 0.001)
+                timeout = remaining if timeout is None else min(timeout, remaining)
+            return super().send(request, timeout=timeout, **kwargs)
+
+    session = requests.Session()
+    adapter = KeepAliveAdapter(pool_connections=8, pool_maxsize=MCP_HTTP_POOL_SIZE)
+    session.mount("https://", adapter)
+    session.mount("http://", adapter)
+    return session
+
+UserAgentMixin.http_session = _build_http_session()
+
+MCP_STARTUP_TIMING = os.getenv("MCP_STARTUP_TIMING", "").lower() in ("1", "true", "yes")
+
+# The MCP host may spawn a server per session, so startup time is user visible. Clients
+# and heavy optional modules are therefore created on first use rather than at import.
+class _LazyModule:
+    """Stand-in for a module that imports it on first attribute access."""
+
+    def __init__(self, name: str):
+        self._name = name
+        self._module = None
+
+    def __getattr__(self, attr: str):
+        if self._module is None:
+            self._module = importlib.import_module(self._name)
+        return getattr(self._module, attr)
+
+class _LazyClient:
+    """Stand-in for an SDK client that constructs it on first attribute access."""
+
+    def __init__(self, name: str, factory):
+        self._name = name
+        self._factory = factory
+        self._client = None
+        self._lock = threading.Lock()
+
+    def resolve(self):
+        """Return the underlying client, constructing it if needed."""
+        if self._client is None:
+            with self._lock:
+                if self._client is None:
+                    started = time.perf_counter()
+                    self._client = self._factory()
+                    if MCP_STARTUP_TIMING:
+                        print(f"Constructed {self._name} in {(time.perf_counter() - started) * 1000:.1f} ms", file=sys.stderr)
+        return self._client
+
+    def __getattr__(self, attr: str):
+        return getattr(self.resolve(), attr)
+
+# Only the indicator tools need NumPy, and only export_market_data needs PyArrow
+np = _LazyModule("numpy")
+pa = _LazyModule("pyarrow")
+pq = _LazyModule("pyarrow.parquet")
+
+def _rest_client(client):
+    """Finish setting up a REST client: route its responses to the rate limit scheduler."""
+    _install_rate_limit_tracking(client)
+    return client
+
+class _AccountBound(_LazyClient):
+    """
+    Stand-in for a per-account object (trading client, order mirror) that resolves to the
+    one of the current tool call's account, so tools address "the" account unchanged.
+    Market data clients and streams are shared by all accounts and stay plain _LazyClients.
+    """
+
+    def __init__(self, attr: str):
+        self._attr = attr
+
+    def resolve(self):
+        target = getattr(_current_account(), self._attr)
+        return target.resolve() if isinstance(target, _LazyClient) else target
+
 # Initialize clients
-# For trading
-trade_client = TradingClientSigned(TRADE_API_KEY, TRADE_API_SECRET, paper=ALPACA_PAPER_TRADE)
+# For trading, on the default account; see Accounts for the others
+default_trade_client = _LazyClient("trade_client", lambda: _rest_client(
+    TradingClientSigned(TRADE_API_KEY, TRADE_API_SECRET, paper=ALPACA_PAPER_TRADE, url_override=TRADE_API_URL)))
+trade_client = _AccountBound("client")
 # For historical market data
-stock_historical_data_client = StockHistoricalDataClientSigned(TRADE_API_KEY, TRADE_API_SECRET)
+stock_historical_data_client = _LazyClient("stock_historical_data_client", lambda: _rest_client(
+    StockHistoricalDataClientSigned(TRADE_API_KEY, TRADE_API_SECRET, url_override=DATA_API_URL)))
 # For streaming market data
-stock_data_stream_client = StockDataStream(TRADE_API_KEY, TRADE_API_SECRET, url_override=STREAM_DATA_WSS)
+stock_data_stream_client = _LazyClient("stock_data_stream_client", lambda: StockDataStream(
+    TRADE_API_KEY, TRADE_API_SECRET, feed=DataFeed(STREAM_DATA_FEED.lower()), url_override=STREAM_DATA_WSS))
+# For trade (order) updates streaming
+trade_stream_client = _LazyClient("trade_stream_client", lambda: TradingStream(
+    TRADE_API_KEY, TRADE_API_SECRET, paper=ALPACA_PAPER_TRADE, url_override=TRDE_API_WSS))
 # For option historical data
-option_historical_data_client = OptionHistoricalDataClientSigned(api_key=TRADE_API_KEY, secret_key=TRADE_API_SECRET)
+option_historical_data_client = _LazyClient("option_historical_data_client", lambda: _rest_client(
+    OptionHistoricalDataClientSigned(api_key=TRADE_API_KEY, secret_key=TRADE_API_SECRET, url_override=DATA_API_URL)))
+
+_startup_marks.append(("configuration", time.perf_counter()))
 
 # ============================================================================
-# Account Information Tools
+# Tool Metrics
 # ============================================================================
 
-@mcp.tool()
-async def get_account_info() -> str:
+# Reported latency percentiles, and the phases each tool call's wall time is split into
+METRIC_QUANTILES = (0.5, 0.95, 0.99)
+METRIC_PHASES = ("total", "upstream", "formatting")
+
+class ToolError(str):
     """
-    Retrieves and formats the current account information including balances and status.
-    
-    Returns:
-        str: Formatted string containing account details including:
-            - Account ID
-            - Status
-            - Currency
-            - Buying Power
-            - Cash Balance
-            - Portfolio Value
-            - Equity
-            - Market Values
-            - Pattern Day Trader Status
-            - Day Trades Remaining
+    A tool's failure result. Tools report failures as text rather than raising; returning
+    that text as a ToolError is what counts the call as an error in tool_metrics.
     """
-    account = trade_client.get_account()
-    
-    info = f"""
-            Account Information:
-            -------------------
-            Account ID: {account.id}
-            Status: {account.status}
-            Currency: {account.currency}
-            Buying Power: ${float(account.buying_power):.2f}
-            Cash: ${float(account.cash):.2f}
-            Portfolio Value: ${float(account.portfolio_value):.2f}
-            Equity: ${float(account.equity):.2f}
-            Long Market Value: ${float(account.long_market_value):.2f}
-            Short Market Value: ${float(account.short_market_value):.2f}
-            Pattern Day Trader: {'Yes' if account.pattern_day_trader else 'No'}
-            Day Trades Remaining: {account.daytrade_count if hasattr(account, 'daytrade_count') else 'Unknown'}
-            """
-    return info
 
-@mcp.tool()
-async def get_positions() -> str:
+    __slots__ = ()
+
+class _CallTiming:
+    """What one in-progress tool call spent upstream, and its cache hits and last upstream error."""
+
+    __slots__ = ("upstream", "cache_hits", "error")
+
+    def __init__(self):
+        self.upstream = 0.0
+        self.cache_hits = 0
+        self.error: Optional[str] = None
+
+# Set per tool call; _call_api and the response cache add to it. Tasks spawned by a tool
+# (asyncio.gather) copy the context and so report into the same _CallTiming; tasks that
+# outlive the call start through _background_task instead.
+_call_timing: contextvars.ContextVar = contextvars.ContextVar("call_timing", default=None)
+
+def _background_task(coro) -> asyncio.Task:
     """
-    Retrieves and formats all current positions in the portfolio.
-    
-    Returns:
-        str: Formatted string containing details of all open positions including:
-            - Symbol
-            - Quantity
-            - Market Value
-            - Average Entry Price
-            - Current Price
-            - Unrealized P/L
+    Start a task that may outlive the current tool call. It runs without the call's
+    _CallTiming, so upstream time and errors it sees later are not charged to that call.
     """
-    positions = trade_client.get_all_positions()
-    
-    if not positions:
-        return "No open positions found."
-    
-    result = "Current Positions:\n-------------------\n"
-    for position in positions:
-        result += f"""
-                    Symbol: {position.symbol}
-                    Quantity: {position.qty} shares
-                    Market Value: ${float(position.market_value):.2f}
-                    Average Entry Price: ${float(position.avg_entry_price):.2f}
-                    Current Price: ${float(position.current_price):.2f}
-                    Unrealized P/L: ${float(position.unrealized_pl):.2f} ({float(position.unrealized_plpc) * 100:.2f}%)
-                    -------------------
-                    """
-    return result
+    context = contextvars.copy_context()
+    context.run(_call_timing.set, None)
+    return asyncio.get_running_loop().create_task(coro, context=context)
 
-@mcp.tool()
-async def get_open_position(symbol: str) -> str:
+class ToolMetrics:
     """
-    Retrieves and formats details for a specific open position.
-    
-    Args:
-        symbol (str): The symbol name of the asset to get position for (e.g., 'AAPL', 'MSFT')
-    
-    Returns:
-        str: Formatted string containing the position details or an error message
+    Per-tool call counts, error counts by class, cache hits, response bytes and
+    latency. Percentiles come from the last `sample_size` calls of each tool;
+    sums and counts cover the whole process lifetime.
+
+    Upstream time is spent in _call_api (rate limit queueing included) or waiting
+    on a coalesced cache fetch; formatting is the remainder of the call. Tools that
+    fan out concurrently can spend more upstream time than wall time, so the
+    upstream share is capped at the call's total.
     """
-    try:
-        position = trade_client.get_open_position(symbol)
-        
-        # Check if it's an options position by looking for the options symbol pattern
-        is_option = len(symbol) > 6 and any(c in symbol for c in ['C', 'P'])
-        
-        # Format quantity based on asset type
-        quantity_text = f"{position.qty} contracts" if is_option else f"{position.qty}"
 
-        return f"""
-                Position Details for {symbol}:
-                ---------------------------
-                Quantity: {quantity_text}
-                Market Value: ${float(position.market_value):.2f}
-                Average Entry Price: ${float(position.avg_entry_price):.2f}
-                Current Price: ${float(position.current_price):.2f}
-                Unrealized P/L: ${float(position.unrealized_pl):.2f}
-                """ 
-    except Exception as e:
-        return f"Error fetching position: {str(e)}"
+    def __init__(self, sample_size: int):
+        self.started = time.time()
+        self.calls: Dict[str, int] = defaultdict(int)
+        self.errors: Dict[str, Dict[str, int]] = defaultdict(lambda: defaultdict(int))
+        self.cache_hits: Dict[str, int] = defaultdict(int)
+        self.response_bytes: Dict[str, int] = defaultdict(int)
+        self.seconds: Dict[str, List[float]] = defaultdict(lambda: [0.0] * len(METRIC_PHASES))
+        self._samples: Dict[str, deque] = defaultdict(lambda: deque(maxlen=sample_size))
+
+    def record(self, tool: str, total: float, timing: _CallTiming, size: int, error: Optional[str]) -> None:
+        upstream = min(timing.upstream, total)
+        phases = (total, upstream, total - upstream)
+        self.calls[tool] += 1
+        self.cache_hits[tool] += timing.cache_hits
+        self.response_bytes[tool] += size
+        if error:
+            self.errors[tool][error] += 1
+        sums = self.seconds[tool]
+        for i, value in enumerate(phases):
+            sums[i] += value
+        self._samples[tool].append(phases)
+
+    def quantiles(self, tool: str) -> Dict[str, List[float]]:
+        """Latency percentiles (METRIC_QUANTILES order) per phase over the tool's recent calls."""
+        samples = self._samples[tool]
+        result = {}
+        for i, phase in enumerate(METRIC_PHASES):
+            values = sorted(sample[i] for sample in samples)
+            result[phase] = [values[min(len(values) - 1, int(q * len(values)))] for q in METRIC_QUANTILES]
+        return result
+
+    def prometheus(self) -> str:
+        """Render all metrics in the Prometheus text exposition format."""
+        lines = [
+            "# HELP alpaca_mcp_tool_calls_total Tool calls handled.",
+            "# TYPE alpaca_mcp_tool_calls_total counter",
+        ]
+        lines += [f'alpaca_mcp_tool_calls_total{{tool="{tool}"}} {n}' for tool, n in sorted(self.calls.items())]
+        lines += [
+            "# HELP alpaca_mcp_tool_errors_total Tool calls that failed, by error class.",
+            "# TYPE alpaca_mcp_tool_errors_total counter",
+        ]
+        for tool, by_class in sorted(self.errors.items()):
+            lines += [
+                f'alpaca_mcp_tool_errors_total{{tool="{tool}",error_class="{error}"}} {n}'
+                for error, n in sorted(by_class.items())
+            ]
+        lines += [
+            "# HELP alpaca_mcp_tool_cache_hits_total Upstream responses served from the response cache.",
+            "# TYPE alpaca_mcp_tool_cache_hits_total counter",
+        ]
+        lines += [f'alpaca_mcp_tool_cache_hits_total{{tool="{tool}"}} {n}' for tool, n in sorted(self.cache_hits.items())]
+        lines += [
+            "# HELP alpaca_mcp_tool_response_bytes_total Bytes of tool output returned.",
+            "# TYPE alpaca_mcp_tool_response_bytes_total counter",
+        ]
+        lines += [
+            f'alpaca_mcp_tool_response_bytes_total{{tool="{tool}"}} {n}'
+            for tool, n in sorted(self.response_bytes.items())
+        ]
+        lines += [
+            "# HELP alpaca_mcp_tool_duration_seconds Tool call latency by phase (total, upstream, formatting).",
+            "# TYPE alpaca_mcp_tool_duration_seconds summary",
+        ]
+        for tool in sorted(self.calls):
+            quantiles = self.quantiles(tool)
+            for i, phase in enumerate(METRIC_PHASES):
+                labels = f'tool="{tool}",phase="{phase}"'
+                lines += [
+                    f'alpaca_mcp_tool_duration_seconds{{{labels},quantile="{q:g}"}} {value:.6f}'
+                    for q, value in zip(METRIC_QUANTILES, quantiles[phase])
+                ]
+                lines.append(f"alpaca_mcp_tool_duration_seconds_sum{{{labels}}} {self.seconds[tool][i]:.6f}")
+                lines.append(f"alpaca_mcp_tool_duration_seconds_count{{{labels}}} {self.calls[tool]}")
+        return "\n".join(lines) + "\n"
+
+tool_metrics = ToolMetrics(MCP_METRICS_SAMPLES)
 
 # ============================================================================
-# Market Data Tools
+# Memory Budget
 # ============================================================================
 
-@mcp.tool()
-async def get_stock_quote(symbol: str) -> str:
+# Structures idle for less than this are not dropped whole, so a table a scan is still
+# using is not pulled from under it and a busy structure is not rebuilt in a loop
+MEMORY_EVICT_IDLE_SECONDS = 60.0
+# Elements sampled per container when estimating sizes
+_SIZE_SAMPLE = 16
+
+def _approx_size(value: Any, depth: int = 6) -> int:
     """
-    Retrieves and formats the latest quote for a stock.
-    
-    Args:
-        symbol (str): Stock ticker symbol (e.g., AAPL, MSFT)
-    
-    Returns:
-        str: Formatted string containing:
-            - Ask Price
-            - Bid Price
-            - Ask Size
-            - Bid Size
-            - Timestamp
+    Approximate deep size of a value in bytes. Containers are estimated from a sample of
+    their elements, so sizing a list of thousands of SDK models stays cheap.
     """
-    try:
-        request_params = StockLatestQuoteRequest(symbol_or_symbols=symbol)
-        quotes = stock_historical_data_client.get_stock_latest_quote(request_params)
-        
-        if symbol in quotes:
-            quote = quotes[symbol]
-            return f"""
-                    Latest Quote for {symbol}:
-                    ------------------------
-                    Ask Price: ${quote.ask_price:.2f}
-                    Bid Price: ${quote.bid_price:.2f}
-                    Ask Size: {quote.ask_size}
-                    Bid Size: {quote.bid_size}
-                    Timestamp: {quote.timestamp}
-                    """ 
-        else:
-            return f"No quote data found for {symbol}."
-    except Exception as e:
-        return f"Error fetching quote for {symbol}: {str(e)}"
+    size = sys.getsizeof(value)
+    if depth <= 0 or value is None or isinstance(value, (str, bytes, int, float, bool, enum.Enum)):
+        return size
+    nbytes = getattr(value, "nbytes", None)  # NumPy arrays
+    if isinstance(nbytes, int):
+        return size + nbytes
+    if isinstance(value, dict):
+        items = list(itertools.islice(value.items(), _SIZE_SAMPLE))
+        if not items:
+            return size
+        sample = sum(_approx_size(k, depth - 1) + _approx_size(v, depth - 1) for k, v in items)
+        return size + sample * len(value) // len(items)
+    if isinstance(value, (list, tuple, set, frozenset, deque)):
+        items = list(itertools.islice(value, _SIZE_SAMPLE))
+        if not items:
+            return size
+        return size + sum(_approx_size(v, depth - 1) for v in items) * len(value) // len(items)
+    fields = getattr(value, "__dict__", None)
+    if fields is not None:
+        # Attribute names are interned and shared by every instance, so only the values count
+        values = list(itertools.islice(fields.values(), _SIZE_SAMPLE * 2))
+        return size + sys.getsizeof(fields) + sum(_approx_size(v, depth - 1) for v in values) * len(fields) // max(len(values), 1)
+    slots = getattr(type(value), "__slots__", ())
+    return size + sum(_approx_size(getattr(value, slot, None), depth - 1) for slot in slots)
 
-@mcp.tool()
-async def get_stock_bars(
-    symbol: str, 
-    days: int = 5, 
-    timeframe: str = "1Day",
-    limit: Optional[int] = None,
-    start: Optional[str] = None,
-    end: Optional[str] = None
-) -> str:
+class MemoryBudget:
     """
-    Retrieves and formats historical price bars for a stock with configurable timeframe and time range.
-    
-    Args:
-        symbol (str): Stock ticker symbol (e.g., AAPL, MSFT)
-        days (int): Number of days to look back (default: 5, ignored if start/end provided)
-        timeframe (str): Bar timeframe - supports flexible Alpaca formats:
-            - Minutes: "1Min", "2Min", "3Min", "4Min", "5Min", "15Min", "30Min", etc.
-            - Hours: "1Hour", "2Hour", "3Hour", "4Hour", "6Hour", etc.
-            - Days: "1Day", "2Day", "3Day", etc.
-            - Weeks: "1Week", "2Week", etc.
-            - Months: "1Month", "2Month", etc.
-            (default: "1Day")
-        limit (Optional[int]): Maximum number of bars to return (optional)
-        start (Optional[str]): Start time in ISO format (e.g., "2023-01-01T09:30:00" or "2023-01-01")
-        end (Optional[str]): End time in ISO format (e.g., "2023-01-01T16:00:00" or "2023-01-01")
-    
-    Returns:
-        str: Formatted string containing historical price data with timestamps, OHLCV data
+    Central accounting of the in-process caches against MCP_MEMORY_BUDGET_MB.
+
+    Each structure registers a size() callable reporting its approximate bytes from
+    running totals (so checking the budget after every tool call stays cheap) and,
+    when it can shed data, an evict(bytes) callable that frees about that much, coldest
+    data first, and returns the bytes it freed. Over budget, structures are asked to
+    evict in priority order, cheapest to rebuild first. Structures bounded by their own
+    limits (stream values per subscribed symbol, alert windows) are only reported.
+
+    Sizes are estimates; objects referenced from two structures (the asset universe
+    is both cached and indexed) are counted by each, so the accounting errs high.
+    Evictions run on the event loop, like the cache mutations they compete with.
     """
+
+    def __init__(self, limit_bytes: int):
+        self.limit = limit_bytes
+        self._structures: Dict[str, tuple] = {}
+        self.evictions: Dict[str, int] = defaultdict(int)
+        self.evicted_bytes: Dict[str, int] = defaultdict(int)
+
+    def register(self, name: str, size, evict=None, priority: int = 100) -> None:
+        """Track a structure; lower priorities are evicted first."""
+        self._structures[name] = (size, evict, priority)
+
+    def usage(self) -> Dict[str, int]:
+        return {name: int(size()) for name, (size, _, _) in self._structures.items()}
+
+    def enforce(self) -> int:
+        """Evict until the tracked total fits the budget; returns the bytes freed."""
+        if self.limit <= 0:
+            return 0
+        over = sum(self.usage().values()) - self.limit
+        freed = 0
+        for name, (_, evict, _) in sorted(self._structures.items(), key=lambda item: item[1][2]):
+            if over <= 0:
+                break
+            if evict is None:
+                continue
+            released = evict(over)
+            if released > 0:
+                self.evictions[name] += 1
+                self.evicted_bytes[name] += released
+                over -= released
+                freed += released
+        return freed
+
+    def prometheus(self) -> str:
+        """Render usage and eviction counters in the Prometheus text exposition format."""
+        usage = self.usage()
+        lines = [
+            "# HELP alpaca_mcp_memory_bytes Approximate bytes held per in-memory structure.",
+            "# TYPE alpaca_mcp_memory_bytes gauge",
+        ]
+        lines += [f'alpaca_mcp_memory_bytes{{structure="{name}"}} {n}' for name, n in sorted(usage.items())]
+        lines += [
+            "# HELP alpaca_mcp_memory_budget_bytes Memory budget of the tracked structures (0: unlimited).",
+            "# TYPE alpaca_mcp_memory_budget_bytes gauge",
+            f"alpaca_mcp_memory_budget_bytes {self.limit}",
+            "# HELP alpaca_mcp_memory_evicted_bytes_total Bytes evicted to stay within the budget.",
+            "# TYPE alpaca_mcp_memory_evicted_bytes_total counter",
+        ]
+        lines += [f'alpaca_mcp_memory_evicted_bytes_total{{structure="{name}"}} {self.evicted_bytes[name]}'
+                  for name in sorted(usage)]
+        return "\n".join(lines) + "\n"
+
+memory_budget = MemoryBudget(int(MCP_MEMORY_BUDGET_MB * 1024 * 1024))
+
+# ============================================================================
+# Session Limits
+# ============================================================================
+
+# On the network transports many MCP sessions share this process, and with it the
+# connection pools, response cache, mirrors and rate limit scheduler. A per-session
+# semaphore keeps one busy agent from occupying the whole worker pool and rate budget.
+_session_slots: "weakref.WeakKeyDictionary[Any, asyncio.Semaphore]" = weakref.WeakKeyDictionary()
+
+def _current_session():
+    """The MCP session of the tool call in progress, or None outside a request."""
     try:
-        # Parse timeframe string to TimeFrame object
-        timeframe_obj = parse_timeframe_with_enums(timeframe)
-        if timeframe_obj is None:
-            return f"Error: Invalid timeframe '{timeframe}'. Supported formats: 1Min, 2Min, 4Min, 5Min, 15Min, 30Min, 1Hour, 2Hour, 4Hour, 1Day, 1Week, 1Month, etc."
-        
-        # Parse start/end times or calculate from days
-        start_time = None
-        end_time = None
-        
-        if start:
-            try:
-                start_time = datetime.fromisoformat(start.replace('Z', '+00:00'))
-            except ValueError:
-                return f"Error: Invalid start time format '{start}'. Use ISO format like '2023-01-01T09:30:00' or '2023-01-01'"
-                
-        if end:
-            try:
-                end_time = datetime.fromisoformat(end.replace('Z', '+00:00'))
-            except ValueError:
-                return f"Error: Invalid end time format '{end}'. Use ISO format like '2023-01-01T16:00:00' or '2023-01-01'"
-        
-        # If no start/end provided, calculate from days parameter OR limit+timeframe
-        if not start_time:
-            if limit and timeframe_obj.unit_value in [TimeFrameUnit.Minute, TimeFrameUnit.Hour]:
-                # Calculate based on limit and timeframe for intraday data
-                if timeframe_obj.unit_value == TimeFrameUnit.Minute:
-                    minutes_back = limit * timeframe_obj.amount
-                    start_time = datetime.now() - timedelta(minutes=minutes_back)
-                elif timeframe_obj.unit_value == TimeFrameUnit.Hour:
-                    hours_back = limit * timeframe_obj.amount
-                    start_time = datetime.now() - timedelta(hours=hours_back)
+        return mcp.get_context().session
+    except (LookupError, ValueError):
+        return None
+
+def _session_slot() -> Optional[asyncio.Semaphore]:
+    if MCP_SESSION_MAX_CONCURRENCY <= 0:
+        return None
+    session = _current_session()
+    if session is None:
+        return None
+    slot = _session_slots.get(session)
+    if slot is None:
+        slot = _session_slots[session] = asyncio.Semaphore(MCP_SESSION_MAX_CONCURRENCY)
+    return slot
+
+def _instrument_tool(fn):
+    """
+    Wrap a tool coroutine so every call is timed, recorded in tool_metrics and held to its
+    session's limit. Tools declaring an `account` parameter run with that account current,
+    so their trade_client and order_mirror calls go to its client pool and mirror.
+    """
+    name = fn.__name__
+    account_scoped = "account" in inspect.signature(fn).parameters
+
+    @functools.wraps(fn)
+    async def wrapper(*args, **kwargs):
+        timing = _CallTiming()
+        token = _call_timing.set(timing)
+        start = time.perf_counter()
+        error = None
+        result = None
+        slot = _session_slot()
+        account_token = None
+        try:
+            account = _find_account(kwargs.get("account")) if account_scoped else None
+            if account_scoped and account is None:
+                result = ToolError(f"Error: Unknown account '{kwargs['account']}'. Configured accounts: {', '.join(accounts)}")
             else:
-                # Fall back to days parameter for daily+ timeframes
-                start_time = datetime.now() - timedelta(days=days)
-        if not end_time:
-            end_time = datetime.now()
-        
-        request_params = StockBarsRequest(
-            symbol_or_symbols=symbol,
-            timeframe=timeframe_obj,
-            start=start_time,
-            end=end_time,
-            limit=limit
-        )
-        
-        bars = stock_historical_data_client.get_stock_bars(request_params)
-        
-        if bars[symbol]:
-            time_range = f"{start_time.strftime('%Y-%m-%d %H:%M')} to {end_time.strftime('%Y-%m-%d %H:%M')}"
-            result = f"Historical Data for {symbol} ({timeframe} bars, {time_range}):\n"
-            result += "---------------------------------------------------\n"
-            
-            for bar in bars[symbol]:
-                # Format timestamp based on timeframe unit
-                if timeframe_obj.unit_value in [TimeFrameUnit.Minute, TimeFrameUnit.Hour]:
-                    time_str = bar.timestamp.strftime('%Y-%m-%d %H:%M:%S')
+                if account is not None:
+                    account_token = _account_var.set(account)
+                if slot is None:
+                    result = await fn(*args, **kwargs)
                 else:
-                    time_str = bar.timestamp.date()
-                
-                result += f"Time: {time_str}, Open: ${bar.open:.2f}, High: ${bar.high:.2f}, Low: ${bar.low:.2f}, Close: ${bar.close:.2f}, Volume: {bar.volume}\n"
-            
+                    # Time spent waiting for a session slot counts toward the call's latency
+                    async with slot:
+                        result = await fn(*args, **kwargs)
+            if isinstance(result, ToolError):
+                # The tool caught the exception; name it after the upstream failure if there was one
+                error = timing.error or "ErrorResponse"
             return result
-        else:
-            return f"No historical data found for {symbol} with {timeframe} timeframe in the specified time range."
-    except Exception as e:
-        return f"Error fetching historical data for {symbol}: {str(e)}"
+        except Exception as e:
+            error = type(e).__name__
+            raise
+        finally:
+            if account_token is not None:
+                _account_var.reset(account_token)
+            _call_timing.reset(token)
+            if isinstance(result, str):
+                size = len(result.encode())
+            else:
+                size = 0 if result is None else len(json.dumps(result, default=str))
+            tool_metrics.record(name, time.perf_counter() - start, timing, size, error)
+            memory_budget.enforce()
 
-@mcp.tool()
-async def get_stock_trades(
-    symbol: str,
-    days: int = 5,
-    limit: Optional[int] = None,
-    sort: Optional[Sort] = Sort.ASC,
-    feed: Optional[DataFeed] = None,
-    currency: Optional[SupportedCurrencies] = None,
-    asof: Optional[str] = None
-) -> str:
+    return wrapper
+
+# ============================================================================
+# Off-Loop Execution
+# ============================================================================
+
+# The alpaca-py clients are synchronous. Every upstream call is dispatched to this
+# bounded pool so that a slow request never stalls the FastMCP event loop and
+# concurrent tool calls overlap instead of queueing behind each other.
+_executor = ThreadPoolExecutor(max_workers=MCP_MAX_WORKERS, thread_name_prefix="alpaca-api")
+
+async def _run_blocking(func, *args, **kwargs):
+    """Run a blocking callable on the shared worker pool and await its result."""
+    loop = asyncio.get_running_loop()
+    return await loop.run_in_executor(_executor, functools.partial(func, *args, **kwargs))
+
+# ============================================================================
+# Rate Limit Scheduler
+# ============================================================================
+
+# SDK methods that place, change or cancel orders and positions. They take the priority
+# lane: market data traffic always leaves MCP_RATE_LIMIT_RESERVE requests of the budget
+# unspent for them, so a burst of bar downloads cannot starve an order or a cancel.
+PRIORITY_CALLS = frozenset({
+    "submit_order", "replace_order_by_id", "cancel_order_by_id", "cancel_orders",
+    "close_position", "close_all_positions",
+})
+
+class RateLimitBucket:
     """
-    Retrieves and formats historical trades for a stock.
-    
-    Args:
-        symbol (str): Stock ticker symbol (e.g., 'AAPL', 'MSFT')
-        days (int): Number of days to look back (default: 5)
-        limit (Optional[int]): Upper limit of number of data points to return
-        sort (Optional[Sort]): Chronological order of response (ASC or DESC)
-        feed (Optional[DataFeed]): The stock data feed to retrieve from
-        currency (Optional[SupportedCurrencies]): Currency for prices (default: USD)
-        asof (Optional[str]): The asof date in YYYY-MM-DD format
-    
-    Returns:
-        str: Formatted string containing trade history or an error message
+    Token bucket for one API key and API (trading or market data).
+
+    Tokens refill continuously at the per-minute limit and are reconciled with the
+    X-RateLimit-Limit/Remaining/Reset headers of every response, so requests made by
+    other processes with the same key are accounted for too. Header updates arrive on
+    worker threads, so the state is guarded by a threading lock.
     """
-    try:
-        # Calculate start time based on days
-        start_time = datetime.now() - timedelta(days=days)
-        
-        # Create the request object with all available parameters
-        request_params = StockTradesRequest(
-            symbol_or_symbols=symbol,
-            start=start_time,
-            end=datetime.now(),
-            limit=limit,
-            sort=sort,
-            feed=feed,
-            currency=currency,
-            asof=asof
-        )
-        
-        # Get the trades
-        trades = stock_historical_data_client.get_stock_trades(request_params)
-        
-        if symbol in trades:
-            result = f"Historical Trades for {symbol} (Last {days} days):\n"
-            result += "---------------------------------------------------\n"
-            
-            for trade in trades[symbol]:
-                result += f"""
+
+    def __init__(self, name: str, limit: int, reserve: int):
+        self.name = name
+        self.limit = limit
+        self.reserve = reserve
+        self.remaining: Optional[int] = None
+        self.stats: Dict[str, int] = defaultdict(int)
+        self._lock = threading.Lock()
+        self._tokens = float(limit)
+        self._updated = time.monotonic()
+        self._blocked_until = 0.0
+
+    def _refill(self, now: float) -> None:
+        self._tokens = min(float(self.limit), self._tokens + (now - self._updated) * self.limit / 60.0)
+        self._updated = now
+
+    def _try_take(self, priority: bool) -> float:
+        """Take a token if the lane allows it; return 0 on success or the seconds until the next attempt."""
+        with self._lock:
+            now = time.monotonic()
+            self._refill(now)
+            if now < self._blocked_until:
+                return self._blocked_until - now
+            needed = 1 if priority else 1 + min(self.reserve, self.limit - 1)
+            if self._tokens >= needed:
+                self._tokens -= 1
+                return 0.0
+            return (needed - self._tokens) * 60.0 / self.limit
+
+    async def acquire(self, priority: bool = False) -> None:
+        """Wait until a request may be sent in the given lane."""
+        waited = False
+        while True:
+            delay = self._try_take(priority)
+            if delay <= 0:
+                break
+            waited = True
+            await asyncio.sleep(delay)
+        with self._lock:
+            self.stats["priority" if priority else "data"] += 1
+            if waited:
+                self.stats["waited"] += 1
+
+    def try_acquire(self) -> bool:
+        """Take a data lane token only if one is free right now (for optional extra requests)."""
+        if self._try_take(False) > 0:
+            return False
+        with self._lock:
+            self.stats["data"] += 1
+        return True
+
+    def observe(self, headers, status_code: int) -> None:
+        """Reconcile the bucket with the rate limit headers of an API response."""
+        limit = headers.get("X-RateLimit-Limit")
+        remaining = headers.get("X-RateLimit-Remaining")
+        reset = headers.get("X-RateLimit-Reset") or None
+        with self._lock:
+            now = time.monotonic()
+            self._refill(now)
+            if limit and limit.isdigit() and int(limit) > 0:
+                self.limit = int(limit)
+            if remaining and remaining.isdigit():
+                self.remaining = int(remaining)
+                self._tokens = min(self._tokens, float(self.remaining))
+            if status_code == 429 or remaining == "0":
+                # Hold every lane until the window resets; X-RateLimit-Reset is epoch seconds
+                wait = float(reset) - time.time() if reset and reset.isdigit() else 1.0
+                self._blocked_until = max(self._blocked_until, now + min(max(wait, 1.0), 60.0))
+                self._tokens = 0.0
+                if status_code == 429:
+                    self.stats["throttled"] += 1
+
+    def status(self) -> Dict[str, Any]:
+        with self._lock:
+            now = time.monotonic()
+            self._refill(now)
+            return {
+                "limit": self.limit, "reserve": self.reserve, "tokens": self._tokens,
+                "remaining": self.remaining, "blocked_for": max(self._blocked_until - now, 0.0),
+                **self.stats,
+            }
+
+_rate_limit_buckets: Dict[tuple, RateLimitBucket] = {}
+# (API host, API key) -> bucket, used to route responses of the shared HTTP session
+_rate_limit_routes: Dict[tuple, RateLimitBucket] = {}
+
+def _rate_limit_bucket(client: RESTClient) -> RateLimitBucket:
+    """Return the bucket for a client's API key and API, creating it on first use."""
+    if isinstance(client, _LazyClient):
+        client = client.resolve()
+    api = "trading" if isinstance(client, TradingClient) else "data"
+    api_key = getattr(client, "_api_key", None) or TRADE_API_KEY
+    bucket = _rate_limit_buckets.get((api_key, api))
+    if bucket is None:
+        bucket = RateLimitBucket(f"{api} (key ...{api_key[-4:]})", MCP_RATE_LIMIT_PER_MIN, MCP_RATE_LIMIT_RESERVE)
+        _rate_limit_buckets[(api_key, api)] = bucket
+    return bucket
+
+def _client_base_url(client: RESTClient) -> str:
+    base_url = client._base_url
+    return getattr(base_url, "value", base_url)
+
+def _observe_rate_limit(response, *args, **kwargs) -> None:
+    """Session response hook routing rate limit headers to the bucket of the host and API key."""
+    route = (urlparse(response.url).netloc, response.request.headers.get("APCA-API-KEY-ID"))
+    bucket = _rate_limit_routes.get(route)
+    if bucket is not None:
+        bucket.observe(response.headers, response.status_code)
+
+def _install_rate_limit_tracking(client: RESTClient) -> None:
+    """Feed a client's responses into its bucket and take over its 429 handling."""
+    bucket = _rate_limit_bucket(client)
+    _rate_limit_routes[(urlparse(_client_base_url(client)).netloc, client._api_key)] = bucket
+    hooks = client._session.hooks["response"]
+    if _observe_rate_limit not in hooks:
+        hooks.append(_observe_rate_limit)
+    # The SDK would otherwise sleep and retry 429s and 504s inside a worker thread, out of
+    # sight of the scheduler and the call's deadline; let them surface so _call_api can
+    # requeue or retry them instead (and never blindly resubmit an order)
+    client._retry_codes = [code for code in client._retry_codes if code not in (429, 504)]
+
+def _warm_connection(url: str) -> None:
+    try:
+        UserAgentMixin.http_session.head(url, timeout=10)
+    except requests.RequestException:
+        pass
+
+def _warm_http_pool(clients: List[RESTClient], connections: int) -> None:
+    """
+    Construct the REST clients and open pooled connections to every API host, so the
+    first tool calls do not pay for client setup or DNS, TCP and TLS handshakes. Runs
+    on the worker pool; the requests are unauthenticated HEADs, which do not count
+    against the rate limit. Started from main(), so importing the module stays free
+    of client construction and network I/O.
+    """
+    for url in {_client_base_url(client) for client in clients}:
+        for _ in range(connections):
+            _executor.submit(_warm_connection, url)
+
+def _api_client_for(func, args: tuple) -> RESTClient:
+    """Find the client an upstream call goes through; bare page fetchers call the data API."""
+    owner = getattr(func, "__self__", None)
+    if isinstance(owner, RESTClient):
+        return owner
+    if args and isinstance(args[0], (RESTClient, _LazyClient)):
+        return args[0]
+    return stock_historical_data_client
+
+# ============================================================================
+# Upstream Deadlines, Retries and Hedging
+# ============================================================================
+
+# Per SDK method deadlines from MCP_API_DEADLINES ("get_stock_snapshot=5,..."); others, and
+# multi-symbol requests of these methods, get MCP_API_DEADLINE (see _call_deadline)
+API_DEADLINES = {
+    name.strip(): float(seconds)
+    for name, seconds in (item.split("=", 1) for item in MCP_API_DEADLINES.split(",") if "=" in item)
+}
+# Reads that are not named get_*: raw market data page fetches
+IDEMPOTENT_CALLS = frozenset({"_fetch_data_page"})
+# Upstream statuses worth retrying; 429 is requeued separately by the rate limit scheduler
+TRANSIENT_STATUS_CODES = frozenset({500, 502, 503, 504})
+# Successful calls per method kept for its p95 latency, and how many are needed before hedging
+ENDPOINT_LATENCY_SAMPLES = 256
+HEDGE_MIN_SAMPLES = 20
+
+class UpstreamTimeout(TimeoutError):
+    """An upstream call ran out of its deadline."""
+
+class _EndpointStats:
+    """Recent latency and retry/hedge counters of one SDK method."""
+
+    __slots__ = ("samples", "calls", "retries", "hedges", "hedge_wins", "timeouts", "_p95", "_stale")
+
+    def __init__(self):
+        self.samples: deque = deque(maxlen=ENDPOINT_LATENCY_SAMPLES)
+        self.calls = self.retries = self.hedges = self.hedge_wins = self.timeouts = 0
+        self._p95: Optional[float] = None
+        self._stale = 0
+
+    def observe(self, seconds: float) -> None:
+        self.samples.append(seconds)
+        self._stale += 1
+
+    @property
+    def p95(self) -> Optional[float]:
+        """p95 latency of recent successful attempts, or None until there are enough to hedge on."""
+        if len(self.samples) < HEDGE_MIN_SAMPLES:
+            return None
+        if self._p95 is None or self._stale >= 16:
+            values = sorted(self.samples)
+            self._p95, self._stale = values[int(0.95 * (len(values) - 1))], 0
+        return self._p95
+
+_endpoint_stats: Dict[str, _EndpointStats] = defaultdict(_EndpointStats)
+
+def _call_deadline(name: str, args: tuple, kwargs: dict) -> float:
+    """
+    Seconds an upstream call may take. The short per-method deadlines are sized for one
+    symbol; a multi-symbol request (a scan or chain chunk of hundreds of snapshots) would
+    time out under them and silently lose its symbols, so it gets MCP_API_DEADLINE.
+    """
+    seconds = API_DEADLINES.get(name)
+    if seconds is None:
+        return MCP_API_DEADLINE
+    request = args[0] if args else next(iter(kwargs.values()), None)
+    symbols = getattr(request, "symbol_or_symbols", None)
+    if isinstance(symbols, (list, tuple, set)) and len(symbols) > 1:
+        return max(seconds, MCP_API_DEADLINE)
+    return seconds
+# Deadline (time.monotonic) of the upstream attempt running on a worker thread; the HTTP
+# adapter bounds every request of the attempt by it
+_upstream_deadline = threading.local()
+
+def _with_deadline(deadline: float, func, args: tuple, kwargs: dict):
+    _upstream_deadline.at = deadline
+    try:
+        return func(*args, **kwargs)
+    finally:
+        _upstream_deadline.at = None
+
+def _retry_policy(name: str, args: tuple, kwargs: dict) -> Optional[str]:
+    """
+    How a call may be retried: "read" for idempotent reads, "keyed" for an order carrying a
+    client_order_id (resubmitted only after checking it was not placed), None for other writes.
+    """
+    if name.startswith("get_") or name in IDEMPOTENT_CALLS:
+        return "read"
+    if name == "submit_order":
+        request = args[0] if args else kwargs.get("order_data")
+        if getattr(request, "client_order_id", None):
+            return "keyed"
+    return None
+
+def _is_transient(error: Exception) -> bool:
+    if isinstance(error, APIError):
+        return getattr(error, "status_code", None) in TRANSIENT_STATUS_CODES
+    return isinstance(error, (requests.ConnectionError, requests.Timeout))
+
+def _is_market_data_call(func, args: tuple) -> bool:
+    client = _api_client_for(func, args)
+    if isinstance(client, _LazyClient):
+        client = client.resolve()
+    return not isinstance(client, TradingClient)
+
+def _ignore_abandoned(task: asyncio.Future) -> None:
+    # A hedge loser finishes on its own (bounded by the deadline); nobody reads its result
+    if not task.cancelled():
+        task.exception()
+
+async def _attempt(func, args: tuple, kwargs: dict, deadline: float, hedge_after: Optional[float],
+                   bucket: RateLimitBucket, stats: _EndpointStats):
+    """
+    Run one attempt of an upstream call within the deadline. With hedge_after set, a second
+    copy is fired if the first has not answered by then and the rate limit has a token to
+    spare; the first success wins.
+    """
+    started: Dict[asyncio.Future, float] = {}
+
+    def launch() -> asyncio.Future:
+        task = _background_task(_run_blocking(_with_deadline, deadline, func, args, kwargs))
+        task.add_done_callback(_ignore_abandoned)
+        started[task] = time.monotonic()
+        return task
+
+    first = launch()
+    tasks = [first]
+    error = None
+    if hedge_after is not None and time.monotonic() + hedge_after < deadline:
+        done, _ = await asyncio.wait(tasks, timeout=hedge_after)
+        if not done and bucket.try_acquire():
+            stats.hedges += 1
+            tasks.append(launch())
+    while tasks:
+        done, _ = await asyncio.wait(tasks, timeout=max(deadline - time.monotonic(), 0.0),
+                                     return_when=asyncio.FIRST_COMPLETED)
+        if not done:
+            break
+        for task in done:
+            tasks.remove(task)
+            if task.exception() is None:
+                stats.observe(time.monotonic() - started[task])
+                if task is not first:
+                    stats.hedge_wins += 1
+                return task.result()
+            error = task.exception()
+    if error is not None:
+        raise error
+    stats.timeouts += 1
+    raise UpstreamTimeout(f"{getattr(func, '__name__', 'upstream call')} timed out after its deadline")
+
+async def _find_submitted_order(func, request):
+    """The order a failed submission may have placed anyway, looked up by its client_order_id."""
+    try:
+        return await _run_blocking(func.__self__.get_order_by_client_id, request.client_order_id)
+    except APIError as e:
+        if getattr(e, "status_code", None) == 404:
+            return None
+        raise
+
+async def _call_api(func, *args, **kwargs):
+    """
+    Execute a synchronous Alpaca SDK call off the event loop.
+    
+    All tools route their upstream requests through this function so that
+    cross-cutting behaviour applies uniformly to every Alpaca call. Each call first
+    waits for a token from its API's rate limit bucket (order entry and cancels in
+    the priority lane), and a request rejected with HTTP 429 is requeued with
+    exponential backoff up to MCP_RATE_LIMIT_RETRIES times instead of failing.
+    
+    Once the first request leaves the rate limit queue the call has its method's
+    deadline (MCP_API_DEADLINES for single-symbol requests, else MCP_API_DEADLINE) for
+    all of its attempts.
+    Idempotent reads that fail transiently (connection errors, timeouts, 5xx) are
+    retried with jittered exponential backoff up to MCP_API_RETRIES times; orders are
+    retried only when they carry a client_order_id, and only after looking it up shows
+    the failed attempt did not place them. With MCP_API_HEDGE market data reads fire a
+    second request when the first is slower than the method's recent p95 latency.
+    The time spent here counts as upstream time in the calling tool's metrics.
+    
+    Args:
+        func: Bound SDK method (e.g., trade_client.get_account)
+        *args: Positional arguments forwarded to the method
+        **kwargs: Keyword arguments forwarded to the method
+    
+    Returns:
+        The SDK method's return value. Exceptions propagate to the caller.
+    """
+    name = getattr(func, "__name__", "")
+    bucket = _rate_limit_bucket(_api_client_for(func, args))
+    priority = name in PRIORITY_CALLS
+    policy = _retry_policy(name, args, kwargs)
+    stats = _endpoint_stats[name]
+    stats.calls += 1
+    hedge = MCP_API_HEDGE and policy == "read" and _is_market_data_call(func, args)
+    timing = _call_timing.get()
+    start = time.perf_counter()
+    deadline = None
+    throttled = failures = 0
+    try:
+        while True:
+            await bucket.acquire(priority)
+            if deadline is None:
+                deadline = time.monotonic() + _call_deadline(name, args, kwargs)
+            try:
+                if failures and policy == "keyed":
+                    placed = await _find_submitted_order(func, args[0] if args else kwargs["order_data"])
+                    if placed is not None:
+                        return placed
+                    await bucket.acquire(priority)
+                return await _attempt(func, args, kwargs, deadline, stats.p95 if hedge else None, bucket, stats)
+            except APIError as e:
+                if getattr(e, "status_code", None) == 429 and throttled < MCP_RATE_LIMIT_RETRIES:
+                    await asyncio.sleep(0.5 * 2 ** throttled)
+                    throttled += 1
+                    continue
+                if not (policy and _is_transient(e)) or failures >= MCP_API_RETRIES:
+                    raise
+                error = e
+            except (requests.ConnectionError, requests.Timeout) as e:
+                if not policy or failures >= MCP_API_RETRIES:
+                    raise
+                error = e
+            backoff = random.uniform(0.5, 1.0) * 0.2 * 2 ** failures
+            if time.monotonic() + backoff >= deadline:
+                raise error
+            failures += 1
+            stats.retries += 1
+            await asyncio.sleep(backoff)
+    except Exception as e:
+        if timing is not None:
+            timing.error = type(e).__name__
+        raise
+    finally:
+        if timing is not None:
+            timing.upstream += time.perf_counter() - start
+
+# ============================================================================
+# Live Market Data Stream
+# ============================================================================
+
+class _StreamRecord:
+    """
+    Compact copy of a streamed SDK model holding only the fields tools read. A pydantic
+    model with its field dict weighs several times as much, for every subscribed symbol.
+    """
+
+    __slots__ = ("received",)  # time.monotonic() of arrival, for the staleness check
+
+    def __init__(self, message):
+        for field in self.__slots__:
+            setattr(self, field, getattr(message, field, None))
+        self.received = time.monotonic()
+
+class StreamQuote(_StreamRecord):
+    __slots__ = ("symbol", "timestamp", "bid_price", "bid_size", "ask_price", "ask_size")
+
+class StreamTrade(_StreamRecord):
+    __slots__ = ("symbol", "timestamp", "price", "size", "exchange", "id", "conditions")
+
+class StreamBar(_StreamRecord):
+    __slots__ = ("symbol", "timestamp", "open", "high", "low", "close", "volume", "trade_count", "vwap")
+
+class MarketDataStreamManager:
+    """
+    Owns the StockDataStream websocket and keeps the latest quote, trade and
+    minute bar for every subscribed symbol in memory, as compact records.
+
+    The stream runs its own asyncio loop on a daemon thread that is started on
+    the first subscription. Subscribe/unsubscribe calls block until the stream
+    acknowledges them, so callers should dispatch them with _run_blocking.
+
+    Values are only served while the stream is connected and no older than
+    MCP_STREAM_MAX_AGE_SECONDS; otherwise readers get None and go to REST. A dead
+    stream thread is restarted from the next read, at most every STREAM_RESTART_SECONDS.
+    """
+
+    STREAM_RESTART_SECONDS = 10.0
+
+    def __init__(self, stream: StockDataStream, feed: DataFeed):
+        self._stream = stream
+        self.feed = feed
+        self._lock = threading.Lock()
+        self._thread: Optional[threading.Thread] = None
+        self._started = 0.0
+        self.last_message: Optional[float] = None
+        self.restarts = 0
+        self._subscribed: set = set()
+        self._quotes: Dict[str, Any] = {}
+        self._trades: Dict[str, Any] = {}
+        self._bars: Dict[str, Any] = {}
+        # Called on the stream thread as listener(kind, message) for every quote, trade and bar
+        self._listeners: List[Any] = []
+
+    def add_listener(self, listener) -> None:
+        """Register a callback for stream messages; it runs on the stream thread and must not block."""
+        self._listeners.append(listener)
+
+    def _notify(self, kind: str, message) -> None:
+        for listener in self._listeners:
+            listener(kind, message)
+
+    async def _on_quote(self, quote) -> None:
+        record = self._quotes[quote.symbol] = StreamQuote(quote)
+        self.last_message = record.received
+        self._notify("quote", record)
+
+    async def _on_trade(self, trade) -> None:
+        record = self._trades[trade.symbol] = StreamTrade(trade)
+        self.last_message = record.received
+        self._notify("trade", record)
+
+    async def _on_bar(self, bar) -> None:
+        record = self._bars[bar.symbol] = StreamBar(bar)
+        self.last_message = record.received
+        self._notify("bar", record)
+
+    def memory_bytes(self) -> int:
+        """Approximate size of the latest values, from one sampled record per kind."""
+        total = 0
+        for values in (self._quotes, self._trades, self._bars):
+            sample = next(iter(values.values()), None)
+            if sample is not None:
+                total += len(values) * (_approx_size(sample) + 100)  # Plus the dict slot and key
+        return total
+
+    def _ensure_running(self) -> None:
+        if self._thread is None or not self._thread.is_alive():
+            if self._thread is not None:
+                self.restarts += 1
+            self._thread = threading.Thread(target=self._stream.run, name="alpaca-market-stream", daemon=True)
+            self._thread.start()
+            self._started = time.monotonic()
+
+    @property
+    def live(self) -> bool:
+        """Whether the stream thread is running and its websocket is connected."""
+        return (self._thread is not None and self._thread.is_alive()
+                and bool(getattr(self._stream, "_running", False)))
+
+    @property
+    def status(self) -> str:
+        if self._thread is None:
+            return "not started"
+        if not self._thread.is_alive():
+            return "stopped"
+        if not self.live:
+            return "connecting"
+        if self.last_message is None:
+            return "connected (no messages yet)"
+        return f"connected (last message {time.monotonic() - self.last_message:.0f}s ago)"
+
+    def _fresh(self, record):
+        """record if it can stand in for REST, else None; restarts a dead stream thread."""
+        if record is None:
+            return None
+        if self._thread is not None and not self._thread.is_alive() \
+                and time.monotonic() - self._started >= self.STREAM_RESTART_SECONDS:
+            # Readers run on the event loop, so never wait for a subscribe holding the lock
+            if self._lock.acquire(blocking=False):
+                try:
+                    if self._subscribed:
+                        self._ensure_running()
+                finally:
+                    self._lock.release()
+        if not self.live or time.monotonic() - record.received > MCP_STREAM_MAX_AGE_SECONDS:
+            return None
+        return record
+
+    def subscribe(self, symbols: List[str]) -> List[str]:
+        """Subscribe symbols to quotes, trades and minute bars. Returns the newly added symbols."""
+        with self._lock:
+            added = [s for s in dict.fromkeys(symbols) if s not in self._subscribed]
+            if not added:
+                return []
+            self._stream.subscribe_quotes(self._on_quote, *added)
+            self._stream.subscribe_trades(self._on_trade, *added)
+            self._stream.subscribe_bars(self._on_bar, *added)
+            self._subscribed.update(added)
+            self._ensure_running()
+            return added
+
+    def unsubscribe(self, symbols: List[str]) -> List[str]:
+        """Unsubscribe symbols and drop their cached data. Returns the symbols that were removed."""
+        with self._lock:
+            removed = [s for s in dict.fromkeys(symbols) if s in self._subscribed]
+            if not removed:
+                return []
+            self._stream.unsubscribe_quotes(*removed)
+            self._stream.unsubscribe_trades(*removed)
+            self._stream.unsubscribe_bars(*removed)
+            for symbol in removed:
+                self._subscribed.discard(symbol)
+                self._quotes.pop(symbol, None)
+                self._trades.pop(symbol, None)
+                self._bars.pop(symbol, None)
+            return removed
+
+    @property
+    def subscribed(self) -> List[str]:
+        return sorted(self._subscribed)
+
+    def serves(self, feed: Optional[DataFeed] = None, currency: Optional[SupportedCurrencies] = None) -> bool:
+        """Whether cached stream data can stand in for a REST request with these parameters."""
+        return (feed is None or feed == self.feed) and (currency is None or currency == SupportedCurrencies.USD)
+
+    def get_quote(self, symbol: str):
+        """Latest streamed quote for a subscribed symbol, or None when missing or stale."""
+        return self._fresh(self._quotes.get(symbol.upper()))
+
+    def get_trade(self, symbol: str):
+        """Latest streamed trade for a subscribed symbol, or None when missing or stale."""
+        return self._fresh(self._trades.get(symbol.upper()))
+
+    def get_bar(self, symbol: str):
+        """Latest streamed minute bar for a subscribed symbol, or None when missing or stale."""
+        return self._fresh(self._bars.get(symbol.upper()))
+
+market_stream = MarketDataStreamManager(stock_data_stream_client, DataFeed(STREAM_DATA_FEED.lower()))
+memory_budget.register("market_stream", market_stream.memory_bytes)
+
+# ============================================================================
+# Order and Position Mirror
+# ============================================================================
+
+# Order statuses after which an order receives no further updates (QueryOrderStatus.CLOSED)
+CLOSED_ORDER_STATUSES = frozenset({"filled", "canceled", "expired", "rejected", "replaced"})
+# Orders kept in memory before the oldest closed ones are dropped
+ORDER_MIRROR_MAX_ORDERS = 2000
+# REST polling interval for wait_for_order_status while the trade stream is down
+ORDER_POLL_SECONDS = 1.0
+
+def _order_status(order) -> Optional[str]:
+    return None if order is None else _serialize_value(order.status)
+
+class OrderMirror:
+    """
+    In-memory mirror of orders and positions fed by the trade updates websocket.
+
+    The stream runs on a daemon thread, like the market data stream, and applies every
+    order event as it arrives. Open orders and positions are reconciled with REST every
+    reconcile_seconds. Fills only mark positions stale, because the stream carries no
+    prices; the next read reloads them. Until the first reconcile completes, and while
+    the stream is disconnected, readers fall back to REST.
+
+    Started lazily from the first tool call that needs it, so that it can bind to the
+    server's event loop for waking wait_for_order_status callers.
+    """
+
+    def __init__(self, stream, client, reconcile_seconds: float, enabled: bool = True):
+        self._stream = stream
+        self._client = client
+        self.reconcile_seconds = reconcile_seconds
+        self.enabled = enabled
+        self.last_error: Optional[str] = None
+        self.stats: Dict[str, int] = defaultdict(int)
+        self._lock = threading.Lock()
+        self._orders: Dict[str, Order] = {}
+        self._positions: Optional[Dict[str, Any]] = None
+        self._positions_synced = 0.0
+        self._fill_generation = 0
+        self._order_bytes = 0  # Sampled once: orders are uniform enough for a per-order estimate
+        self._orders_synced = 0.0
+        self._account = None
+        self._account_synced = 0.0
+        self._account_generation = -1
+        self._waiters: Dict[str, List[asyncio.Event]] = defaultdict(list)
+        self._loop: Optional[asyncio.AbstractEventLoop] = None
+        self._thread: Optional[threading.Thread] = None
+        self._reconciler: Optional[asyncio.Task] = None
+
+    async def ensure_started(self) -> None:
+        """Start the trade updates stream and the reconcile loop if they are not running."""
+        if not self.enabled:
+            return
+        self._loop = asyncio.get_running_loop()
+        if self._thread is None:
+            self._stream.subscribe_trade_updates(self._on_trade_update)
+        if self._thread is None or not self._thread.is_alive():
+            self._thread = threading.Thread(target=self._stream.run, name="alpaca-trade-updates", daemon=True)
+            self._thread.start()
+        if self._reconciler is None or self._reconciler.done():
+            self._reconciler = _background_task(self._reconcile_loop())
+
+    @property
+    def fill_generation(self) -> int:
+        """Count of fills seen, so caches of position-derived data can tell when to refresh."""
+        return self._fill_generation
+
+    @property
+    def live(self) -> bool:
+        """Whether the mirror is synced and the stream is connected, so reads can skip REST."""
+        return (
+            self._orders_synced > 0
+            and self._thread is not None and self._thread.is_alive()
+            and bool(getattr(self._stream, "_running", False))
+        )
+
+    async def _on_trade_update(self, update) -> None:
+        with self._lock:
+            self.stats["updates"] += 1
+            if _serialize_value(update.event) in ("fill", "partial_fill"):
+                self._fill_generation += 1
+                self._positions_synced = 0.0
+        self.record(update.order)
+
+    def record(self, order) -> None:
+        """
+        Apply an order snapshot unless the mirror already holds a newer one, and wake its waiters.
+
+        Past ORDER_MIRROR_MAX_ORDERS the oldest closed orders are dropped, with a tenth of the
+        limit as slack so that the sort is not repeated on every new order.
+        """
+        if not self.enabled:
+            return
+        order_id = str(order.id)
+        with self._lock:
+            current = self._orders.get(order_id)
+            if current is not None and current.updated_at and order.updated_at and order.updated_at < current.updated_at:
+                return
+            self._orders[order_id] = order
+            if len(self._orders) > ORDER_MIRROR_MAX_ORDERS:
+                self._drop_closed(len(self._orders) - ORDER_MIRROR_MAX_ORDERS + ORDER_MIRROR_MAX_ORDERS // 10)
+            if self._loop is not None:
+                for event in self._waiters.get(order_id, []):
+                    self._loop.call_soon_threadsafe(event.set)
+
+    async def _reconcile_loop(self) -> None:
+        while True:
+            try:
+                await self.reconcile()
+                self.last_error = None
+            except Exception as e:
+                with self._lock:
+                    self.stats["reconcile_errors"] += 1
+                self.last_error = str(e)
+            await asyncio.sleep(self.reconcile_seconds)
+
+    async def reconcile(self) -> None:
+        """Reload open orders and positions from REST, catching up on anything the stream missed."""
+        orders = await _call_api(self._client.get_orders, GetOrdersRequest(status=QueryOrderStatus.OPEN, limit=500))
+        open_ids = {str(order.id) for order in orders}
+        for order in orders:
+            self.record(order)
+        # Orders still open in the mirror but no longer listed closed while the stream was down
+        with self._lock:
+            missing = [order_id for order_id, order in self._orders.items()
+                       if order_id not in open_ids and _order_status(order) not in CLOSED_ORDER_STATUSES]
+        for order_id in missing:
+            self.record(await _call_api(self._client.get_order_by_id, order_id))
+        await self.refresh_positions()
+        with self._lock:
+            self._orders_synced = time.monotonic()
+            self.stats["reconciles"] += 1
+
+    def _drop_closed(self, count: int) -> int:
+        """Forget up to count closed orders, least recently updated first. Call with the lock held."""
+        closed = sorted(
+            (order for order in self._orders.values() if _order_status(order) in CLOSED_ORDER_STATUSES),
+            key=lambda order: order.updated_at or datetime.min.replace(tzinfo=timezone.utc)
+        )
+        for order in closed[:count]:
+            self._orders.pop(str(order.id), None)
+        return min(count, len(closed))
+
+    def memory_bytes(self) -> int:
+        """Approximate size of the mirrored orders and positions."""
+        with self._lock:
+            if not self._order_bytes and self._orders:
+                self._order_bytes = _approx_size(next(iter(self._orders.values()))) + 100
+            return len(self._orders) * self._order_bytes + _approx_size(self._positions)
+
+    def evict(self, target: int) -> int:
+        """Forget closed orders to free about target bytes; open orders and positions stay."""
+        if not self._order_bytes:
+            return 0
+        with self._lock:
+            return self._drop_closed(-(-target // self._order_bytes)) * self._order_bytes
+
+    async def refresh_positions(self) -> List[Any]:
+        """Reload positions from REST and return them."""
+        generation = self._fill_generation
+        positions = await _call_api(self._client.get_all_positions)
+        with self._lock:
+            self._positions = {position.symbol: position for position in positions}
+            # A fill that arrived during the request leaves the snapshot stale
+            if generation == self._fill_generation:
+                self._positions_synced = time.monotonic()
+        return positions
+
+    def _positions_fresh(self) -> bool:
+        return (self.live and self._positions is not None
+                and time.monotonic() - self._positions_synced < self.reconcile_seconds)
+
+    async def get_positions(self) -> List[Any]:
+        """All open positions, from memory when the mirror is fresh."""
+        await self.ensure_started()
+        with self._lock:
+            if self._positions_fresh():
+                self.stats["position_hits"] += 1
+                return list(self._positions.values())
+        return await self.refresh_positions()
+
+    async def get_position(self, symbol: str):
+        """
+        The open position for a symbol, from memory when the mirror is fresh.
+
+        Returns None when the mirror is fresh and holds no such position; otherwise
+        falls back to REST, which raises for unknown positions.
+        """
+        await self.ensure_started()
+        with self._lock:
+            if self._positions_fresh():
+                self.stats["position_hits"] += 1
+                return self._positions.get(symbol.upper())
+        return await _call_api(self._client.get_open_position, symbol)
+
+    async def get_account(self, max_age: float):
+        """The account, from memory when fetched within max_age seconds and no fill arrived since."""
+        await self.ensure_started()
+        with self._lock:
+            if (self._account is not None and self._account_generation == self._fill_generation
+                    and time.monotonic() - self._account_synced < max_age):
+                self.stats["account_hits"] += 1
+                return self._account
+            generation = self._fill_generation
+        account = await _call_api(self._client.get_account)
+        with self._lock:
+            self._account, self._account_synced, self._account_generation = account, time.monotonic(), generation
+        return account
+
+    async def get_open_orders(self) -> Optional[List[Order]]:
+        """Open orders, newest first, or None when the mirror cannot answer without REST."""
+        await self.ensure_started()
+        if not self.live:
+            return None
+        with self._lock:
+            self.stats["order_hits"] += 1
+            orders = [order for order in self._orders.values() if _order_status(order) not in CLOSED_ORDER_STATUSES]
+        return sorted(orders, key=lambda order: order.submitted_at or datetime.min.replace(tzinfo=timezone.utc), reverse=True)
+
+    async def wait_for_status(self, order_id: str, statuses: set, timeout: float):
+        """
+        Wait until an order reaches one of statuses or closes, or until the timeout.
+
+        Woken by stream updates; polls REST instead while the stream is down.
+
+        Returns:
+            The latest known order
+        """
+        await self.ensure_started()
+        order_id = str(order_id)
+        loop = asyncio.get_running_loop()
+        deadline = loop.time() + timeout
+        event = asyncio.Event()
+        with self._lock:
+            self._waiters[order_id].append(event)
+            order = self._orders.get(order_id)
+        try:
+            if order is None:
+                order = await _call_api(self._client.get_order_by_id, order_id)
+                self.record(order)
+            while True:
+                event.clear()
+                with self._lock:
+                    order = self._orders.get(order_id, order)
+                status = _order_status(order)
+                remaining = deadline - loop.time()
+                if status in statuses or status in CLOSED_ORDER_STATUSES or remaining <= 0:
+                    return order
+                live = self.live
+                try:
+                    await asyncio.wait_for(event.wait(), remaining if live else min(remaining, ORDER_POLL_SECONDS))
+                except asyncio.TimeoutError:
+                    if not live:
+                        order = await _call_api(self._client.get_order_by_id, order_id)
+                        self.record(order)
+        finally:
+            with self._lock:
+                waiters = self._waiters[order_id]
+                waiters.remove(event)
+                if not waiters:
+                    del self._waiters[order_id]
+
+# ============================================================================
+# Accounts
+# ============================================================================
+
+# Name of the account configured by ALPACA_API_KEY/ALPACA_SECRET_KEY, used when a tool gets no account
+DEFAULT_ACCOUNT = "default"
+
+class TradingAccount:
+    """
+    One Alpaca account: its trading client (and with it its own rate limit bucket, which is
+    keyed by API key), trade updates stream and order mirror. Market data clients, streams,
+    caches and the bar store are shared by every account.
+    """
+
+    __slots__ = ("name", "paper", "client", "stream", "mirror")
+
+    def __init__(self, name: str, api_key: str, secret_key: str, paper: bool, client=None, stream=None):
+        self.name = name
+        self.paper = paper
+        self.client = client or _LazyClient(f"trade_client[{name}]", lambda: _rest_client(
+            TradingClientSigned(api_key, secret_key, paper=paper, url_override=TRADE_API_URL)))
+        self.stream = stream or _LazyClient(f"trade_stream_client[{name}]", lambda: TradingStream(
+            api_key, secret_key, paper=paper, url_override=TRDE_API_WSS))
+        self.mirror = OrderMirror(self.stream, self.client, MCP_MIRROR_RECONCILE_SECONDS, enabled=MCP_ORDER_MIRROR)
+        memory_budget.register(f"order_mirror[{name}]", self.mirror.memory_bytes, self.mirror.evict, priority=40)
+
+def _load_accounts() -> Dict[str, TradingAccount]:
+    """The default account plus every account named in MCP_ACCOUNTS, keyed by lower-case name."""
+    registry = {DEFAULT_ACCOUNT: TradingAccount(DEFAULT_ACCOUNT, TRADE_API_KEY, TRADE_API_SECRET, ALPACA_PAPER_TRADE,
+                                                default_trade_client, trade_stream_client)}
+    for name in MCP_ACCOUNTS.split(","):
+        name = name.strip().lower()
+        if not name or name in registry:
+            continue
+        api_key = os.getenv(f"ALPACA_API_KEY_{name.upper()}")
+        secret_key = os.getenv(f"ALPACA_SECRET_KEY_{name.upper()}")
+        if not api_key or not secret_key:
+            raise ValueError(f"Account '{name}' in MCP_ACCOUNTS needs ALPACA_API_KEY_{name.upper()} "
+                             f"and ALPACA_SECRET_KEY_{name.upper()}.")
+        paper = os.getenv(f"ALPACA_PAPER_TRADE_{name.upper()}")
+        paper = ALPACA_PAPER_TRADE if paper is None else paper.lower() in ("1", "true", "yes")
+        registry[name] = TradingAccount(name, api_key, secret_key, paper)
+    return registry
+
+accounts = _load_accounts()
+# Set for the duration of each tool call that takes an account argument (see _instrument_tool);
+# tasks the tool spawns copy the context and so stay on the same account
+_account_var: contextvars.ContextVar = contextvars.ContextVar("account", default=None)
+
+def _current_account() -> TradingAccount:
+    return _account_var.get() or accounts[DEFAULT_ACCOUNT]
+
+def _find_account(name: Optional[str]) -> Optional[TradingAccount]:
+    return accounts.get((name or DEFAULT_ACCOUNT).strip().lower())
+
+# The current tool call's account's mirror; accounts[...].mirror addresses a specific one
+order_mirror = _AccountBound("mirror")
+
+# ============================================================================
+# Response Cache
+# ============================================================================
+
+def _parse_cache_ttls(spec: str) -> Dict[str, float]:
+    """Parse a 'name=seconds,name=seconds' override string into a TTL mapping."""
+    ttls = {}
+    for item in filter(None, (part.strip() for part in spec.split(","))):
+        name, _, seconds = item.partition("=")
+        try:
+            ttls[name.strip()] = float(seconds)
+        except ValueError:
+            continue
+    return ttls
+
+# The clock's timestamp is reported as the current time, so it is only reused briefly
+CLOCK_CACHE_SECONDS = 5.0
+
+def _clock_ttl(clock) -> float:
+    """Cache the market clock for CLOCK_CACHE_SECONDS, but never past its next open/close transition."""
+    transition = clock.next_close if clock.is_open else clock.next_open
+    return max(1.0, min(CLOCK_CACHE_SECONDS, (transition - clock.timestamp).total_seconds()))
+
+# Per-tool cache lifetimes in seconds. A callable derives the TTL from the response.
+# Override with MCP_CACHE_TTLS, e.g. "get_stock_snapshot=2,get_asset_info=600" (0 disables).
+CACHE_TTLS: Dict[str, Any] = {
+    "get_market_clock": _clock_ttl,
+    "get_market_calendar": 86400,
+    "get_asset_info": 3600,
+    "get_option_contracts": 900,
+    "get_stock_snapshot": 1,
+    "get_option_chain_contracts": 3600,
+    "asset_universe": 86400,
+}
+CACHE_TTLS.update(_parse_cache_ttls(os.getenv("MCP_CACHE_TTLS", "")))
+
+# Request fields naming symbols. Their values are upper-cased and symbol lists sorted, so
+# equivalent calls share a key; every other argument (ids, tokens, formats) is kept exactly.
+CACHE_SYMBOL_FIELDS = frozenset({"symbol", "symbols", "symbol_or_symbols", "underlying_symbol", "underlying_symbols"})
+
+def _normalize_cache_arg(value: Any, symbol: bool = False) -> Any:
+    """Reduce an argument to a JSON-friendly form so equivalent calls share a key."""
+    if value is None or isinstance(value, (bool, int, float)):
+        return value
+    if isinstance(value, str):
+        return value.strip().upper() if symbol else value
+    if hasattr(value, "value") and not callable(value.value):  # Enums
+        return _normalize_cache_arg(value.value, symbol)
+    if isinstance(value, (list, tuple, set)):
+        items = [_normalize_cache_arg(v, symbol) for v in value]
+        return sorted(items, key=str) if symbol or isinstance(value, set) else items
+    if isinstance(value, dict):
+        return {str(k): _normalize_cache_arg(v, str(k) in CACHE_SYMBOL_FIELDS)
+                for k, v in value.items() if v is not None}
+    if hasattr(value, "to_request_fields"):  # alpaca-py request models
+        return _normalize_cache_arg(value.to_request_fields())
+    return str(value)
+
+class ResponseCache:
+    """
+    TTL cache for read-only upstream responses, keyed by tool name plus
+    normalized arguments, with single-flight deduplication: concurrent
+    identical requests share one in-flight upstream call.
+
+    Cached values are the raw SDK responses, so tools keep formatting them
+    per call. Entries are kept in least-recently-used order with their
+    approximate size, so the memory budget can shed the coldest ones first.
+    """
+
+    _SWEEP_THRESHOLD = 1024
+
+    def __init__(self, ttls: Dict[str, Any]):
+        self.ttls = ttls
+        # key -> (expires, value, approximate bytes), least recently used first
+        self._entries: "OrderedDict[str, tuple]" = OrderedDict()
+        self.bytes = 0
+        self._inflight: Dict[str, asyncio.Task] = {}
+        self.hits: Dict[str, int] = defaultdict(int)
+        self.misses: Dict[str, int] = defaultdict(int)
+        self.coalesced: Dict[str, int] = defaultdict(int)
+
+    @staticmethod
+    def make_key(name: str, args: tuple, kwargs: dict) -> str:
+        return name + ":" + json.dumps(
+            [_normalize_cache_arg(list(args)), _normalize_cache_arg(kwargs)],
+            sort_keys=True, default=str
+        )
+
+    async def get_or_fetch(self, name: str, key: str, fetch):
+        """Return a fresh cached value for key, or await fetch() exactly once across concurrent callers."""
+        timing = _call_timing.get()
+        entry = self._entries.get(key)
+        if entry is not None and entry[0] > time.monotonic():
+            self._entries.move_to_end(key)
+            self.hits[name] += 1
+            if timing is not None:
+                timing.cache_hits += 1
+            return entry[1]
+
+        inflight = self._inflight.get(key)
+        if inflight is not None:
+            self.coalesced[name] += 1
+            if timing is None:
+                return await asyncio.shield(inflight)
+            timing.cache_hits += 1
+            start = time.perf_counter()
+            try:
+                return await asyncio.shield(inflight)
+            finally:
+                timing.upstream += time.perf_counter() - start
+
+        self.misses[name] += 1
+        # The fetch runs in its own task that every caller shields, so a cancelled first
+        # caller (client disconnect, session timeout) neither cancels the callers sharing
+        # it nor wastes the upstream call
+        task = asyncio.ensure_future(self._fetch(name, key, fetch))
+        task.add_done_callback(lambda t: t.cancelled() or t.exception())  # Retrieved even if nobody waits
+        self._inflight[key] = task
+        return await asyncio.shield(task)
+
+    async def _fetch(self, name: str, key: str, fetch):
+        try:
+            value = await fetch()
+        finally:
+            self._inflight.pop(key, None)
+
+        ttl = self.ttls.get(name, 0)
+        ttl = ttl(value) if callable(ttl) else ttl
+        if ttl > 0:
+            if len(self._entries) >= self._SWEEP_THRESHOLD:
+                self._sweep()
+            self._remove(key)
+            size = _approx_size(value) + len(key)
+            self._entries[key] = (time.monotonic() + ttl, value, size)
+            self.bytes += size
+        return value
+
+    def _remove(self, key: str) -> int:
+        entry = self._entries.pop(key, None)
+        if entry is None:
+            return 0
+        self.bytes -= entry[2]
+        return entry[2]
+
+    def invalidate(self, name: Optional[str] = None) -> None:
+        """Drop cached entries for one tool, or all entries when name is None."""
+        if name is None:
+            self._entries.clear()
+            self.bytes = 0
+        else:
+            for key in [k for k in self._entries if k.startswith(name + ":")]:
+                self._remove(key)
+
+    def _sweep(self) -> int:
+        now = time.monotonic()
+        return sum(self._remove(k) for k in [k for k, entry in self._entries.items() if entry[0] <= now])
+
+    def evict(self, target: int) -> int:
+        """Free about target bytes: expired entries first, then least recently used ones."""
+        freed = self._sweep()
+        while freed < target and self._entries:
+            freed += self._remove(next(iter(self._entries)))
+        return freed
+
+    def stats(self) -> Dict[str, Dict[str, int]]:
+        names = sorted(set(self.hits) | set(self.misses) | set(self.coalesced))
+        return {
+            name: {"hits": self.hits[name], "misses": self.misses[name], "coalesced": self.coalesced[name]}
+            for name in names
+        }
+
+response_cache = ResponseCache(CACHE_TTLS)
+memory_budget.register("response_cache", lambda: response_cache.bytes, response_cache.evict, priority=10)
+
+async def _cached_api(name: str, func, *args, **kwargs):
+    """
+    Call an SDK method through the response cache.
+
+    Args:
+        name: Cache namespace, normally the calling tool's name (selects the TTL)
+        func: Bound SDK method to call on a miss
+        *args: Positional arguments forwarded to the method
+        **kwargs: Keyword arguments forwarded to the method
+
+    Returns:
+        The cached or freshly fetched SDK response.
+    """
+    key = ResponseCache.make_key(name, args, kwargs)
+    return await response_cache.get_or_fetch(name, key, lambda: _call_api(func, *args, **kwargs))
+
+# ============================================================================
+# Paginated Responses
+# ============================================================================
+
+# Maximum page size accepted by the market data API
+DATA_API_PAGE_LIMIT = 10000
+
+class ResponseWriter:
+    """
+    Builds a tool response from a list of parts joined once at the end, and
+    enforces a row and byte budget so large result sets stop at a bounded size.
+    The first row is always written, however small the budget, so a response that
+    issues a continuation cursor has always advanced past at least one row.
+    """
+
+    def __init__(self, max_rows: Optional[int] = None, max_bytes: Optional[int] = None):
+        self.max_rows = max_rows
+        self.max_bytes = max_bytes
+        self.rows = 0
+        self.bytes = 0
+        self._parts: List[str] = []
+
+    def write(self, text: str) -> None:
+        """Append framing text (headers, footers) that does not count as a row."""
+        self._parts.append(text)
+        self.bytes += len(text)
+
+    def add_row(self, text: str) -> bool:
+        """Append a row if it fits the budget. Returns False, without writing, once the budget is spent."""
+        if self.full or (self.max_bytes is not None and self.rows and self.bytes + len(text) > self.max_bytes):
+            return False  # full and the byte check both pass while no row has been written
+        self._parts.append(text)
+        self.rows += 1
+        self.bytes += len(text)
+        return True
+
+    @property
+    def full(self) -> bool:
+        return self.rows > 0 and (
+            (self.max_rows is not None and self.rows >= self.max_rows) or
+            (self.max_bytes is not None and self.bytes >= self.max_bytes)
+        )
+
+    @property
+    def rows_left(self) -> int:
+        if self.max_rows is None:
+            return DATA_API_PAGE_LIMIT
+        return max(0 if self.rows else 1, self.max_rows - self.rows)
+
+    def getvalue(self) -> str:
+        return "".join(self._parts)
+
+def _encode_cursor(state: Dict[str, Any]) -> str:
+    """Encode pagination state into an opaque continuation cursor."""
+    return base64.urlsafe_b64encode(json.dumps(state, separators=(",", ":")).encode()).decode().rstrip("=")
+
+def _query_digest(query: Dict[str, Any]) -> str:
+    """Fingerprint of the arguments a cursor was issued for, normalized like cache keys."""
+    text = json.dumps(_normalize_cache_arg(query), sort_keys=True, default=str)
+    return hashlib.sha256(text.encode()).hexdigest()[:16]
+
+def _decode_cursor(cursor: str, query: Dict[str, Any], required: tuple = ("start", "end"),
+                   kind: Optional[str] = None) -> Dict[str, Any]:
+    """
+    Decode a continuation cursor produced by _encode_cursor for the given query arguments.
+
+    Raises:
+        ValueError: If the cursor is malformed, was issued by another tool (when kind is
+            given) or for different arguments
+    """
+    try:
+        padded = cursor + "=" * (-len(cursor) % 4)
+        state = json.loads(base64.urlsafe_b64decode(padded.encode()).decode())
+    except Exception:
+        raise ValueError(f"Invalid page_token '{cursor}'")
+    if not isinstance(state, dict) or any(key not in state for key in required):
+        raise ValueError(f"Invalid page_token '{cursor}'")
+    if kind is not None and state["kind"] != kind:
+        raise ValueError(f"page_token was issued by a different tool ({state['kind']}), not {kind}.")
+    if state.get("query") != _query_digest(query):
+        raise ValueError("page_token was issued for different arguments. Repeat the request with the "
+                         "arguments it was issued for, or without page_token.")
+    return state
+
+def _resume_listing(page_token: Optional[str], kind: str, query: Dict[str, Any]) -> Dict[str, Any]:
+    """
+    State of a listing cursor, or an empty dict without one.
+
+    Listing tools (assets, orders, announcements, option contracts) answer from one
+    upstream result, so their cursors only record where in it the response stopped,
+    and the query arguments that result came from.
+
+    Raises:
+        ValueError: If the cursor is malformed, was issued by another tool or for other arguments
+    """
+    if not page_token:
+        return {}
+    return _decode_cursor(page_token, query, required=("kind",), kind=kind)
+
+def _listing_cursor(kind: str, query: Dict[str, Any], **position) -> str:
+    """Cursor resuming a listing at position, only valid with the same query arguments."""
+    return _encode_cursor({"kind": kind, "query": _query_digest(query), **position})
+
+def _listing_summary(writer: ResponseWriter, offset: int, total: int, noun: str,
+                     breakdowns: Dict[str, Counter], next_cursor: Optional[str]) -> None:
+    """
+    Append the footer of a listing the response budget cut short: which rows were shown,
+    breakdowns of the complete result, and the cursor for the rest.
+    """
+    writer.write(f"\nShowing {noun} {offset + 1:,}-{offset + writer.rows:,} of {total:,}.\n")
+    for label, counts in breakdowns.items():
+        top = ", ".join(f"{key} {count:,}" for key, count in counts.most_common(8))
+        more = f" and {len(counts) - 8} more" if len(counts) > 8 else ""
+        writer.write(f"All {total:,} by {label}: {top}{more}\n")
+    if next_cursor:
+        writer.write(f"More data available - call again with page_token='{next_cursor}'\n")
+
+def _to_rfc3339(value: datetime) -> str:
+    """Serialize a datetime for the data API, treating naive values as UTC like alpaca-py does."""
+    if value.tzinfo is None:
+        value = value.replace(tzinfo=timezone.utc)
+    return value.isoformat()
+
+def _fetch_data_page(client, path: str, key: str, symbol: str, params: Dict[str, Any]) -> tuple:
+    """
+    Fetch one raw page from a multi-symbol market data endpoint.
+
+    Args:
+        client: Historical data client used to issue the request
+        path: Endpoint path (e.g., '/stocks/bars')
+        key: Response field holding the per-symbol rows (e.g., 'bars')
+        symbol: Symbol whose rows should be returned
+        params: Query parameters including any page_token
+
+    Returns:
+        tuple: (raw rows for the symbol, next page token or None)
+    """
+    query = {k: v for k, v in params.items() if v is not None}
+    response = client.get(path, query) or {}
+    rows = (response.get(key) or {}).get(symbol) or []
+    return rows, response.get("next_page_token")
+
+async def _paginate_rows(
+    writer: ResponseWriter,
+    fetch_page,
+    render_row,
+    state: Dict[str, Any],
+    local: bool = False
+) -> Optional[str]:
+    """
+    Stream pages into writer until the data, the caller's total limit or the response budget runs out.
+
+    Args:
+        writer: Response writer that enforces the row and byte budget
+        fetch_page: Blocking callable (page_token, limit) -> (rows, next_page_token)
+        render_row: Callable converting a raw row into a response line
+        state: Cursor state with 'token' (upstream page token), 'offset' (rows of that
+            page already returned) and 'remaining' (rows left under the caller's limit, or None)
+        local: fetch_page reads local storage, so it skips the upstream rate limit scheduler
+
+    Returns:
+        Optional[str]: Continuation cursor when more rows are available, otherwise None
+    """
+    token = state.get("token")
+    offset = state.get("offset", 0)
+    remaining = state.get("remaining")
+    while True:
+        if remaining == 0:
+            return None
+        if writer.full:
+            return _encode_cursor({**state, "token": token, "offset": offset, "remaining": remaining})
+        wanted = writer.rows_left if remaining is None else min(writer.rows_left, remaining)
+        page_limit = min(DATA_API_PAGE_LIMIT, offset + wanted)
+        rows, next_token = await (_run_blocking if local else _call_api)(fetch_page, token, page_limit)
+        for row in rows[offset:]:
+            if not writer.add_row(render_row(row)):
+                return _encode_cursor({**state, "token": token, "offset": offset, "remaining": remaining})
+            offset += 1
+            if remaining is not None:
+                remaining -= 1
+                if remaining == 0:
+                    return None
+        if next_token is None:
+            return None
+        token, offset = next_token, 0
+
+# ============================================================================
+# Local Bar Store
+# ============================================================================
+
+# Seconds per timeframe unit, used to decide which recent bars may still change
+_TIMEFRAME_UNIT_SECONDS = {
+    TimeFrameUnit.Minute: 60,
+    TimeFrameUnit.Hour: 3600,
+    TimeFrameUnit.Day: 86400,
+    TimeFrameUnit.Week: 7 * 86400,
+    TimeFrameUnit.Month: 31 * 86400,
+}
+
+def _epoch_seconds(value: datetime) -> int:
+    """Convert a datetime to UTC epoch seconds, treating naive values as UTC."""
+    if value.tzinfo is None:
+        value = value.replace(tzinfo=timezone.utc)
+    return int(value.timestamp())
+
+# SQLite page cache of the bar store connection, set explicitly so the memory budget can
+# account for it (SQLite's own default is about 2 MiB)
+BAR_STORE_CACHE_KIB = 8192
+
+class BarStore:
+    """
+    Persistent SQLite store of historical bars, partitioned by symbol and timeframe.
+
+    Alongside the bars it records which time ranges have already been fetched, so a
+    request only downloads the gaps and the still-forming tail. Rows are kept in the
+    data API's raw field names, so stored and freshly fetched bars render identically.
+    """
+
+    def __init__(self, path: str):
+        self.path = path
+        self._lock = threading.Lock()
+        self._connection: Optional[sqlite3.Connection] = None
+
+    @property
+    def _conn(self) -> sqlite3.Connection:
+        # Opened on first use, under self._lock, so that startup does not touch the disk
+        if self._connection is None:
+            self._connection = self._open()
+        return self._connection
+
+    def _open(self) -> sqlite3.Connection:
+        directory = os.path.dirname(self.path)
+        if directory:
+            os.makedirs(directory, exist_ok=True)
+        conn = sqlite3.connect(self.path, check_same_thread=False)
+        with conn:
+            conn.execute("PRAGMA journal_mode=WAL")
+            conn.execute(f"PRAGMA cache_size=-{BAR_STORE_CACHE_KIB}")
+            conn.execute("""
+                CREATE TABLE IF NOT EXISTS bars (
+                    symbol TEXT NOT NULL, timeframe TEXT NOT NULL, ts INTEGER NOT NULL,
+                    o REAL, h REAL, l REAL, c REAL, v REAL, n REAL, vw REAL,
+                    PRIMARY KEY (symbol, timeframe, ts)
+                ) WITHOUT ROWID
+            """)
+            conn.execute("""
+                CREATE TABLE IF NOT EXISTS coverage (
+                    symbol TEXT NOT NULL, timeframe TEXT NOT NULL, start INTEGER NOT NULL, end INTEGER NOT NULL
+                )
+            """)
+            conn.execute("CREATE INDEX IF NOT EXISTS coverage_key ON coverage (symbol, timeframe, start)")
+        return conn
+
+    def missing_ranges(self, symbol: str, timeframe: str, start: int, end: int) -> List[tuple]:
+        """Return the sub-ranges of [start, end] (epoch seconds) not yet fetched."""
+        with self._lock:
+            covered = self._conn.execute(
+                "SELECT start, end FROM coverage WHERE symbol = ? AND timeframe = ? AND end >= ? AND start <= ? ORDER BY start",
+                (symbol, timeframe, start, end)
+            ).fetchall()
+        gaps = []
+        cursor = start
+        for covered_start, covered_end in covered:
+            if covered_start > cursor:
+                gaps.append((cursor, covered_start))
+            cursor = max(cursor, covered_end)
+        if cursor < end:
+            gaps.append((cursor, end))
+        return gaps
+
+    def insert(self, symbol: str, timeframe: str, rows: List[Dict[str, Any]], covered: Optional[tuple]) -> None:
+        """Upsert raw bar rows and record [start, end] as fetched, merging overlapping ranges."""
+        records = [
+            (symbol, timeframe, _epoch_seconds(datetime.fromisoformat(r["t"])),
+             r.get("o"), r.get("h"), r.get("l"), r.get("c"), r.get("v"), r.get("n"), r.get("vw"))
+            for r in rows
+        ]
+        with self._lock, self._conn:
+            self._conn.executemany("INSERT OR REPLACE INTO bars VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?)", records)
+            if covered is None:
+                return
+            start, end = covered
+            overlapping = self._conn.execute(
+                "SELECT rowid, start, end FROM coverage WHERE symbol = ? AND timeframe = ? AND end >= ? AND start <= ?",
+                (symbol, timeframe, start, end)
+            ).fetchall()
+            for rowid, other_start, other_end in overlapping:
+                start, end = min(start, other_start), max(end, other_end)
+                self._conn.execute("DELETE FROM coverage WHERE rowid = ?", (rowid,))
+            self._conn.execute("INSERT INTO coverage VALUES (?, ?, ?, ?)", (symbol, timeframe, start, end))
+
+    def read(self, symbol: str, timeframe: str, start: int, end: int,
+             offset: int = 0, limit: Optional[int] = None) -> List[Dict[str, Any]]:
+        """Read stored bars in [start, end] as raw data API rows, oldest first."""
+        with self._lock:
+            rows = self._conn.execute(
+                "SELECT ts, o, h, l, c, v, n, vw FROM bars WHERE symbol = ? AND timeframe = ? AND ts >= ? AND ts <= ? "
+                "ORDER BY ts LIMIT ? OFFSET ?",
+                (symbol, timeframe, start, end, -1 if limit is None else limit, offset)
+            ).fetchall()
+        return [
+            {"t": datetime.fromtimestamp(ts, timezone.utc).strftime("%Y-%m-%dT%H:%M:%SZ"),
+             "o": o, "h": h, "l": l, "c": c, "v": v, "n": n, "vw": vw}
+            for ts, o, h, l, c, v, n, vw in rows
+        ]
+
+    def read_columns(self, symbol: str, timeframe: str, start: int, end: int) -> List[tuple]:
+        """Read stored bars in [start, end] as (ts, o, h, l, c, v, vw) tuples, oldest first."""
+        with self._lock:
+            return self._conn.execute(
+                "SELECT ts, o, h, l, c, v, vw FROM bars WHERE symbol = ? AND timeframe = ? AND ts >= ? AND ts <= ? ORDER BY ts",
+                (symbol, timeframe, start, end)
+            ).fetchall()
+
+bar_store = BarStore(MCP_BAR_STORE_PATH) if MCP_BAR_STORE_PATH else None
+if bar_store is not None:
+    # The page cache's ceiling once the store is open; SQLite fills it as pages are read
+    memory_budget.register("bar_store", lambda: BAR_STORE_CACHE_KIB * 1024 if bar_store._connection else 0)
+_bar_store_locks: Dict[tuple, asyncio.Lock] = defaultdict(asyncio.Lock)
+
+async def _fetch_bar_range(symbol: str, timeframe: TimeFrame, start: int, end: int) -> List[Dict[str, Any]]:
+    """Download every raw bar for a symbol in [start, end] (epoch seconds), following page tokens."""
+    rows = []
+    token = None
+    while True:
+        page, token = await _call_api(_fetch_data_page, stock_historical_data_client, "/stocks/bars", "bars", symbol, {
+            "symbols": symbol,
+            "timeframe": timeframe.value,
+            "start": datetime.fromtimestamp(start, timezone.utc).isoformat(),
+            "end": datetime.fromtimestamp(end, timezone.utc).isoformat(),
+            "limit": DATA_API_PAGE_LIMIT,
+            "page_token": token,
+        })
+        rows.extend(page)
+        if token is None:
+            return rows
+
+async def _ensure_bars_stored(symbol: str, timeframe: TimeFrame, start_time: datetime, end_time: datetime) -> tuple:
+    """
+    Make sure the bar store holds every bar for the range, fetching only what is missing.
+
+    Bars newer than one bar interval may still be forming, so that tail is stored but not
+    marked as covered and is refreshed on the next request.
+
+    Returns:
+        tuple: (start, end) of the range in epoch seconds
+    """
+    start, end = _epoch_seconds(start_time), _epoch_seconds(end_time)
+    settled = int(time.time()) - timeframe.amount * _TIMEFRAME_UNIT_SECONDS[timeframe.unit_value]
+    async with _bar_store_locks[(symbol, timeframe.value)]:
+        gaps = await _run_blocking(bar_store.missing_ranges, symbol, timeframe.value, start, end)
+        for gap_start, gap_end in gaps:
+            rows = await _fetch_bar_range(symbol, timeframe, gap_start, gap_end)
+            covered = (gap_start, min(gap_end, settled)) if gap_start < settled else None
+            await _run_blocking(bar_store.insert, symbol, timeframe.value, rows, covered)
+    return start, end
+
+# ============================================================================
+# Output Formats
+# ============================================================================
+
+# Tools accept format="text" (prose, the default), "json" (columnar: a column list plus
+# row arrays) or "csv" (header row plus one line per record). The machine-readable
+# formats carry no indentation, which cuts payload size several-fold for large tables.
+OUTPUT_FORMATS = ("text", "json", "csv")
+MCP_OUTPUT_FORMAT = os.getenv("MCP_OUTPUT_FORMAT", "text").lower()
+
+BAR_COLUMNS = ["timestamp", "open", "high", "low", "close", "volume", "trade_count", "vwap"]
+QUOTE_COLUMNS = ["timestamp", "bid_price", "bid_size", "ask_price", "ask_size"]
+TRADE_COLUMNS = ["timestamp", "price", "size", "exchange", "id", "conditions"]
+
+def _resolve_format(format: Optional[str]) -> str:
+    """Return the effective output format for a call, falling back to MCP_OUTPUT_FORMAT."""
+    fmt = (format or MCP_OUTPUT_FORMAT).lower()
+    if fmt not in OUTPUT_FORMATS:
+        raise ValueError(f"Invalid format '{format}'. Must be one of: {', '.join(OUTPUT_FORMATS)}")
+    return fmt
+
+def _serialize_value(value: Any) -> Any:
+    """Convert SDK field values (datetimes, enums, UUIDs, numeric strings) into JSON-friendly scalars."""
+    if value is None or isinstance(value, (bool, int, float)):
+        return value
+    if isinstance(value, (datetime, date)):
+        return value.isoformat()
+    if isinstance(value, enum.Enum):
+        return value.value
+    if isinstance(value, (list, tuple)):
+        return [_serialize_value(v) for v in value]
+    if isinstance(value, str):
+        return value
+    return str(value)
+
+def _serialize_record(obj: Any, columns: List[str]) -> List[Any]:
+    """Project an SDK model onto a list of column values."""
+    if obj is None:
+        return [None] * len(columns)
+    return [_serialize_value(getattr(obj, column, None)) for column in columns]
+
+def _serialize_bar(bar) -> List[Any]:
+    return _serialize_record(bar, BAR_COLUMNS)
+
+def _serialize_quote(quote) -> List[Any]:
+    return _serialize_record(quote, QUOTE_COLUMNS)
+
+def _serialize_trade(trade) -> List[Any]:
+    return _serialize_record(trade, TRADE_COLUMNS)
+
+def _to_float(value: Any) -> Optional[float]:
+    """Parse the numeric strings used by trading API models, keeping None."""
+    return None if value is None or value == "" else float(value)
+
+POSITION_COLUMNS = ["symbol", "qty", "side", "asset_class", "market_value", "avg_entry_price",
+                    "current_price", "unrealized_pl", "unrealized_plpc", "unrealized_intraday_pl"]
+
+def _serialize_position(position) -> List[Any]:
+    return [
+        position.symbol, _to_float(position.qty), _serialize_value(position.side),
+        _serialize_value(position.asset_class), _to_float(position.market_value),
+        _to_float(position.avg_entry_price), _to_float(position.current_price),
+        _to_float(position.unrealized_pl), _to_float(position.unrealized_plpc),
+        _to_float(getattr(position, "unrealized_intraday_pl", None)),
+    ]
+
+STOCK_SNAPSHOT_COLUMNS = ["symbol", "bid_price", "bid_size", "ask_price", "ask_size", "last_price", "last_size",
+                          "last_time", "minute_close", "minute_volume", "daily_open", "daily_high", "daily_low",
+                          "daily_close", "daily_volume", "prev_close", "prev_volume"]
+
+def _serialize_stock_snapshot(symbol: str, snapshot) -> List[Any]:
+    quote = _serialize_record(snapshot.latest_quote, ["bid_price", "bid_size", "ask_price", "ask_size"])
+    trade = _serialize_record(snapshot.latest_trade, ["price", "size", "timestamp"])
+    minute = _serialize_record(snapshot.minute_bar, ["close", "volume"])
+    daily = _serialize_record(snapshot.daily_bar, ["open", "high", "low", "close", "volume"])
+    previous = _serialize_record(snapshot.previous_daily_bar, ["close", "volume"])
+    return [symbol] + quote + trade + minute + daily + previous
+
+OPTION_CONTRACT_COLUMNS = ["symbol", "type", "strike_price", "expiration_date", "status", "root_symbol",
+                           "underlying_symbol", "style", "size", "tradable", "open_interest",
+                           "close_price", "close_price_date"]
+
+def _serialize_option_contract(contract) -> List[Any]:
+    values = _serialize_record(contract, OPTION_CONTRACT_COLUMNS)
+    for column in ("strike_price", "size", "open_interest", "close_price"):
+        index = OPTION_CONTRACT_COLUMNS.index(column)
+        values[index] = _to_float(values[index])
+    return values
+
+OPTION_SNAPSHOT_COLUMNS = ["symbol", "bid_price", "bid_size", "ask_price", "ask_size", "last_price", "last_size",
+                           "implied_volatility", "delta", "gamma", "theta", "vega", "rho", "quote_time"]
+
+def _serialize_option_snapshot(symbol: str, snapshot) -> List[Any]:
+    quote = _serialize_record(snapshot.latest_quote, ["bid_price", "bid_size", "ask_price", "ask_size"])
+    trade = _serialize_record(snapshot.latest_trade, ["price", "size"])
+    greeks = _serialize_record(snapshot.greeks, ["delta", "gamma", "theta", "vega", "rho"])
+    quote_time = _serialize_value(snapshot.latest_quote.timestamp) if snapshot.latest_quote else None
+    return [symbol] + quote + trade + [snapshot.implied_volatility] + greeks + [quote_time]
+
+def _csv_line(values: List[Any]) -> str:
+    buffer = io.StringIO()
+    csv.writer(buffer, lineterminator="\n").writerow(
+        " ".join(map(str, v)) if isinstance(v, list) else ("" if v is None else v) for v in values
+    )
+    return buffer.getvalue()
+
+class TableRenderer:
+    """
+    Renders a table incrementally as compact JSON or CSV so it can feed a ResponseWriter.
+
+    JSON output is {<meta>..., "columns": [...], "rows": [[...], ...], <footer meta>...}.
+    CSV output is a header row followed by one line per record; metadata such as the
+    symbol or a continuation token is emitted as '# key=value' lines.
+    """
+
+    def __init__(self, fmt: str, columns: List[str]):
+        self.fmt = fmt
+        self.columns = columns
+        self._rows = 0
+
+    def begin(self, meta: Optional[Dict[str, Any]] = None) -> str:
+        if self.fmt == "json":
+            head = json.dumps({**(meta or {}), "columns": self.columns}, separators=(",", ":"), default=str)
+            return head[:-1] + ',"rows":['
+        return "".join(f"# {k}={v}\n" for k, v in (meta or {}).items() if v is not None) + _csv_line(self.columns)
+
+    def row(self, values: List[Any]) -> str:
+        self._rows += 1
+        if self.fmt == "json":
+            text = json.dumps(values, separators=(",", ":"), default=str)
+            return text if self._rows == 1 else "," + text
+        return _csv_line(values)
+
+    def end(self, meta: Optional[Dict[str, Any]] = None) -> str:
+        meta = {k: v for k, v in (meta or {}).items() if v is not None}
+        if self.fmt == "json":
+            tail = json.dumps(meta, separators=(",", ":"), default=str)
+            return "]" + ("," + tail[1:] if meta else "}")
+        return "".join(f"# {k}={v}\n" for k, v in meta.items())
+
+def _render_table(fmt: str, columns: List[str], rows: List[List[Any]], meta: Optional[Dict[str, Any]] = None) -> str:
+    """Render a complete table in a machine-readable format."""
+    renderer = TableRenderer(fmt, columns)
+    return renderer.begin(meta) + "".join(renderer.row(r) for r in rows) + renderer.end()
+
+# ============================================================================
+# Account Information Tools
+# ============================================================================
+
+@mcp.tool()
+async def get_account_info(account: Optional[str] = None) -> str:
+    """
+    Retrieves and formats the current account information including balances and status.
+    
+    Args:
+        account (Optional[str]): Account to act on, by its MCP_ACCOUNTS name (default: the ALPACA_API_KEY account)
+    
+    Returns:
+        str: Formatted string containing account details including:
+            - Account ID
+            - Status
+            - Currency
+            - Buying Power
+            - Cash Balance
+            - Portfolio Value
+            - Equity
+            - Market Values
+            - Pattern Day Trader Status
+            - Day Trades Remaining
+    """
+    account_data = await _call_api(trade_client.get_account)
+    
+    info = f"""
+            Account Information:
+            -------------------
+            Account ID: {account_data.id}
+            Status: {account_data.status}
+            Currency: {account_data.currency}
+            Buying Power: ${float(account_data.buying_power):.2f}
+            Cash: ${float(account_data.cash):.2f}
+            Portfolio Value: ${float(account_data.portfolio_value):.2f}
+            Equity: ${float(account_data.equity):.2f}
+            Long Market Value: ${float(account_data.long_market_value):.2f}
+            Short Market Value: ${float(account_data.short_market_value):.2f}
+            Pattern Day Trader: {'Yes' if account_data.pattern_day_trader else 'No'}
+            Day Trades Remaining: {account_data.daytrade_count if hasattr(account_data, 'daytrade_count') else 'Unknown'}
+            """
+    return info
+
+@mcp.tool()
+async def get_positions(format: Optional[str] = None, account: Optional[str] = None) -> str:
+    """
+    Retrieves and formats all current positions in the portfolio.
+    
+    Args:
+        format (Optional[str]): Output format - "text", "json" or "csv" (default: MCP_OUTPUT_FORMAT)
+        account (Optional[str]): Account to act on, by its MCP_ACCOUNTS name (default: the ALPACA_API_KEY account)
+    
+    Returns:
+        str: Formatted string containing details of all open positions including:
+            - Symbol
+            - Quantity
+            - Market Value
+            - Average Entry Price
+            - Current Price
+            - Unrealized P/L
+    """
+    try:
+        fmt = _resolve_format(format)
+        positions = await order_mirror.get_positions()
+    
+        if fmt != "text":
+            return _render_table(fmt, POSITION_COLUMNS, [_serialize_position(p) for p in positions])
+    
+        if not positions:
+            return "No open positions found."
+    
+        result = "Current Positions:\n-------------------\n"
+        for position in positions:
+            result += f"""
+                        Symbol: {position.symbol}
+                        Quantity: {position.qty} shares
+                        Market Value: ${float(position.market_value):.2f}
+                        Average Entry Price: ${float(position.avg_entry_price):.2f}
+                        Current Price: ${float(position.current_price):.2f}
+                        Unrealized P/L: ${float(position.unrealized_pl):.2f} ({float(position.unrealized_plpc) * 100:.2f}%)
+                        -------------------
+                        """
+        return result
+    except Exception as e:
+        return ToolError(f"Error fetching positions: {str(e)}")
+
+@mcp.tool()
+async def get_open_position(symbol: str, account: Optional[str] = None) -> str:
+    """
+    Retrieves and formats details for a specific open position.
+    
+    Args:
+        symbol (str): The symbol name of the asset to get position for (e.g., 'AAPL', 'MSFT')
+        account (Optional[str]): Account to act on, by its MCP_ACCOUNTS name (default: the ALPACA_API_KEY account)
+    
+    Returns:
+        str: Formatted string containing the position details or an error message
+    """
+    try:
+        position = await order_mirror.get_position(symbol)
+        if position is None:
+            return f"No open position found for {symbol}."
+        
+        # Check if it's an options position by looking for the options symbol pattern
+        is_option = len(symbol) > 6 and any(c in symbol for c in ['C', 'P'])
+        
+        # Format quantity based on asset type
+        quantity_text = f"{position.qty} contracts" if is_option else f"{position.qty}"
+
+        return f"""
+                Position Details for {symbol}:
+                ---------------------------
+                Quantity: {quantity_text}
+                Market Value: ${float(position.market_value):.2f}
+                Average Entry Price: ${float(position.avg_entry_price):.2f}
+                Current Price: ${float(position.current_price):.2f}
+                Unrealized P/L: ${float(position.unrealized_pl):.2f}
+                """ 
+    except Exception as e:
+        return ToolError(f"Error fetching position: {str(e)}")
+
+# ============================================================================
+# Account Information Tools - All Accounts
+# ============================================================================
+
+ACCOUNT_SUMMARY_COLUMNS = ["account", "account_id", "status", "paper", "equity", "cash", "buying_power",
+                           "long_market_value", "short_market_value"]
+
+async def _across_accounts(fetch) -> List[tuple]:
+    """Run fetch(account) for every configured account concurrently; (account, result or exception) pairs."""
+    registry = list(accounts.values())
+    results = await asyncio.gather(*(fetch(account) for account in registry), return_exceptions=True)
+    return list(zip(registry, results))
+
+def _account_failures(results: List[tuple]) -> Optional[str]:
+    failures = [f"{account.name}: {result}" for account, result in results if isinstance(result, Exception)]
+    return "; ".join(failures) or None
+
+@mcp.tool()
+async def get_account_info_all_accounts(format: Optional[str] = None) -> str:
+    """
+    Retrieves the balances of every configured account concurrently, with desk totals.
+    
+    Args:
+        format (Optional[str]): Output format - "text", "json" or "csv" (default: MCP_OUTPUT_FORMAT)
+    
+    Returns:
+        str: Per account: status, equity, cash, buying power and market values, followed by
+            the totals; accounts that could not be fetched are listed with their error
+    """
+    try:
+        fmt = _resolve_format(format)
+        results = await _across_accounts(lambda account: _call_api(account.client.get_account))
+        rows = []
+        for account, info in results:
+            if isinstance(info, Exception):
+                continue
+            rows.append([account.name, str(info.id), _serialize_value(info.status), account.paper]
+                        + [_to_float(getattr(info, column)) for column in ACCOUNT_SUMMARY_COLUMNS[4:]])
+        failures = _account_failures(results)
+        totals = [sum(row[i] or 0.0 for row in rows) for i in range(4, len(ACCOUNT_SUMMARY_COLUMNS))]
+        if fmt != "text":
+            return _render_table(fmt, ACCOUNT_SUMMARY_COLUMNS, rows, {"accounts": len(results), "errors": failures})
+        
+        result = [f"All Accounts ({len(results)}):", "-" * 30]
+        for name, account_id, status, paper, equity, cash, buying_power, long_value, short_value in rows:
+            result.append(
+                f"{name} ({'paper' if paper else 'live'}, {account_id}): Status: {status}, Equity: ${equity:.2f}, "
+                f"Cash: ${cash:.2f}, Buying Power: ${buying_power:.2f}, Long: ${long_value:.2f}, Short: ${short_value:.2f}"
+            )
+        result.append(
+            f"Total: Equity: ${totals[0]:.2f}, Cash: ${totals[1]:.2f}, Buying Power: ${totals[2]:.2f}, "
+            f"Long: ${totals[3]:.2f}, Short: ${totals[4]:.2f}"
+        )
+        if failures:
+            result.append(f"Failed: {failures}")
+        return "\n".join(result)
+    except Exception as e:
+        return ToolError(f"Error fetching accounts: {str(e)}")
+
+@mcp.tool()
+async def get_positions_all_accounts(format: Optional[str] = None) -> str:
+    """
+    Retrieves the open positions of every configured account concurrently, read from each
+    account's order mirror, with the net position per symbol across accounts.
+    
+    Args:
+        format (Optional[str]): Output format - "text", "json" or "csv" (default: MCP_OUTPUT_FORMAT)
+    
+    Returns:
+        str: Every position tagged with its account, then per symbol the net quantity, market
+            value and unrealized P/L over all accounts
+    """
+    try:
+        fmt = _resolve_format(format)
+        results = await _across_accounts(lambda account: account.mirror.get_positions())
+        failures = _account_failures(results)
+        held = [(account.name, position) for account, positions in results
+                if not isinstance(positions, Exception) for position in positions]
+        if fmt != "text":
+            return _render_table(fmt, ["account"] + POSITION_COLUMNS,
+                                 [[name] + _serialize_position(p) for name, p in held],
+                                 {"accounts": len(results), "errors": failures})
+        if not held:
+            return "No open positions found in any account." + (f"\nFailed: {failures}" if failures else "")
+        
+        net: Dict[str, List[float]] = defaultdict(lambda: [0.0, 0.0, 0.0])
+        result = [f"Positions Across {len(results)} Accounts:", "-" * 30]
+        for name, position in held:
+            qty, value, pl = float(position.qty), float(position.market_value), float(position.unrealized_pl)
+            totals = net[position.symbol]
+            totals[0] += qty
+            totals[1] += value
+            totals[2] += pl
+            result.append(f"{name}: {position.symbol} {position.qty} @ ${float(position.avg_entry_price):.2f}, "
+                          f"Market Value: ${value:.2f}, Unrealized P/L: ${pl:.2f}")
+        result += ["", "Net by Symbol:"]
+        for symbol, (qty, value, pl) in sorted(net.items()):
+            result.append(f"{symbol}: {qty:g}, Market Value: ${value:.2f}, Unrealized P/L: ${pl:.2f}")
+        if failures:
+            result.append(f"Failed: {failures}")
+        return "\n".join(result)
+    except Exception as e:
+        return ToolError(f"Error fetching positions: {str(e)}")
+
+# ============================================================================
+# Market Data Tools
+# ============================================================================
+
+@mcp.tool()
+async def get_stock_quote(symbol: str, format: Optional[str] = None) -> str:
+    """
+    Retrieves and formats the latest quote for a stock.
+    
+    Args:
+        symbol (str): Stock ticker symbol (e.g., AAPL, MSFT)
+        format (Optional[str]): Output format - "text", "json" or "csv" (default: MCP_OUTPUT_FORMAT)
+    
+    Returns:
+        str: Formatted string containing:
+            - Ask Price
+            - Bid Price
+            - Ask Size
+            - Bid Size
+            - Timestamp
+    """
+    try:
+        fmt = _resolve_format(format)
+        # Answer from the live stream table when the symbol is subscribed
+        quote = market_stream.get_quote(symbol)
+        if quote is None:
+            request_params = StockLatestQuoteRequest(symbol_or_symbols=symbol)
+            quotes = await _call_api(stock_historical_data_client.get_stock_latest_quote, request_params)
+            quote = quotes.get(symbol)
+        
+        if fmt != "text":
+            return _render_table(fmt, QUOTE_COLUMNS, [_serialize_quote(quote)] if quote is not None else [], {"symbol": symbol})
+        
+        if quote is not None:
+            return f"""
+                    Latest Quote for {symbol}:
+                    ------------------------
+                    Ask Price: ${quote.ask_price:.2f}
+                    Bid Price: ${quote.bid_price:.2f}
+                    Ask Size: {quote.ask_size}
+                    Bid Size: {quote.bid_size}
+                    Timestamp: {quote.timestamp}
+                    """ 
+        else:
+            return f"No quote data found for {symbol}."
+    except Exception as e:
+        return ToolError(f"Error fetching quote for {symbol}: {str(e)}")
+
+@mcp.tool()
+async def get_stock_bars(
+    symbol: str, 
+    days: int = 5, 
+    timeframe: str = "1Day",
+    limit: Optional[int] = None,
+    start: Optional[str] = None,
+    end: Optional[str] = None,
+    page_token: Optional[str] = None,
+    max_rows: Optional[int] = None,
+    max_bytes: Optional[int] = None,
+    format: Optional[str] = None
+) -> str:
+    """
+    Retrieves and formats historical price bars for a stock with configurable timeframe and time range.
+    Large ranges are returned in pages: when more bars are available the response ends with a
+    page_token that fetches the next page.
+    
+    Args:
+        symbol (str): Stock ticker symbol (e.g., AAPL, MSFT)
+        days (int): Number of days to look back (default: 5, ignored if start/end provided)
+        timeframe (str): Bar timeframe - supports flexible Alpaca formats:
+            - Minutes: "1Min", "2Min", "3Min", "4Min", "5Min", "15Min", "30Min", etc.
+            - Hours: "1Hour", "2Hour", "3Hour", "4Hour", "6Hour", etc.
+            - Days: "1Day", "2Day", "3Day", etc.
+            - Weeks: "1Week", "2Week", etc.
+            - Months: "1Month", "2Month", etc.
+            (default: "1Day")
+        limit (Optional[int]): Maximum number of bars to return across all pages (optional)
+        start (Optional[str]): Start time in ISO format (e.g., "2023-01-01T09:30:00" or "2023-01-01")
+        end (Optional[str]): End time in ISO format (e.g., "2023-01-01T16:00:00" or "2023-01-01")
+        page_token (Optional[str]): Continuation cursor from a previous response. Pass it with the
+            same symbol and timeframe to fetch the next page; the original time range is preserved.
+        max_rows (Optional[int]): Maximum bars in this response (default: MCP_MAX_ROWS)
+        max_bytes (Optional[int]): Approximate maximum response size in bytes (default: MCP_MAX_BYTES)
+        format (Optional[str]): Output format - "text", "json" or "csv" (default: MCP_OUTPUT_FORMAT)
+    
+    Returns:
+        str: Formatted string containing historical price data with timestamps, OHLCV data,
+            followed by a page_token when more bars are available
+    """
+    try:
+        fmt = _resolve_format(format)
+        # Parse timeframe string to TimeFrame object
+        timeframe_obj = parse_timeframe_with_enums(timeframe)
+        if timeframe_obj is None:
+            return ToolError(f"Error: Invalid timeframe '{timeframe}'. Supported formats: 1Min, 2Min, 4Min, 5Min, 15Min, 30Min, 1Hour, 2Hour, 4Hour, 1Day, 1Week, 1Month, etc.")
+        
+        query = {"symbol": symbol, "days": days, "timeframe": timeframe, "limit": limit, "start": start, "end": end}
+        if page_token:
+            # Resume a previous request; the cursor pins the original time range
+            try:
+                state = _decode_cursor(page_token, query)
+            except ValueError as e:
+                return ToolError(f"Error: {str(e)}")
+            start_time = datetime.fromisoformat(state["start"])
+            end_time = datetime.fromisoformat(state["end"])
+            if state.get("store", False) != (bar_store is not None):
+                return ToolError("Error: page_token was issued by a different server configuration. Repeat the request without page_token.")
+        else:
+            # Parse start/end times or calculate from days
+            start_time = None
+            end_time = None
+            
+            if start:
+                try:
+                    start_time = _parse_iso_datetime(start)
+                except ValueError:
+                    return ToolError(f"Error: Invalid start time format '{start}'. Use ISO format like '2023-01-01T09:30:00' or '2023-01-01'")
+                    
+            if end:
+                try:
+                    end_time = _parse_iso_datetime(end)
+                except ValueError:
+                    return ToolError(f"Error: Invalid end time format '{end}'. Use ISO format like '2023-01-01T16:00:00' or '2023-01-01'")
+            
+            # If no start/end provided, calculate from days parameter OR limit+timeframe
+            if not start_time:
+                if limit and timeframe_obj.unit_value in [TimeFrameUnit.Minute, TimeFrameUnit.Hour]:
+                    # Calculate based on limit and timeframe for intraday data
+                    if timeframe_obj.unit_value == TimeFrameUnit.Minute:
+                        minutes_back = limit * timeframe_obj.amount
+                        start_time = datetime.now() - timedelta(minutes=minutes_back)
+                    elif timeframe_obj.unit_value == TimeFrameUnit.Hour:
+                        hours_back = limit * timeframe_obj.amount
+                        start_time = datetime.now() - timedelta(hours=hours_back)
+                else:
+                    # Fall back to days parameter for daily+ timeframes
+                    start_time = datetime.now() - timedelta(days=days)
+            if not end_time:
+                end_time = datetime.now()
+            state = {"start": start_time.isoformat(), "end": end_time.isoformat(), "remaining": limit,
+                     "query": _query_digest(query)}
+        
+        intraday = timeframe_obj.unit_value in [TimeFrameUnit.Minute, TimeFrameUnit.Hour]
+        
+        if bar_store is not None:
+            # Serve from the local store, downloading only the ranges it does not hold yet.
+            # Store cursors page by row offset, so the page token is the offset as a string.
+            state["store"] = True
+            range_start, range_end = await _ensure_bars_stored(symbol, timeframe_obj, start_time, end_time)
+            
+            def fetch_page(token: Optional[str], page_limit: int) -> tuple:
+                offset = int(token or 0)
+                rows = bar_store.read(symbol, timeframe_obj.value, range_start, range_end, offset, page_limit)
+                return rows, str(offset + len(rows)) if len(rows) == page_limit else None
+        else:
+            def fetch_page(token: Optional[str], page_limit: int) -> tuple:
+                return _fetch_data_page(stock_historical_data_client, "/stocks/bars", "bars", symbol, {
+                    "symbols": symbol,
+                    "timeframe": timeframe_obj.value,
+                    "start": _to_rfc3339(start_time),
+                    "end": _to_rfc3339(end_time),
+                    "limit": page_limit,
+                    "page_token": token,
+                })
+        
+        def render_row(row: Dict[str, Any]) -> str:
+            bar = Bar(symbol, row)
+            # Format timestamp based on timeframe unit
+            time_str = bar.timestamp.strftime('%Y-%m-%d %H:%M:%S') if intraday else bar.timestamp.date()
+            return f"Time: {time_str}, Open: ${bar.open:.2f}, High: ${bar.high:.2f}, Low: ${bar.low:.2f}, Close: ${bar.close:.2f}, Volume: {bar.volume}\n"
+        
+        writer = ResponseWriter(max_rows or MCP_MAX_ROWS, max_bytes or MCP_MAX_BYTES)
+        if fmt != "text":
+            renderer = TableRenderer(fmt, BAR_COLUMNS)
+            writer.write(renderer.begin({"symbol": symbol, "timeframe": timeframe}))
+            next_cursor = await _paginate_rows(writer, fetch_page, lambda row: renderer.row(_serialize_bar(Bar(symbol, row))), state, local=bar_store is not None)
+            writer.write(renderer.end({"next_page_token": next_cursor}))
+            return writer.getvalue()
+        
+        time_range = f"{start_time.strftime('%Y-%m-%d %H:%M')} to {end_time.strftime('%Y-%m-%d %H:%M')}"
+        writer.write(f"Historical Data for {symbol} ({timeframe} bars, {time_range}):\n")
+        writer.write("---------------------------------------------------\n")
+        next_cursor = await _paginate_rows(writer, fetch_page, render_row, state, local=bar_store is not None)
+        
+        if writer.rows == 0:
+            return f"No historical data found for {symbol} with {timeframe} timeframe in the specified time range."
+        
+        if next_cursor:
+            writer.write(f"\nShowing {writer.rows} bars. More data available - call again with page_token='{next_cursor}'\n")
+        return writer.getvalue()
+    except Exception as e:
+        return ToolError(f"Error fetching historical data for {symbol}: {str(e)}")
+
+@mcp.tool()
+async def get_stock_trades(
+    symbol: str,
+    days: int = 5,
+    limit: Optional[int] = None,
+    sort: Optional[Sort] = Sort.ASC,
+    feed: Optional[DataFeed] = None,
+    currency: Optional[SupportedCurrencies] = None,
+    asof: Optional[str] = None,
+    page_token: Optional[str] = None,
+    max_rows: Optional[int] = None,
+    max_bytes: Optional[int] = None,
+    format: Optional[str] = None
+) -> str:
+    """
+    Retrieves and formats historical trades for a stock.
+    Large ranges are returned in pages: when more trades are available the response ends with a
+    page_token that fetches the next page. To save whole sessions to disk, use export_market_data.
+    
+    Args:
+        symbol (str): Stock ticker symbol (e.g., 'AAPL', 'MSFT')
+        days (int): Number of days to look back (default: 5)
+        limit (Optional[int]): Upper limit of number of data points to return across all pages
+        sort (Optional[Sort]): Chronological order of response (ASC or DESC)
+        feed (Optional[DataFeed]): The stock data feed to retrieve from
+        currency (Optional[SupportedCurrencies]): Currency for prices (default: USD)
+        asof (Optional[str]): The asof date in YYYY-MM-DD format
+        page_token (Optional[str]): Continuation cursor from a previous response. Pass it with the
+            same arguments to fetch the next page; the original time range is preserved.
+        max_rows (Optional[int]): Maximum trades in this response (default: MCP_MAX_ROWS)
+        max_bytes (Optional[int]): Approximate maximum response size in bytes (default: MCP_MAX_BYTES)
+        format (Optional[str]): Output format - "text", "json" or "csv" (default: MCP_OUTPUT_FORMAT)
+    
+    Returns:
+        str: Formatted string containing trade history or an error message, followed by a
+            page_token when more trades are available
+    """
+    try:
+        fmt = _resolve_format(format)
+        query = {"symbol": symbol, "days": days, "limit": limit, "sort": sort, "feed": feed, "currency": currency,
+                 "asof": asof}
+        if page_token:
+            # Resume a previous request; the cursor pins the original time range
+            try:
+                state = _decode_cursor(page_token, query)
+            except ValueError as e:
+                return ToolError(f"Error: {str(e)}")
+            start_time = datetime.fromisoformat(state["start"])
+            end_time = datetime.fromisoformat(state["end"])
+        else:
+            # Calculate start time based on days
+            start_time = datetime.now() - timedelta(days=days)
+            end_time = datetime.now()
+            state = {"start": start_time.isoformat(), "end": end_time.isoformat(), "remaining": limit,
+                     "query": _query_digest(query)}
+        
+        def fetch_page(token: Optional[str], page_limit: int) -> tuple:
+            return _fetch_data_page(stock_historical_data_client, "/stocks/trades", "trades", symbol, {
+                "symbols": symbol,
+                "start": _to_rfc3339(start_time),
+                "end": _to_rfc3339(end_time),
+                "limit": page_limit,
+                "sort": sort.value if sort else None,
+                "feed": feed.value if feed else None,
+                "currency": currency.value if currency else None,
+                "asof": asof,
+                "page_token": token,
+            })
+        
+        def render_row(row: Dict[str, Any]) -> str:
+            trade = Trade(symbol, row)
+            return f"""
                     Time: {trade.timestamp}
                     Price: ${float(trade.price):.6f}
                     Size: {trade.size}
@@ -419,17 +2769,34 @@ async def get_stock_trades(
                     Conditions: {trade.conditions}
                     -------------------
                     """
-            return result
-        else:
+        
+        writer = ResponseWriter(max_rows or MCP_MAX_ROWS, max_bytes or MCP_MAX_BYTES)
+        if fmt != "text":
+            renderer = TableRenderer(fmt, TRADE_COLUMNS)
+            writer.write(renderer.begin({"symbol": symbol}))
+            next_cursor = await _paginate_rows(writer, fetch_page, lambda row: renderer.row(_serialize_trade(Trade(symbol, row))), state)
+            writer.write(renderer.end({"next_page_token": next_cursor}))
+            return writer.getvalue()
+        
+        writer.write(f"Historical Trades for {symbol} (Last {days} days):\n")
+        writer.write("---------------------------------------------------\n")
+        next_cursor = await _paginate_rows(writer, fetch_page, render_row, state)
+        
+        if writer.rows == 0:
             return f"No trade data found for {symbol} in the last {days} days."
+        
+        if next_cursor:
+            writer.write(f"\nShowing {writer.rows} trades. More data available - call again with page_token='{next_cursor}'\n")
+        return writer.getvalue()
     except Exception as e:
-        return f"Error fetching trades: {str(e)}"
+        return ToolError(f"Error fetching trades: {str(e)}")
 
 @mcp.tool()
 async def get_stock_latest_trade(
     symbol: str,
     feed: Optional[DataFeed] = None,
-    currency: Optional[SupportedCurrencies] = None
+    currency: Optional[SupportedCurrencies] = None,
+    format: Optional[str] = None
 ) -> str:
     """Get the latest trade for a stock.
     
@@ -437,81 +2804,820 @@ async def get_stock_latest_trade(
         symbol: Stock ticker symbol (e.g., 'AAPL', 'MSFT')
         feed: The stock data feed to retrieve from (optional)
         currency: The currency for prices (optional, defaults to USD)
+        format: Output format - "text", "json" or "csv" (default: MCP_OUTPUT_FORMAT)
+    
+    Returns:
+        A formatted string containing the latest trade details or an error message
+    """
+    try:
+        fmt = _resolve_format(format)
+        # Answer from the live stream table when the symbol is subscribed
+        trade = market_stream.get_trade(symbol) if market_stream.serves(feed, currency) else None
+        if trade is None:
+            # Create the request object with all available parameters
+            request_params = StockLatestTradeRequest(
+                symbol_or_symbols=symbol,
+                feed=feed,
+                currency=currency
+            )
+            
+            # Get the latest trade
+            latest_trades = await _call_api(stock_historical_data_client.get_stock_latest_trade, request_params)
+            trade = latest_trades.get(symbol)
+        
+        if fmt != "text":
+            return _render_table(fmt, TRADE_COLUMNS, [_serialize_trade(trade)] if trade is not None else [], {"symbol": symbol})
+        
+        if trade is not None:
+            return f"""
+                Latest Trade for {symbol}:
+                ---------------------------
+                Time: {trade.timestamp}
+                Price: ${float(trade.price):.6f}
+                Size: {trade.size}
+                Exchange: {trade.exchange}
+                ID: {trade.id}
+                Conditions: {trade.conditions}
+                """
+        else:
+            return f"No latest trade data found for {symbol}."
+    except Exception as e:
+        return ToolError(f"Error fetching latest trade: {str(e)}")
+
+@mcp.tool()
+async def get_stock_latest_bar(
+    symbol: str,
+    feed: Optional[DataFeed] = None,
+    currency: Optional[SupportedCurrencies] = None,
+    format: Optional[str] = None
+) -> str:
+    """Get the latest minute bar for a stock.
+    
+    Args:
+        symbol: Stock ticker symbol (e.g., 'AAPL', 'MSFT')
+        feed: The stock data feed to retrieve from (optional)
+        currency: The currency for prices (optional, defaults to USD)
+        format: Output format - "text", "json" or "csv" (default: MCP_OUTPUT_FORMAT)
+    
+    Returns:
+        A formatted string containing the latest bar details or an error message
+    """
+    try:
+        fmt = _resolve_format(format)
+        # Answer from the live stream table when the symbol is subscribed
+        bar = market_stream.get_bar(symbol) if market_stream.serves(feed, currency) else None
+        if bar is None:
+            # Create the request object with all available parameters
+            request_params = StockLatestBarRequest(
+                symbol_or_symbols=symbol,
+                feed=feed,
+                currency=currency
+            )
+            
+            # Get the latest bar
+            latest_bars = await _call_api(stock_historical_data_client.get_stock_latest_bar, request_params)
+            bar = latest_bars.get(symbol)
+        
+        if fmt != "text":
+            return _render_table(fmt, BAR_COLUMNS, [_serialize_bar(bar)] if bar is not None else [], {"symbol": symbol})
+        
+        if bar is not None:
+            return f"""
+                Latest Minute Bar for {symbol}:
+                ---------------------------
+                Time: {bar.timestamp}
+                Open: ${float(bar.open):.2f}
+                High: ${float(bar.high):.2f}
+                Low: ${float(bar.low):.2f}
+                Close: ${float(bar.close):.2f}
+                Volume: {bar.volume}
+                """
+        else:
+            return f"No latest bar data found for {symbol}."
+    except Exception as e:
+        return ToolError(f"Error fetching latest bar: {str(e)}")
+
+@mcp.tool()
+async def subscribe_symbols(symbols: List[str]) -> str:
+    """
+    Subscribes stock symbols to the live market data stream. While subscribed,
+    get_stock_quote, get_stock_latest_trade and get_stock_latest_bar answer from
+    an in-memory table instead of making a REST request. Subscribe before a burst
+    of questions about the same symbols.
+    
+    Args:
+        symbols (List[str]): Stock ticker symbols to subscribe (e.g., ['AAPL', 'MSFT'])
+    
+    Returns:
+        str: Newly subscribed symbols and the full subscription list
+    """
+    try:
+        symbols = [s.strip().upper() for s in symbols if s and s.strip()]
+        if not symbols:
+            return ToolError("Error: No symbols provided.")
+        added = await _run_blocking(market_stream.subscribe, symbols)
+        # Explicit subscriptions outlive the alerts on the same symbols
+        alert_monitor.adopt(symbols)
+        return f"""
+                Live Stream Subscription:
+                -------------------------
+                Feed: {market_stream.feed.value}
+                Stream: {market_stream.status}
+                Newly Subscribed: {', '.join(added) if added else 'None (already subscribed)'}
+                All Subscribed: {', '.join(market_stream.subscribed)}
+                """
+    except Exception as e:
+        return ToolError(f"Error subscribing symbols: {str(e)}")
+
+@mcp.tool()
+async def unsubscribe_symbols(symbols: List[str]) -> str:
+    """
+    Unsubscribes stock symbols from the live market data stream and drops their cached data.
+    
+    Args:
+        symbols (List[str]): Stock ticker symbols to unsubscribe (e.g., ['AAPL', 'MSFT'])
+    
+    Returns:
+        str: Removed symbols and the remaining subscription list
+    """
+    try:
+        symbols = [s.strip().upper() for s in symbols if s and s.strip()]
+        if not symbols:
+            return ToolError("Error: No symbols provided.")
+        removed = await _run_blocking(market_stream.unsubscribe, symbols)
+        return f"""
+                Live Stream Subscription:
+                -------------------------
+                Unsubscribed: {', '.join(removed) if removed else 'None (not subscribed)'}
+                Still Subscribed: {', '.join(market_stream.subscribed) or 'None'}
+                """
+    except Exception as e:
+        return ToolError(f"Error unsubscribing symbols: {str(e)}")
+
+# ============================================================================
+# Market Data Tools - Multi-Symbol Batch Requests
+# ============================================================================
+
+def _normalize_symbols(symbols: List[str]) -> List[str]:
+    """Uppercase, strip and de-duplicate symbols while preserving order."""
+    return list(dict.fromkeys(s.strip().upper() for s in symbols if s and s.strip()))
+
+async def _fetch_symbol_chunks(func, make_request, symbols: List[str], chunk_size: Optional[int] = None) -> tuple:
+    """
+    Split symbols into chunks, issue one multi-symbol request per chunk concurrently,
+    and merge the per-symbol results.
+    
+    Args:
+        func: Bound SDK method accepting a request object (e.g., get_stock_latest_quote)
+        make_request: Callable building the request object for a list of symbols
+        symbols: Symbols to fetch
+        chunk_size: Symbols per request (default: MCP_BATCH_CHUNK_SIZE)
+    
+    Returns:
+        tuple: (dict of symbol -> result, dict of failed symbol -> error message)
+    """
+    chunk_size = chunk_size or MCP_BATCH_CHUNK_SIZE
+    chunks = [symbols[i:i + chunk_size] for i in range(0, len(symbols), chunk_size)]
+    responses = await asyncio.gather(
+        *(_call_api(func, make_request(chunk)) for chunk in chunks),
+        return_exceptions=True
+    )
+    merged: Dict[str, Any] = {}
+    failed: Dict[str, str] = {}
+    for chunk, response in zip(chunks, responses):
+        if isinstance(response, Exception):
+            failed.update({symbol: str(response) for symbol in chunk})
+        else:
+            # BarSet and similar containers keep their mapping in .data
+            merged.update(getattr(response, "data", response))
+    return merged, failed
+
+def _format_batch_footer(symbols: List[str], found: Dict[str, Any], failed: Dict[str, str]) -> List[str]:
+    """Summarize symbols that returned no data or failed in a batch response."""
+    lines = []
+    missing = [s for s in symbols if s not in found and s not in failed]
+    if missing:
+        lines.append(f"No data: {', '.join(missing)}")
+    for error in dict.fromkeys(failed.values()):
+        lines.append(f"Error for {', '.join(s for s, e in failed.items() if e == error)}: {error}")
+    return lines
+
+@mcp.tool()
+async def get_stock_quotes_batch(symbols: List[str], format: Optional[str] = None) -> str:
+    """
+    Retrieves the latest quotes for many stocks in one call. Symbols are split into
+    multi-symbol requests that run concurrently; subscribed symbols are answered
+    from the live stream.
+    
+    Args:
+        symbols (List[str]): Stock ticker symbols (e.g., ['AAPL', 'MSFT', 'NVDA'])
+        format (Optional[str]): Output format - "text", "json" or "csv" (default: MCP_OUTPUT_FORMAT)
+    
+    Returns:
+        str: One line per symbol with bid/ask prices, sizes and timestamp
+    """
+    try:
+        fmt = _resolve_format(format)
+        symbols = _normalize_symbols(symbols)
+        if not symbols:
+            return ToolError("Error: No symbols provided.")
+        
+        quotes = {s: q for s in symbols if (q := market_stream.get_quote(s)) is not None}
+        pending = [s for s in symbols if s not in quotes]
+        failed: Dict[str, str] = {}
+        if pending:
+            fetched, failed = await _fetch_symbol_chunks(
+                stock_historical_data_client.get_stock_latest_quote,
+                lambda chunk: StockLatestQuoteRequest(symbol_or_symbols=chunk),
+                pending
+            )
+            quotes.update(fetched)
+        
+        if fmt != "text":
+            rows = [[s] + _serialize_quote(quotes[s]) for s in symbols if s in quotes]
+            return _render_table(fmt, ["symbol"] + QUOTE_COLUMNS, rows)
+        
+        result = [f"Latest Quotes ({len(quotes)} of {len(symbols)} symbols):", "-" * 30]
+        for symbol in symbols:
+            quote = quotes.get(symbol)
+            if quote is not None:
+                result.append(
+                    f"{symbol}: Bid ${quote.bid_price:.2f} x {quote.bid_size}, "
+                    f"Ask ${quote.ask_price:.2f} x {quote.ask_size}, Time: {quote.timestamp}"
+                )
+        result.extend(_format_batch_footer(symbols, quotes, failed))
+        return "\n".join(result)
+    except Exception as e:
+        return ToolError(f"Error fetching quotes: {str(e)}")
+
+@mcp.tool()
+async def get_stock_latest_trades_batch(
+    symbols: List[str],
+    feed: Optional[DataFeed] = None,
+    currency: Optional[SupportedCurrencies] = None,
+    format: Optional[str] = None
+) -> str:
+    """
+    Retrieves the latest trades for many stocks in one call. Symbols are split into
+    multi-symbol requests that run concurrently; subscribed symbols are answered
+    from the live stream.
+    
+    Args:
+        symbols (List[str]): Stock ticker symbols (e.g., ['AAPL', 'MSFT', 'NVDA'])
+        feed (Optional[DataFeed]): The stock data feed to retrieve from
+        currency (Optional[SupportedCurrencies]): The currency for prices (default: USD)
+        format (Optional[str]): Output format - "text", "json" or "csv" (default: MCP_OUTPUT_FORMAT)
+    
+    Returns:
+        str: One line per symbol with trade price, size, exchange and timestamp
+    """
+    try:
+        fmt = _resolve_format(format)
+        symbols = _normalize_symbols(symbols)
+        if not symbols:
+            return ToolError("Error: No symbols provided.")
+        
+        trades = {}
+        if market_stream.serves(feed, currency):
+            trades = {s: t for s in symbols if (t := market_stream.get_trade(s)) is not None}
+        pending = [s for s in symbols if s not in trades]
+        failed: Dict[str, str] = {}
+        if pending:
+            fetched, failed = await _fetch_symbol_chunks(
+                stock_historical_data_client.get_stock_latest_trade,
+                lambda chunk: StockLatestTradeRequest(symbol_or_symbols=chunk, feed=feed, currency=currency),
+                pending
+            )
+            trades.update(fetched)
+        
+        if fmt != "text":
+            rows = [[s] + _serialize_trade(trades[s]) for s in symbols if s in trades]
+            return _render_table(fmt, ["symbol"] + TRADE_COLUMNS, rows)
+        
+        result = [f"Latest Trades ({len(trades)} of {len(symbols)} symbols):", "-" * 30]
+        for symbol in symbols:
+            trade = trades.get(symbol)
+            if trade is not None:
+                result.append(
+                    f"{symbol}: Price ${float(trade.price):.4f}, Size: {trade.size}, "
+                    f"Exchange: {trade.exchange}, Time: {trade.timestamp}"
+                )
+        result.extend(_format_batch_footer(symbols, trades, failed))
+        return "\n".join(result)
+    except Exception as e:
+        return ToolError(f"Error fetching latest trades: {str(e)}")
+
+@mcp.tool()
+async def get_stock_latest_bars_batch(
+    symbols: List[str],
+    feed: Optional[DataFeed] = None,
+    currency: Optional[SupportedCurrencies] = None,
+    format: Optional[str] = None
+) -> str:
+    """
+    Retrieves the latest minute bars for many stocks in one call. Symbols are split
+    into multi-symbol requests that run concurrently; subscribed symbols are answered
+    from the live stream.
+    
+    Args:
+        symbols (List[str]): Stock ticker symbols (e.g., ['AAPL', 'MSFT', 'NVDA'])
+        feed (Optional[DataFeed]): The stock data feed to retrieve from
+        currency (Optional[SupportedCurrencies]): The currency for prices (default: USD)
+        format (Optional[str]): Output format - "text", "json" or "csv" (default: MCP_OUTPUT_FORMAT)
+    
+    Returns:
+        str: One line per symbol with OHLCV values and timestamp
+    """
+    try:
+        fmt = _resolve_format(format)
+        symbols = _normalize_symbols(symbols)
+        if not symbols:
+            return ToolError("Error: No symbols provided.")
+        
+        bars = {}
+        if market_stream.serves(feed, currency):
+            bars = {s: b for s in symbols if (b := market_stream.get_bar(s)) is not None}
+        pending = [s for s in symbols if s not in bars]
+        failed: Dict[str, str] = {}
+        if pending:
+            fetched, failed = await _fetch_symbol_chunks(
+                stock_historical_data_client.get_stock_latest_bar,
+                lambda chunk: StockLatestBarRequest(symbol_or_symbols=chunk, feed=feed, currency=currency),
+                pending
+            )
+            bars.update(fetched)
+        
+        if fmt != "text":
+            rows = [[s] + _serialize_bar(bars[s]) for s in symbols if s in bars]
+            return _render_table(fmt, ["symbol"] + BAR_COLUMNS, rows)
+        
+        result = [f"Latest Minute Bars ({len(bars)} of {len(symbols)} symbols):", "-" * 30]
+        for symbol in symbols:
+            bar = bars.get(symbol)
+            if bar is not None:
+                result.append(
+                    f"{symbol}: Open ${float(bar.open):.2f}, High ${float(bar.high):.2f}, Low ${float(bar.low):.2f}, "
+                    f"Close ${float(bar.close):.2f}, Volume: {bar.volume}, Time: {bar.timestamp}"
+                )
+        result.extend(_format_batch_footer(symbols, bars, failed))
+        return "\n".join(result)
+    except Exception as e:
+        return ToolError(f"Error fetching latest bars: {str(e)}")
+
+# Longest session intraday bars can fill per trading day (extended hours, 4:00-20:00 ET)
+INTRADAY_SESSION_MINUTES = 16 * 60
+
+def _recent_bars_window(timeframe: TimeFrame, bars: int) -> timedelta:
+    """Calendar span ending now that holds at least `bars` bars of an actively traded symbol."""
+    span = bars * timeframe.amount_value
+    unit = timeframe.unit_value
+    if unit == TimeFrameUnit.Week:
+        return timedelta(weeks=span + 1)
+    if unit == TimeFrameUnit.Month:
+        return timedelta(days=31 * (span + 1))
+    if unit == TimeFrameUnit.Minute:
+        trading_days = math.ceil(span / INTRADAY_SESSION_MINUTES)
+    elif unit == TimeFrameUnit.Hour:
+        trading_days = math.ceil(span * 60 / INTRADAY_SESSION_MINUTES)
+    else:
+        trading_days = span
+    return timedelta(days=math.ceil(trading_days * 7 / 5) + 4)  # Weekends plus a holiday margin
+
+async def _fetch_recent_bars(symbols: List[str], timeframe: TimeFrame, start: datetime, end: datetime,
+                             limit_per_symbol: Optional[int]) -> tuple:
+    """
+    Bars of every symbol in [start, end], keeping only what limit_per_symbol can return.
+
+    Multi-symbol bar requests have no per-symbol limit, so with limit_per_symbol the
+    request window is narrowed to the span that should hold that many bars. Symbols that
+    come back short (thinly traded, or a window spanning closures) are refetched over a
+    four times wider window, up to the requested start.
+
+    Returns:
+        tuple: (dict of symbol -> bars, dict of failed symbol -> error message)
+    """
+    def fetch(chunk_symbols: List[str], since: datetime):
+        return _fetch_symbol_chunks(
+            stock_historical_data_client.get_stock_bars,
+            lambda chunk: StockBarsRequest(symbol_or_symbols=chunk, timeframe=timeframe, start=since, end=end),
+            chunk_symbols
+        )
+
+    # Narrowing needs comparable datetimes; mixed naive/aware arguments fetch the full range
+    if not limit_per_symbol or (start.tzinfo is None) != (end.tzinfo is None):
+        return await fetch(symbols, start)
+    window = _recent_bars_window(timeframe, limit_per_symbol)
+    bars: Dict[str, Any] = {}
+    failed: Dict[str, str] = {}
+    pending = symbols
+    while pending:
+        since = max(start, end - window)
+        fetched, errors = await fetch(pending, since)
+        bars.update(fetched)
+        failed.update(errors)
+        if since <= start:
+            break
+        pending = [s for s in pending if s not in errors and len(fetched.get(s) or []) < limit_per_symbol]
+        window *= 4
+    return bars, failed
+
+@mcp.tool()
+async def get_stock_bars_batch(
+    symbols: List[str],
+    days: int = 5,
+    timeframe: str = "1Day",
+    limit_per_symbol: Optional[int] = None,
+    start: Optional[str] = None,
+    end: Optional[str] = None,
+    max_bytes: Optional[int] = None,
+    format: Optional[str] = None
+) -> str:
+    """
+    Retrieves historical price bars for many stocks in one call. Symbols are split into
+    multi-symbol requests that run concurrently and the results are merged per symbol.
+    
+    Args:
+        symbols (List[str]): Stock ticker symbols (e.g., ['AAPL', 'MSFT', 'NVDA'])
+        days (int): Number of days to look back (default: 5, ignored if start is provided)
+        timeframe (str): Bar timeframe, same formats as get_stock_bars (default: "1Day")
+        limit_per_symbol (Optional[int]): Return only the most recent N bars per symbol; the download
+            is narrowed to about that many bars
+        start (Optional[str]): Start time in ISO format (e.g., "2023-01-01T09:30:00" or "2023-01-01")
+        end (Optional[str]): End time in ISO format (e.g., "2023-01-01T16:00:00" or "2023-01-01")
+        max_bytes (Optional[int]): Approximate maximum response size in bytes (default: MCP_MAX_BYTES)
+        format (Optional[str]): Output format - "text", "json" or "csv" (default: MCP_OUTPUT_FORMAT)
     
     Returns:
-        A formatted string containing the latest trade details or an error message
+        str: Historical OHLCV bars grouped by symbol
+    """
+    try:
+        fmt = _resolve_format(format)
+        symbols = _normalize_symbols(symbols)
+        if not symbols:
+            return ToolError("Error: No symbols provided.")
+        
+        timeframe_obj = parse_timeframe_with_enums(timeframe)
+        if timeframe_obj is None:
+            return ToolError(f"Error: Invalid timeframe '{timeframe}'. Supported formats: 1Min, 2Min, 4Min, 5Min, 15Min, 30Min, 1Hour, 2Hour, 4Hour, 1Day, 1Week, 1Month, etc.")
+        
+        try:
+            start_time = _parse_iso_datetime(start) if start else datetime.now() - timedelta(days=days)
+            end_time = _parse_iso_datetime(end) if end else datetime.now()
+        except ValueError:
+            return ToolError(f"Error: Invalid start/end time format. Use ISO format like '2023-01-01T09:30:00' or '2023-01-01'")
+        
+        bars, failed = await _fetch_recent_bars(symbols, timeframe_obj, start_time, end_time, limit_per_symbol)
+        
+        writer = ResponseWriter(max_bytes=max_bytes or MCP_MAX_BYTES)
+        if fmt != "text":
+            renderer = TableRenderer(fmt, ["symbol"] + BAR_COLUMNS)
+            writer.write(renderer.begin({"timeframe": timeframe}))
+            truncated = False
+            for symbol in symbols:
+                symbol_bars = bars.get(symbol) or []
+                for bar in symbol_bars[-limit_per_symbol:] if limit_per_symbol else symbol_bars:
+                    if not writer.add_row(renderer.row([symbol] + _serialize_bar(bar))):
+                        truncated = True
+                        break
+                if truncated:
+                    break
+            writer.write(renderer.end({"truncated": truncated or None, "failed_symbols": sorted(failed) or None}))
+            return writer.getvalue()
+        
+        intraday = timeframe_obj.unit_value in [TimeFrameUnit.Minute, TimeFrameUnit.Hour]
+        time_range = f"{start_time.strftime('%Y-%m-%d %H:%M')} to {end_time.strftime('%Y-%m-%d %H:%M')}"
+        writer.write(f"Historical Data for {len(symbols)} symbols ({timeframe} bars, {time_range}):\n")
+        writer.write("---------------------------------------------------\n")
+        
+        truncated = False
+        for symbol in symbols:
+            symbol_bars = bars.get(symbol) or []
+            if limit_per_symbol:
+                symbol_bars = symbol_bars[-limit_per_symbol:]
+            if not symbol_bars:
+                continue
+            lines = [f"{symbol}:\n"]
+            for bar in symbol_bars:
+                time_str = bar.timestamp.strftime('%Y-%m-%d %H:%M:%S') if intraday else bar.timestamp.date()
+                lines.append(f"  {time_str} O:{bar.open:.2f} H:{bar.high:.2f} L:{bar.low:.2f} C:{bar.close:.2f} V:{bar.volume}\n")
+            if not writer.add_row("".join(lines)):
+                truncated = True
+                break
+        
+        footer = _format_batch_footer(symbols, {s: b for s, b in bars.items() if b}, failed)
+        if truncated:
+            footer.append(f"Response truncated after {writer.rows} symbols at the size budget; request fewer symbols or a shorter range.")
+        if footer:
+            writer.write("\n" + "\n".join(footer) + "\n")
+        return writer.getvalue()
+    except Exception as e:
+        return ToolError(f"Error fetching historical data: {str(e)}")
+
+# ============================================================================
+# Market Data Tools - Resampling and Indicators
+# ============================================================================
+
+# Default lookback per indicator when the spec gives none ("sma" vs "sma:50"); VWAP takes no period
+INDICATOR_DEFAULT_PERIODS = {"sma": 20, "ema": 20, "rsi": 14, "atr": 14, "bbands": 20, "vwap": None}
+BBANDS_STDDEV = 2.0
+# Intraday VWAP resets at each session, which starts at midnight exchange time
+MARKET_TIMEZONE = ZoneInfo("America/New_York")
+# Regular session open in seconds after midnight exchange time; intraday buckets count from it
+SESSION_OPEN_SECONDS = 9 * 3600 + 30 * 60
+
+def _exchange_offsets(ts: "np.ndarray") -> "np.ndarray":
+    """UTC offset of exchange time, in seconds, for each timestamp; looked up once per UTC day rather than per bar."""
+    days, inverse = np.unique(ts // 86400, return_inverse=True)
+    offsets = np.array([
+        datetime.fromtimestamp(int(day) * 86400 + 43200, MARKET_TIMEZONE).utcoffset().total_seconds()
+        for day in days
+    ], dtype=np.int64)
+    return offsets[inverse]
+
+def _parse_indicator_spec(spec: str) -> List[tuple]:
+    """Parse an indicator list such as "sma:50,rsi,vwap" into (name, period) pairs."""
+    parsed = []
+    for item in spec.split(","):
+        name, _, period = item.strip().lower().partition(":")
+        if not name:
+            continue
+        if name not in INDICATOR_DEFAULT_PERIODS:
+            raise ValueError(f"Unknown indicator '{name}'. Supported: {', '.join(INDICATOR_DEFAULT_PERIODS)}")
+        if INDICATOR_DEFAULT_PERIODS[name] is None:
+            parsed.append((name, None))
+            continue
+        try:
+            length = int(period) if period else INDICATOR_DEFAULT_PERIODS[name]
+        except ValueError:
+            raise ValueError(f"Invalid period '{period}' for indicator '{name}'")
+        if length < 1:
+            raise ValueError(f"Period for indicator '{name}' must be at least 1")
+        parsed.append((name, length))
+    if not parsed:
+        raise ValueError("No indicators requested")
+    return parsed
+
+def _bucket_keys(ts: "np.ndarray", timeframe: TimeFrame) -> "np.ndarray":
+    """
+    Assign each base bar timestamp to a bucket of the target timeframe.
+
+    Intraday keys are the buckets' UTC start times, counted from the session open in exchange
+    time, so a 4Hour bucket starts at 09:30 rather than mixing pre-market into the first candle.
+    """
+    unit = timeframe.unit_value
+    if unit in (TimeFrameUnit.Minute, TimeFrameUnit.Hour):
+        width = timeframe.amount * _TIMEFRAME_UNIT_SECONDS[unit]
+        offsets = _exchange_offsets(ts)
+        return (ts + offsets - SESSION_OPEN_SECONDS) // width * width + SESSION_OPEN_SECONDS - offsets
+    days = ts // 86400
+    if unit == TimeFrameUnit.Day:
+        return days // timeframe.amount
+    if unit == TimeFrameUnit.Week:
+        # The epoch fell on a Thursday; shifting by three days makes weeks start on Monday
+        return (days + 3) // (7 * timeframe.amount)
+    months = ts.astype("datetime64[s]").astype("datetime64[M]").astype(np.int64)
+    return months // timeframe.amount
+
+def _resample_bars(records: List[tuple], timeframe: TimeFrame) -> "Dict[str, np.ndarray]":
+    """
+    Aggregate (ts, o, h, l, c, v, vw) base bars, oldest first, into bars of the target timeframe.
+
+    Intraday buckets are labelled with their start time so a bucket with a missing first minute
+    keeps its session-aligned timestamp; daily and longer buckets use their first trading day.
+    """
+    data = np.array(records, dtype=float).reshape(-1, 7)
+    ts = data[:, 0].astype(np.int64)
+    high, low, close, volume, vwap = data[:, 2], data[:, 3], data[:, 4], data[:, 5], data[:, 6]
+    keys = _bucket_keys(ts, timeframe)
+    starts = np.flatnonzero(np.r_[True, keys[1:] != keys[:-1]])
+    ends = np.r_[starts[1:], len(ts)] - 1
+    # Bars without a VWAP (rare, e.g. zero-volume prints) fall back to the typical price
+    price = np.where(np.isnan(vwap), (high + low + close) / 3, vwap)
+    bucket_volume = np.add.reduceat(volume, starts)
+    with np.errstate(divide="ignore", invalid="ignore"):
+        bucket_vwap = np.add.reduceat(price * volume, starts) / bucket_volume
+    if timeframe.unit_value in (TimeFrameUnit.Minute, TimeFrameUnit.Hour):
+        labels = keys[starts]
+    else:
+        labels = ts[starts]
+    return {
+        "timestamp": labels,
+        "open": data[starts, 1],
+        "high": np.maximum.reduceat(high, starts),
+        "low": np.minimum.reduceat(low, starts),
+        "close": close[ends],
+        "volume": bucket_volume,
+        "vwap": bucket_vwap,
+    }
+
+def _sma(values: "np.ndarray", period: int) -> "np.ndarray":
+    out = np.full(len(values), np.nan)
+    if len(values) >= period:
+        out[period - 1:] = np.lib.stride_tricks.sliding_window_view(values, period).mean(axis=1)
+    return out
+
+def _rolling_std(values: "np.ndarray", period: int) -> "np.ndarray":
+    out = np.full(len(values), np.nan)
+    if len(values) >= period:
+        out[period - 1:] = np.lib.stride_tricks.sliding_window_view(values, period).std(axis=1)
+    return out
+
+def _smooth(values: "np.ndarray", period: int, alpha: float) -> "np.ndarray":
+    """
+    Exponential smoothing seeded with the mean of the first period values.
+
+    alpha=2/(period+1) gives the EMA and alpha=1/period Wilder's smoothing used by RSI and ATR.
+    The recurrence is sequential, so it runs as a scalar loop over plain floats.
+    """
+    out = np.full(len(values), np.nan)
+    if len(values) < period:
+        return out
+    value = float(values[:period].mean())
+    smoothed = [value]
+    for x in values[period:].tolist():
+        value += alpha * (x - value)
+        smoothed.append(value)
+    out[period - 1:] = smoothed
+    return out
+
+def _rsi(close: "np.ndarray", period: int) -> "np.ndarray":
+    out = np.full(len(close), np.nan)
+    if len(close) <= period:
+        return out
+    delta = np.diff(close)
+    gain = _smooth(np.clip(delta, 0, None), period, 1 / period)
+    loss = _smooth(np.clip(-delta, 0, None), period, 1 / period)
+    with np.errstate(divide="ignore", invalid="ignore"):
+        out[1:] = np.where(loss == 0, np.where(gain == 0, 50.0, 100.0), 100 - 100 / (1 + gain / loss))
+    return out
+
+def _atr(high: "np.ndarray", low: "np.ndarray", close: "np.ndarray", period: int) -> "np.ndarray":
+    true_range = high - low
+    true_range[1:] = np.maximum.reduce([
+        high[1:] - low[1:], np.abs(high[1:] - close[:-1]), np.abs(low[1:] - close[:-1])
+    ])
+    return _smooth(true_range, period, 1 / period)
+
+def _session_vwap(bars: "Dict[str, np.ndarray]", intraday: bool) -> "np.ndarray":
+    """Cumulative VWAP, reset at each trading session for intraday frames and anchored at the first bar otherwise."""
+    ts = bars["timestamp"]
+    if intraday:
+        sessions = (ts + _exchange_offsets(ts)) // 86400
+    else:
+        sessions = np.zeros(len(ts), dtype=np.int64)
+    volume = np.nan_to_num(bars["volume"])
+    dollars = np.nan_to_num(bars["vwap"] * volume)
+    # Cumulative sums restarted at each session boundary
+    starts = np.flatnonzero(np.r_[True, sessions[1:] != sessions[:-1]])
+    first = np.zeros(len(ts), dtype=np.int64)
+    first[starts] = starts
+    first = np.maximum.accumulate(first)
+    total_dollars, total_volume = np.cumsum(dollars), np.cumsum(volume)
+    session_dollars = total_dollars - total_dollars[first] + dollars[first]
+    session_volume = total_volume - total_volume[first] + volume[first]
+    with np.errstate(divide="ignore", invalid="ignore"):
+        return session_dollars / session_volume
+
+def _build_indicator_table(records: List[tuple], timeframe: TimeFrame, indicators: List[tuple]) -> tuple:
+    """
+    Resample base bars to the timeframe and compute the requested indicator series.
+
+    Returns:
+        tuple: (bars, columns) where bars maps OHLCV fields to arrays and columns maps
+            indicator column names (e.g. "sma_20", "bb_upper_20") to arrays of the same length
     """
-    try:
-        # Create the request object with all available parameters
-        request_params = StockLatestTradeRequest(
-            symbol_or_symbols=symbol,
-            feed=feed,
-            currency=currency
-        )
-        
-        # Get the latest trade
-        latest_trades = stock_historical_data_client.get_stock_latest_trade(request_params)
-        
-        if symbol in latest_trades:
-            trade = latest_trades[symbol]
-            return f"""
-                Latest Trade for {symbol}:
-                ---------------------------
-                Time: {trade.timestamp}
-                Price: ${float(trade.price):.6f}
-                Size: {trade.size}
-                Exchange: {trade.exchange}
-                ID: {trade.id}
-                Conditions: {trade.conditions}
-                """
-        else:
-            return f"No latest trade data found for {symbol}."
-    except Exception as e:
-        return f"Error fetching latest trade: {str(e)}"
+    intraday = timeframe.unit_value in (TimeFrameUnit.Minute, TimeFrameUnit.Hour)
+    bars = _resample_bars(records, timeframe)
+    high, low, close = bars["high"], bars["low"], bars["close"]
+    columns = {}
+    for name, period in indicators:
+        if name == "sma":
+            columns[f"sma_{period}"] = _sma(close, period)
+        elif name == "ema":
+            columns[f"ema_{period}"] = _smooth(close, period, 2 / (period + 1))
+        elif name == "rsi":
+            columns[f"rsi_{period}"] = _rsi(close, period)
+        elif name == "atr":
+            columns[f"atr_{period}"] = _atr(high, low, close, period)
+        elif name == "bbands":
+            middle = _sma(close, period)
+            width = BBANDS_STDDEV * _rolling_std(close, period)
+            columns[f"bb_upper_{period}"] = middle + width
+            columns[f"bb_middle_{period}"] = middle
+            columns[f"bb_lower_{period}"] = middle - width
+        elif name == "vwap":
+            columns["vwap"] = _session_vwap(bars, intraday)
+    return bars, columns
+
+def _indicator_value(value: float) -> Optional[float]:
+    """Round a series value for output; warm-up values (NaN) become None."""
+    return None if np.isnan(value) else round(float(value), 4)
+
+async def _load_base_bars(symbol: str, timeframe: TimeFrame, start_time: datetime, end_time: datetime) -> List[tuple]:
+    """Load base bars as (ts, o, h, l, c, v, vw) tuples, through the bar store when it is enabled."""
+    if bar_store is not None:
+        start, end = await _ensure_bars_stored(symbol, timeframe, start_time, end_time)
+        return await _run_blocking(bar_store.read_columns, symbol, timeframe.value, start, end)
+    rows = await _fetch_bar_range(symbol, timeframe, _epoch_seconds(start_time), _epoch_seconds(end_time))
+    return [
+        (_epoch_seconds(datetime.fromisoformat(r["t"])),
+         r.get("o"), r.get("h"), r.get("l"), r.get("c"), r.get("v"), r.get("vw"))
+        for r in rows
+    ]
 
 @mcp.tool()
-async def get_stock_latest_bar(
+async def get_stock_indicators(
     symbol: str,
-    feed: Optional[DataFeed] = None,
-    currency: Optional[SupportedCurrencies] = None
+    timeframe: str = "5Min",
+    indicators: str = "sma,ema,rsi,atr,bbands,vwap",
+    days: int = 5,
+    start: Optional[str] = None,
+    end: Optional[str] = None,
+    tail: int = 10,
+    format: Optional[str] = None
 ) -> str:
-    """Get the latest minute bar for a stock.
-    
+    """
+    Computes technical indicators server-side and returns the latest values plus a short series tail.
+
+    Bars are built locally from 1Min bars (intraday timeframes) or 1Day bars (daily and longer),
+    reusing the local bar store, so any timeframe can be analysed without a separate API pull.
+    Intraday bars are anchored to the 09:30 ET session open: 1Hour bars start on the half hour
+    and 4Hour bars at 09:30 and 13:30, with extended-hours bars in the buckets before and after.
+
     Args:
-        symbol: Stock ticker symbol (e.g., 'AAPL', 'MSFT')
-        feed: The stock data feed to retrieve from (optional)
-        currency: The currency for prices (optional, defaults to USD)
-    
+        symbol (str): Stock ticker symbol (e.g., AAPL, MSFT)
+        timeframe (str): Target bar timeframe, e.g. "5Min", "15Min", "1Hour", "1Day", "1Week" (default: "5Min")
+        indicators (str): Comma-separated indicators with optional periods, e.g. "sma:50,ema:12,rsi,vwap".
+            Supported: sma, ema, rsi, atr, bbands (Bollinger Bands, 2 standard deviations) and vwap
+            (session-anchored for intraday timeframes). Defaults: sma/ema/bbands 20, rsi/atr 14.
+        days (int): Number of days to look back (default: 5, ignored if start is provided)
+        start (Optional[str]): Start time in ISO format (e.g., "2023-01-01T09:30:00" or "2023-01-01")
+        end (Optional[str]): End time in ISO format (default: now)
+        tail (int): Number of most recent bars to include with their indicator values (default: 10)
+        format (Optional[str]): Output format - "text", "json" or "csv" (default: MCP_OUTPUT_FORMAT)
+
     Returns:
-        A formatted string containing the latest bar details or an error message
+        str: Latest indicator values followed by the last `tail` bars with their indicator values
     """
     try:
-        # Create the request object with all available parameters
-        request_params = StockLatestBarRequest(
-            symbol_or_symbols=symbol,
-            feed=feed,
-            currency=currency
-        )
-        
-        # Get the latest bar
-        latest_bars = stock_historical_data_client.get_stock_latest_bar(request_params)
-        
-        if symbol in latest_bars:
-            bar = latest_bars[symbol]
-            return f"""
-                Latest Minute Bar for {symbol}:
-                ---------------------------
-                Time: {bar.timestamp}
-                Open: ${float(bar.open):.2f}
-                High: ${float(bar.high):.2f}
-                Low: ${float(bar.low):.2f}
-                Close: ${float(bar.close):.2f}
-                Volume: {bar.volume}
-                """
-        else:
-            return f"No latest bar data found for {symbol}."
+        fmt = _resolve_format(format)
+        timeframe_obj = parse_timeframe_with_enums(timeframe)
+        if timeframe_obj is None:
+            return ToolError(f"Error: Invalid timeframe '{timeframe}'. Supported formats: 1Min, 5Min, 15Min, 1Hour, 4Hour, 1Day, 1Week, 1Month, etc.")
+        try:
+            requested = _parse_indicator_spec(indicators)
+        except ValueError as e:
+            return ToolError(f"Error: {str(e)}")
+
+        try:
+            start_time = _parse_iso_datetime(start) if start else datetime.now(timezone.utc) - timedelta(days=days)
+            end_time = _parse_iso_datetime(end) if end else datetime.now(timezone.utc)
+        except ValueError:
+            return ToolError("Error: Invalid start/end time format. Use ISO format like '2023-01-01T09:30:00' or '2023-01-01'")
+
+        intraday = timeframe_obj.unit_value in (TimeFrameUnit.Minute, TimeFrameUnit.Hour)
+        base = TimeFrame.Minute if intraday else TimeFrame.Day
+        records = await _load_base_bars(symbol, base, start_time, end_time)
+        if not records:
+            return f"No historical data found for {symbol} in the specified time range."
+        bars, columns = await _run_blocking(_build_indicator_table, records, timeframe_obj, requested)
+
+        count = len(bars["timestamp"])
+        first = max(count - max(tail, 1), 0)
+        names = list(columns)
+
+        def time_label(i: int) -> str:
+            stamp = datetime.fromtimestamp(int(bars["timestamp"][i]), timezone.utc)
+            return stamp.strftime('%Y-%m-%d %H:%M') if intraday else stamp.date().isoformat()
+
+        if fmt != "text":
+            rows = [
+                [datetime.fromtimestamp(int(bars["timestamp"][i]), timezone.utc).isoformat()]
+                + [_indicator_value(bars[field][i]) for field in ("open", "high", "low", "close", "volume")]
+                + [_indicator_value(columns[name][i]) for name in names]
+                for i in range(first, count)
+            ]
+            return _render_table(fmt, ["timestamp", "open", "high", "low", "close", "volume"] + names, rows,
+                                 {"symbol": symbol, "timeframe": timeframe, "source": base.value, "bars": count})
+
+        def value_text(value: float) -> str:
+            return "n/a" if np.isnan(value) else f"{value:.2f}"
+
+        latest = count - 1
+        result = [
+            f"Indicators for {symbol} ({timeframe} bars built from {base.value}, {count} bars):",
+            "-" * 40,
+            f"Latest ({time_label(latest)}): Close: ${bars['close'][latest]:.2f}",
+        ]
+        result += [f"  {name}: {value_text(columns[name][latest])}" for name in names]
+        if tail > 0:
+            result += ["", f"Last {count - first} bars:"]
+            for i in range(first, count):
+                values = ", ".join(f"{name}: {value_text(columns[name][i])}" for name in names)
+                result.append(f"Time: {time_label(i)}, Close: ${bars['close'][i]:.2f}, {values}")
+        return "\n".join(result)
     except Exception as e:
-        return f"Error fetching latest bar: {str(e)}"
+        return ToolError(f"Error computing indicators for {symbol}: {str(e)}")
 
 # ============================================================================
 # Market Data Tools - Stock Snapshot Data with Helper Functions
@@ -567,7 +3673,8 @@ def _format_trade_data(trade) -> str:
 async def get_stock_snapshot(
     symbol_or_symbols: Union[str, List[str]], 
     feed: Optional[DataFeed] = None,
-    currency: Optional[SupportedCurrencies] = None
+    currency: Optional[SupportedCurrencies] = None,
+    format: Optional[str] = None
 ) -> str:
     """
     Retrieves comprehensive snapshots of stock symbols including latest trade, quote, minute bar, daily bar, and previous daily bar.
@@ -576,6 +3683,7 @@ async def get_stock_snapshot(
         symbol_or_symbols: Single stock symbol or list of stock symbols (e.g., 'AAPL' or ['AAPL', 'MSFT'])
         feed: The stock data feed to retrieve from (optional)
         currency: The currency the data should be returned in (default: USD)
+        format: Output format - "text", "json" or "csv" (default: MCP_OUTPUT_FORMAT)
     
     Returns:
         Formatted string with comprehensive snapshots including:
@@ -586,12 +3694,16 @@ async def get_stock_snapshot(
         - previous_daily_bar: Previous trading day's OHLCV bar
     """
     try:
+        fmt = _resolve_format(format)
         # Create and execute request
         request = StockSnapshotRequest(symbol_or_symbols=symbol_or_symbols, feed=feed, currency=currency)
-        snapshots = stock_historical_data_client.get_stock_snapshot(request)
+        snapshots = await _cached_api("get_stock_snapshot", stock_historical_data_client.get_stock_snapshot, request)
         
         # Format response
         symbols = [symbol_or_symbols] if isinstance(symbol_or_symbols, str) else symbol_or_symbols
+        if fmt != "text":
+            rows = [_serialize_stock_snapshot(symbol, snapshots[symbol]) for symbol in symbols if snapshots.get(symbol)]
+            return _render_table(fmt, STOCK_SNAPSHOT_COLUMNS, rows)
         results = ["Stock Snapshots:", "=" * 15, ""]
         
         for symbol in symbols:
@@ -619,7 +3731,7 @@ async def get_stock_snapshot(
         error_message = str(api_error)
         # Handle specific data feed subscription errors
         if "subscription" in error_message.lower() and ("sip" in error_message.lower() or "premium" in error_message.lower()):
-            return f"""
+            return ToolError(f"""
                     Error: Premium data feed subscription required.
 
                     The requested data feed requires a premium subscription. Available data feeds:
@@ -633,25 +3745,559 @@ async def get_stock_snapshot(
                     To use premium feeds (SIP, DELAYED_SIP, OTC), please upgrade your subscription.
 
                     Original error: {error_message}
-                    """
+                    """)
         else:
             return f"API Error retrieving stock snapshots: {error_message}"
             
     except Exception as e:
-        return f"Error retrieving stock snapshots: {str(e)}"
+        return ToolError(f"Error retrieving stock snapshots: {str(e)}")
+
+# ============================================================================
+# Market Data Tools - Market Scanner
+# ============================================================================
+
+# Raw snapshot fields held per symbol, and the columns scans can filter and sort on
+SCAN_FIELDS = ("price", "prev_close", "open", "high", "low", "volume", "prev_volume", "bid", "ask")
+SCAN_COLUMNS = ("price", "change_pct", "gap_pct", "volume", "prev_volume", "rel_volume",
+                "dollar_volume", "spread_pct", "range_pct")
+# Preset name -> (filters, sort column, descending)
+SCAN_PRESETS = {
+    "gappers": ("gap_pct > 0, price >= 1, volume >= 10000", "gap_pct", True),
+    "gap_down": ("gap_pct < 0, price >= 1, volume >= 10000", "gap_pct", False),
+    "gainers": ("price >= 1, volume >= 10000", "change_pct", True),
+    "losers": ("price >= 1, volume >= 10000", "change_pct", False),
+    "unusual_volume": ("price >= 1, prev_volume >= 50000", "rel_volume", True),
+    "most_active": ("", "dollar_volume", True),
+}
+SCAN_OPERATORS = {">": operator.gt, ">=": operator.ge, "<": operator.lt, "<=": operator.le,
+                  "==": operator.eq, "!=": operator.ne}
+_SCAN_CONDITION = re.compile(r"^\s*(\w+)\s*(>=|<=|==|!=|>|<)\s*(-?\d+(?:\.\d*)?(?:[eE][-+]?\d+)?)\s*$")
+
+def _parse_scan_filters(spec: Optional[str]) -> List[tuple]:
+    """Parse "gap_pct > 3, price >= 5" into (column, operator, value) conditions that are ANDed."""
+    conditions = []
+    for part in filter(None, (p.strip() for p in (spec or "").split(","))):
+        match = _SCAN_CONDITION.match(part)
+        if not match:
+            raise ValueError(f"Invalid filter '{part}'. Use '<column> <op> <number>', e.g. 'gap_pct > 3'")
+        column, op, value = match.groups()
+        if column not in SCAN_COLUMNS:
+            raise ValueError(f"Unknown scan column '{column}'. Supported: {', '.join(SCAN_COLUMNS)}")
+        conditions.append((column, SCAN_OPERATORS[op], float(value)))
+    return conditions
+
+def _snapshot_fields(snapshot) -> tuple:
+    """Project a stock snapshot onto SCAN_FIELDS; missing parts become None (NaN in the table)."""
+    trade, quote = snapshot.latest_trade, snapshot.latest_quote
+    daily, previous = snapshot.daily_bar, snapshot.previous_daily_bar
+    return (
+        trade.price if trade else None,
+        previous.close if previous else None,
+        daily.open if daily else None,
+        daily.high if daily else None,
+        daily.low if daily else None,
+        daily.volume if daily else None,
+        previous.volume if previous else None,
+        quote.bid_price if quote else None,
+        quote.ask_price if quote else None,
+    )
+
+class SnapshotTable:
+    """
+    Columnar in-memory table of snapshots over the tradable US equity universe.
+
+    A reload pulls the whole universe (from the asset index) in parallel multi-symbol
+    snapshot requests of MCP_SCAN_CHUNK_SIZE symbols, and happens once the table is
+    older than MCP_SCAN_REFRESH_SECONDS. Between reloads the rows of symbols subscribed
+    on the live stream are patched from it on every scan, so they stay current without
+    REST calls. Scans evaluate over whole NumPy columns and only materialize the top rows.
+    Over the memory budget, a table idle for MEMORY_EVICT_IDLE_SECONDS is dropped and
+    reloaded by the next scan.
+    """
+
+    def __init__(self, refresh_seconds: float):
+        self.refresh_seconds = refresh_seconds
+        self.symbols: List[str] = []
+        self.columns: Dict[str, "np.ndarray"] = {}
+        self.loaded_at: Optional[float] = None
+        self.failed = 0
+        self.bytes = 0
+        self._used = 0.0
+        self._rows: Dict[str, int] = {}
+        self._lock = asyncio.Lock()
+
+    @property
+    def age(self) -> Optional[float]:
+        return None if self.loaded_at is None else time.monotonic() - self.loaded_at
+
+    async def load(self) -> "SnapshotTable":
+        """Return the table, reloading it first when stale; concurrent scans share one reload."""
+        self._used = time.monotonic()
+        async with self._lock:
+            if self.age is None or self.age >= self.refresh_seconds:
+                index = await asset_index.load()
+                universe = sorted(index.filter(asset_class="us_equity", status="active", tradable=True))
+                snapshots, failed = await _fetch_symbol_chunks(
+                    stock_historical_data_client.get_stock_snapshot,
+                    lambda chunk: StockSnapshotRequest(symbol_or_symbols=chunk),
+                    universe,
+                    MCP_SCAN_CHUNK_SIZE
+                )
+                await _run_blocking(self._build, snapshots)
+                self.failed = len(failed)
+        self._patch_from_stream()
+        return self
+
+    def _build(self, snapshots: Dict[str, Any]) -> None:
+        symbols = sorted(s for s, snapshot in snapshots.items() if snapshot is not None)
+        table = np.array([_snapshot_fields(snapshots[s]) for s in symbols], dtype=float).reshape(-1, len(SCAN_FIELDS))
+        self.columns = {field: table[:, i] for i, field in enumerate(SCAN_FIELDS)}
+        self.symbols = symbols
+        self._rows = {symbol: i for i, symbol in enumerate(symbols)}
+        self.bytes = table.nbytes + _approx_size(symbols) + _approx_size(self._rows)
+        self.loaded_at = time.monotonic()
+
+    def evict(self, target: int) -> int:
+        """Drop the whole table when no scan has used it lately; returns the bytes freed."""
+        if self._lock.locked() or time.monotonic() - self._used < MEMORY_EVICT_IDLE_SECONDS:
+            return 0
+        freed, self.bytes = self.bytes, 0
+        self.symbols, self.columns, self._rows, self.loaded_at = [], {}, {}, None
+        return freed
+
+    def _patch_from_stream(self) -> None:
+        columns = self.columns
+        for symbol in market_stream.subscribed:
+            row = self._rows.get(symbol)
+            if row is None:
+                continue
+            trade = market_stream.get_trade(symbol)
+            if trade is not None:
+                price = float(trade.price)
+                columns["price"][row] = price
+                columns["high"][row] = np.fmax(columns["high"][row], price)
+                columns["low"][row] = np.fmin(columns["low"][row], price)
+            quote = market_stream.get_quote(symbol)
+            if quote is not None:
+                columns["bid"][row] = quote.bid_price
+                columns["ask"][row] = quote.ask_price
+
+    def derived(self) -> Dict[str, "np.ndarray"]:
+        """Compute every scan column over the whole table."""
+        c = self.columns
+        with np.errstate(divide="ignore", invalid="ignore"):
+            quoted = (c["bid"] > 0) & (c["ask"] >= c["bid"])
+            return {
+                "price": c["price"],
+                "change_pct": (c["price"] / c["prev_close"] - 1) * 100,
+                "gap_pct": (c["open"] / c["prev_close"] - 1) * 100,
+                "volume": c["volume"],
+                "prev_volume": c["prev_volume"],
+                "rel_volume": c["volume"] / c["prev_volume"],
+                "dollar_volume": c["price"] * c["volume"],
+                "spread_pct": np.where(quoted, (c["ask"] - c["bid"]) / ((c["ask"] + c["bid"]) / 2) * 100, np.nan),
+                "range_pct": (c["high"] - c["low"]) / c["prev_close"] * 100,
+            }
+
+    def scan(self, conditions: List[tuple], sort_by: str, descending: bool, limit: int) -> tuple:
+        """
+        Filter and rank the table.
+
+        Returns:
+            tuple: (rows as [symbol, *SCAN_COLUMNS] lists for the top `limit` matches, total matches)
+        """
+        columns = self.derived()
+        key = columns[sort_by]
+        mask = ~np.isnan(key)
+        for column, compare, value in conditions:
+            values = columns[column]
+            mask &= compare(values, value) & ~np.isnan(values)  # Rows without the data never match
+        matches = np.flatnonzero(mask)
+        ranking = -key[matches] if descending else key[matches]
+        if limit < matches.size:
+            # Partial selection of the top rows, then a sort of just those
+            keep = np.argpartition(ranking, limit - 1)[:limit]
+            matches, ranking = matches[keep], ranking[keep]
+        top = matches[np.argsort(ranking, kind="stable")]
+        rows = [[self.symbols[i]] + [_indicator_value(columns[c][i]) for c in SCAN_COLUMNS] for i in top]
+        return rows, int(mask.sum())
+
+snapshot_table = SnapshotTable(MCP_SCAN_REFRESH_SECONDS)
+memory_budget.register("snapshot_table", lambda: snapshot_table.bytes, snapshot_table.evict, priority=30)
+
+@mcp.tool()
+async def scan_market(
+    preset: Optional[str] = None,
+    filters: Optional[str] = None,
+    sort_by: Optional[str] = None,
+    descending: Optional[bool] = None,
+    limit: int = 20,
+    format: Optional[str] = None
+) -> str:
+    """
+    Screens the whole tradable US equity universe from an in-memory snapshot table and returns the top matches.
+
+    Snapshots for every symbol are pulled in large parallel batches and reused for
+    MCP_SCAN_REFRESH_SECONDS; symbols subscribed on the live stream are kept current in between.
+
+    Args:
+        preset (Optional[str]): Ready-made scan: "gappers", "gap_down", "gainers", "losers",
+            "unusual_volume" or "most_active". Its filters are combined with `filters`.
+        filters (Optional[str]): Comma-separated conditions that must all hold, e.g.
+            "gap_pct > 3, price >= 5, price <= 100, rel_volume > 2". Columns: price, change_pct
+            (vs previous close), gap_pct (open vs previous close), volume, prev_volume (previous
+            daily bar), rel_volume (volume / prev_volume), dollar_volume, spread_pct (of mid)
+            and range_pct (day high - low, % of previous close)
+        sort_by (Optional[str]): Column to rank by (default: the preset's, else "change_pct")
+        descending (Optional[bool]): Rank highest first (default: the preset's, else True)
+        limit (int): Number of rows to return (default: 20)
+        format (Optional[str]): Output format - "text", "json" or "csv" (default: MCP_OUTPUT_FORMAT)
+
+    Returns:
+        str: Top `limit` symbols with their scan columns, plus the match count and data age
+    """
+    try:
+        fmt = _resolve_format(format)
+        if preset is not None and preset not in SCAN_PRESETS:
+            return ToolError(f"Error: Unknown preset '{preset}'. Supported: {', '.join(SCAN_PRESETS)}")
+        preset_filters, preset_sort, preset_descending = SCAN_PRESETS.get(preset, ("", "change_pct", True))
+        sort_by = sort_by or preset_sort
+        descending = preset_descending if descending is None else descending
+        if sort_by not in SCAN_COLUMNS:
+            return ToolError(f"Error: Unknown sort column '{sort_by}'. Supported: {', '.join(SCAN_COLUMNS)}")
+        try:
+            conditions = _parse_scan_filters(preset_filters) + _parse_scan_filters(filters)
+        except ValueError as e:
+            return ToolError(f"Error: {str(e)}")
+        limit = max(1, limit)
+
+        table = await snapshot_table.load()
+        rows, total = table.scan(conditions, sort_by, descending, limit)
+        meta = {"preset": preset, "sort_by": sort_by, "descending": descending, "matches": total,
+                "universe": len(table.symbols), "age_seconds": round(table.age or 0, 1)}
+        if fmt != "text":
+            return _render_table(fmt, ["symbol", *SCAN_COLUMNS], rows, meta)
+        if not rows:
+            return f"No symbols matched the scan across {len(table.symbols):,} symbols."
+
+        def number(value, spec: str, suffix: str = "") -> str:
+            return "n/a" if value is None else f"{value:{spec}}{suffix}"
+
+        title = f"Market Scan ({preset})" if preset else "Market Scan"
+        result = [
+            f"{title}: top {len(rows)} of {total:,} matches across {len(table.symbols):,} symbols, "
+            f"ranked by {sort_by} {'descending' if descending else 'ascending'} (data {table.age:.0f}s old)",
+            "-" * 40,
+        ]
+        for symbol, price, change, gap, volume, _, rel_volume, _, spread, day_range in rows:
+            result.append(
+                f"{symbol}: ${number(price, ',.2f')}, Change {number(change, '+.2f', '%')}, "
+                f"Gap {number(gap, '+.2f', '%')}, Volume {number(volume, ',.0f')} ({number(rel_volume, '.2f', 'x')} prev), "
+                f"Spread {number(spread, '.2f', '%')}, Range {number(day_range, '.2f', '%')}"
+            )
+        if table.failed:
+            result.append(f"Note: snapshots for {table.failed:,} symbols could not be loaded.")
+        return "\n".join(result)
+    except Exception as e:
+        return ToolError(f"Error scanning market: {str(e)}")
+
+# ============================================================================
+# Market Data Tools - Tape Export
+# ============================================================================
+
+# Export type -> (endpoint, output columns as (name, raw field, kind)). Kinds: "time"
+# (nanosecond UTC timestamps), "float", "int", "code" (dictionary-encoded string) and
+# "codes" (a list of codes joined with commas, dictionary-encoded).
+TAPE_EXPORTS = {
+    "trades": ("/stocks/trades", (
+        ("timestamp", "t", "time"), ("price", "p", "float"), ("size", "s", "float"),
+        ("exchange", "x", "code"), ("id", "i", "int"), ("conditions", "c", "codes"), ("tape", "z", "code"),
+    )),
+    "quotes": ("/stocks/quotes", (
+        ("timestamp", "t", "time"), ("bid_price", "bp", "float"), ("bid_size", "bs", "float"),
+        ("bid_exchange", "bx", "code"), ("ask_price", "ap", "float"), ("ask_size", "as", "float"),
+        ("ask_exchange", "ax", "code"), ("conditions", "c", "codes"), ("tape", "z", "code"),
+    )),
+    "bars": ("/stocks/bars", (
+        ("timestamp", "t", "time"), ("open", "o", "float"), ("high", "h", "float"), ("low", "l", "float"),
+        ("close", "c", "float"), ("volume", "v", "float"), ("trade_count", "n", "int"), ("vwap", "vw", "float"),
+    )),
+}
+EXPORT_COLUMNS = ["symbol", "path", "files", "rows", "status"]
+
+def _tape_schema(fields: tuple) -> "pa.Schema":
+    types = {
+        "time": pa.timestamp("ns", tz="UTC"),
+        "float": pa.float64(),
+        "int": pa.int64(),
+        "code": pa.dictionary(pa.int32(), pa.string()),
+        "codes": pa.dictionary(pa.int32(), pa.string()),
+    }
+    return pa.schema([(name, types[kind]) for name, _, kind in fields])
+
+def _tape_table(fields: tuple, schema: "pa.Schema", rows: List[Dict[str, Any]]) -> "pa.Table":
+    """Convert one page of raw API rows into an Arrow table with the export schema."""
+    arrays = []
+    for (name, key, kind), field in zip(fields, schema):
+        values = [row.get(key) for row in rows]
+        if kind == "time":
+            arrays.append(pa.array(values, pa.string()).cast(field.type))
+        elif kind in ("code", "codes"):
+            if kind == "codes":
+                values = [",".join(v) if isinstance(v, list) else v for v in values]
+            arrays.append(pa.array(values, pa.string()).dictionary_encode())
+        else:
+            arrays.append(pa.array(values, field.type))
+    return pa.Table.from_arrays(arrays, schema=schema)
+
+class _TapePartWriter:
+    """
+    Writes one part file of an export. Data goes to a temporary name that is renamed
+    into place on close, so a part file on disk is always complete.
+
+    Arrow parts use the IPC stream format: each page carries its own dictionaries, and
+    only the stream format allows a later batch to replace them.
+    """
+
+    def __init__(self, directory: str, index: int, fields: tuple, file_format: str):
+        self.path = os.path.join(directory, f"part-{index:05d}.{file_format}")
+        self._tmp_path = self.path + ".tmp"
+        self.fields = fields
+        self.schema = _tape_schema(fields)
+        self.rows = 0
+        self._sink = None
+        if file_format == "parquet":
+            self._writer = pq.ParquetWriter(self._tmp_path, self.schema, compression="zstd")
+        else:
+            self._sink = pa.OSFile(self._tmp_path, "wb")
+            self._writer = pa.ipc.new_stream(self._sink, self.schema)
+
+    def write(self, rows: List[Dict[str, Any]]) -> None:
+        table = _tape_table(self.fields, self.schema, rows)
+        self._writer.write_table(table)
+        self.rows += table.num_rows
+
+    def close(self) -> None:
+        self._writer.close()
+        if self._sink is not None:
+            self._sink.close()
+        os.replace(self._tmp_path, self.path)
+
+    def abort(self) -> None:
+        try:
+            self._writer.close()
+            if self._sink is not None:
+                self._sink.close()
+        finally:
+            if os.path.exists(self._tmp_path):
+                os.remove(self._tmp_path)
+
+def _read_export_checkpoint(path: str) -> Dict[str, Any]:
+    try:
+        with open(path) as f:
+            return json.load(f)
+    except (OSError, ValueError):
+        return {}
+
+def _write_export_checkpoint(path: str, state: Dict[str, Any]) -> None:
+    with open(path + ".tmp", "w") as f:
+        json.dump(state, f)
+    os.replace(path + ".tmp", path)
+
+def _clear_export_directory(directory: str) -> None:
+    """Remove the part files and checkpoint of an earlier run so a restart starts clean."""
+    try:
+        names = os.listdir(directory)
+    except FileNotFoundError:
+        return
+    for name in names:
+        if name.startswith("part-") or name.startswith("_checkpoint.json"):
+            os.remove(os.path.join(directory, name))
+
+async def _export_symbol(
+    symbol: str,
+    data_type: str,
+    params: Dict[str, Any],
+    directory: str,
+    file_format: str,
+    restart: bool
+) -> List[Any]:
+    """
+    Stream every page for one symbol into part files in directory, resuming from its checkpoint.
+
+    The next page is fetched while the current one is converted and written. The checkpoint
+    records the page token after the last completed part file and the resolved end time, so
+    an interrupted export continues from there up to the same bound.
+    """
+    path, fields = TAPE_EXPORTS[data_type]
+    checkpoint_path = os.path.join(directory, "_checkpoint.json")
+    state = {"page_token": None, "rows": 0, "files": 0, "complete": False, "end": params["end"]}
+    if restart:
+        await _run_blocking(_clear_export_directory, directory)
+    else:
+        state.update(await _run_blocking(_read_export_checkpoint, checkpoint_path))
+    if state["complete"]:
+        return [symbol, directory, state["files"], state["rows"], "already exported"]
+    resumed = state["files"] > 0
+    await _run_blocking(os.makedirs, directory, exist_ok=True)
+
+    def fetch(token: Optional[str]):
+        return asyncio.ensure_future(_call_api(_fetch_data_page, stock_historical_data_client, path, data_type, symbol, {
+            **params, "end": state["end"], "symbols": symbol, "limit": DATA_API_PAGE_LIMIT, "page_token": token,
+        }))
+
+    writer = None
+    pending = fetch(state["page_token"])
+    try:
+        while pending is not None:
+            page, token = await pending
+            pending = fetch(token) if token else None
+            if page:
+                if writer is None:
+                    writer = await _run_blocking(_TapePartWriter, directory, state["files"], fields, file_format)
+                await _run_blocking(writer.write, page)
+            if writer is not None and (writer.rows >= MCP_EXPORT_PART_ROWS or token is None):
+                await _run_blocking(writer.close)
+                state.update(rows=state["rows"] + writer.rows, files=state["files"] + 1, page_token=token)
+                writer = None
+                await _run_blocking(_write_export_checkpoint, checkpoint_path, state)
+        state.update(page_token=None, complete=True)
+        await _run_blocking(_write_export_checkpoint, checkpoint_path, state)
+    except BaseException:
+        if pending is not None:
+            pending.cancel()
+        if writer is not None:
+            await _run_blocking(writer.abort)
+        raise
+    return [symbol, directory, state["files"], state["rows"], "resumed" if resumed else "complete"]
+
+@mcp.tool()
+async def export_market_data(
+    symbols: List[str],
+    start: str,
+    end: Optional[str] = None,
+    data_type: str = "trades",
+    timeframe: str = "1Min",
+    feed: Optional[DataFeed] = None,
+    file_format: str = "parquet",
+    restart: bool = False,
+    format: Optional[str] = None
+) -> str:
+    """
+    Exports historical trades, quotes or bars straight to Parquet or Arrow files on disk
+    and returns only the file locations and row counts, for ranges far too large to return inline.
+
+    Each symbol is downloaded by its own worker (up to MCP_EXPORT_WORKERS at once) into a
+    directory of part files under MCP_EXPORT_DIR. Columns are fixed-width (nanosecond UTC
+    timestamps, float64 prices and sizes) with exchanges, conditions and tape dictionary-encoded.
+    Exports checkpoint after every part file: repeating the same call resumes an interrupted
+    export and skips finished ones.
+
+    Args:
+        symbols (List[str]): Stock ticker symbols to export (e.g., ['AAPL', 'MSFT'])
+        start (str): Start time in ISO format (e.g., "2024-06-03" or "2024-06-03T13:30:00Z")
+        end (Optional[str]): End time in ISO format (default: now, fixed when the export first
+            runs and reused when it resumes)
+        data_type (str): "trades", "quotes" or "bars" (default: "trades")
+        timeframe (str): Bar timeframe for data_type "bars", e.g. "1Min", "1Day" (default: "1Min")
+        feed (Optional[DataFeed]): The stock data feed to retrieve from
+        file_format (str): "parquet" (zstd-compressed) or "arrow" (Arrow IPC stream) (default: "parquet")
+        restart (bool): Delete existing part files and checkpoints and export from the start (default: False)
+        format (Optional[str]): Output format - "text", "json" or "csv" (default: MCP_OUTPUT_FORMAT)
+
+    Returns:
+        str: Per symbol: export directory, number of part files, row count and status
+    """
+    try:
+        fmt = _resolve_format(format)
+        if data_type not in TAPE_EXPORTS:
+            return ToolError(f"Error: Invalid data_type '{data_type}'. Must be one of: {', '.join(TAPE_EXPORTS)}")
+        if file_format not in ("parquet", "arrow"):
+            return ToolError(f"Error: Invalid file_format '{file_format}'. Must be 'parquet' or 'arrow'.")
+        try:
+            start_time = _parse_iso_datetime(start)
+            end_time = _parse_iso_datetime(end) if end else datetime.now(timezone.utc)
+        except ValueError:
+            return ToolError("Error: Invalid start/end time format. Use ISO format like '2024-06-03T13:30:00' or '2024-06-03'")
+        symbols = list(dict.fromkeys(s.strip().upper() for s in symbols if s.strip()))
+        if not symbols:
+            return ToolError("Error: No symbols given.")
+        try:
+            importlib.import_module("pyarrow.parquet")
+        except ImportError:
+            return ToolError("Error: export_market_data requires pyarrow. Install it with: pip install pyarrow")
+
+        params = {
+            "start": _to_rfc3339(start_time),
+            "end": _to_rfc3339(end_time),
+            "feed": feed.value if feed else None,
+        }
+        label = data_type
+        if data_type == "bars":
+            timeframe_obj = parse_timeframe_with_enums(timeframe)
+            if timeframe_obj is None:
+                return ToolError(f"Error: Invalid timeframe '{timeframe}'. Supported formats: 1Min, 5Min, 15Min, 1Hour, 4Hour, 1Day, 1Week, 1Month, etc.")
+            params["timeframe"] = timeframe_obj.value
+            label = f"bars_{timeframe_obj.value}"
+        # The directory is keyed by the arguments, so an open-ended export resumes under the
+        # same key; the end it resolved to on the first run is kept in its checkpoint
+        span = f"{_epoch_seconds(start_time)}-{_epoch_seconds(end_time) if end else 'open'}"
+        if feed:
+            span += f"_{feed.value}"
+        # Each format gets its own dataset and checkpoint, so a finished or interrupted export
+        # in one format is never reported for, or resumed into, the other
+        span += f"_{file_format}"
+
+        workers = asyncio.Semaphore(max(1, MCP_EXPORT_WORKERS))
+        async def export(symbol: str) -> List[Any]:
+            directory = os.path.join(MCP_EXPORT_DIR, label, f"{symbol}_{span}")
+            async with workers:
+                try:
+                    return await _export_symbol(symbol, data_type, params, directory, file_format, restart)
+                except Exception as e:
+                    state = _read_export_checkpoint(os.path.join(directory, "_checkpoint.json"))
+                    return [symbol, directory, state.get("files", 0), state.get("rows", 0), f"failed: {str(e)}"]
+
+        rows = await asyncio.gather(*(export(symbol) for symbol in symbols))
+        total = sum(row[3] for row in rows)
+        if fmt != "text":
+            return _render_table(fmt, EXPORT_COLUMNS, rows, {"data_type": data_type, "file_format": file_format,
+                                                             "total_rows": total})
+        result = [f"Export of {data_type} ({file_format}): {total:,} rows for {len(symbols)} symbols", "-" * 40]
+        for symbol, directory, files, count, status in rows:
+            result.append(f"{symbol}: {count:,} rows in {files} files, {status} -> {directory}")
+        failed = [row[0] for row in rows if row[4].startswith("failed")]
+        if failed:
+            result.append(f"Repeat the call to resume {', '.join(failed)} from the last checkpoint.")
+        return "\n".join(result)
+    except Exception as e:
+        return ToolError(f"Error exporting market data: {str(e)}")
 
 # ============================================================================
 # Order Management Tools
 # ============================================================================
 
 @mcp.tool()
-async def get_orders(status: str = "all", limit: int = 10) -> str:
+async def get_orders(
+    status: str = "all",
+    limit: int = 10,
+    page_token: Optional[str] = None,
+    max_rows: Optional[int] = None,
+    max_bytes: Optional[int] = None,
+    account: Optional[str] = None
+) -> str:
     """
     Retrieves and formats orders with the specified status.
+    Responses stop at the row/byte budget with a status and side breakdown of all
+    fetched orders and a page_token for the rest.
     
     Args:
         status (str): Order status to filter by (open, closed, all)
         limit (int): Maximum number of orders to return (default: 10)
+        page_token (Optional[str]): Continuation token from a previous truncated response
+        max_rows (Optional[int]): Maximum orders in this response (default: MCP_MAX_ROWS)
+        max_bytes (Optional[int]): Approximate maximum response size in bytes (default: MCP_MAX_BYTES)
+        account (Optional[str]): Account to act on, by its MCP_ACCOUNTS name (default: the ALPACA_API_KEY account)
     
     Returns:
         str: Formatted string containing order details including:
@@ -665,29 +4311,31 @@ async def get_orders(status: str = "all", limit: int = 10) -> str:
             - Fill Details (if applicable)
     """
     try:
-        # Convert status string to enum
-        if status.lower() == "open":
-            query_status = QueryOrderStatus.OPEN
-        elif status.lower() == "closed":
-            query_status = QueryOrderStatus.CLOSED
+        try:
+            query = {"status": status, "limit": limit}
+            offset = _resume_listing(page_token, "orders", query).get("offset", 0)
+        except ValueError as e:
+            return ToolError(f"Error: {str(e)}")
+        query_status = ORDER_QUERY_STATUSES.get(status.lower(), QueryOrderStatus.ALL)
+
+        # Open orders are answered from the order mirror when it is live; closed
+        # history is only complete upstream
+        orders = await order_mirror.get_open_orders() if query_status == QueryOrderStatus.OPEN else None
+        if orders is not None:
+            orders = orders[:limit]
         else:
-            query_status = QueryOrderStatus.ALL
-            
-        request_params = GetOrdersRequest(
-            status=query_status,
-            limit=limit
-        )
-        
-        orders = trade_client.get_orders(request_params)
+            orders = await _call_api(trade_client.get_orders, _orders_request(query_status, limit))
         
         if not orders:
             return f"No {status} orders found."
         
-        result = f"{status.capitalize()} Orders (Last {len(orders)}):\n"
-        result += "-----------------------------------\n"
+        writer = ResponseWriter(max_rows or MCP_MAX_ROWS, max_bytes or MCP_MAX_BYTES)
+        writer.write(f"{status.capitalize()} Orders (Last {len(orders)}):\n")
+        writer.write("-----------------------------------\n")
         
-        for order in orders:
-            result += f"""
+        # Offsets count from the newest order, so orders placed in between shift the page
+        for order in orders[offset:]:
+            parts = [f"""
                         Symbol: {order.symbol}
                         ID: {order.id}
                         Type: {order.type}
@@ -695,18 +4343,85 @@ async def get_orders(status: str = "all", limit: int = 10) -> str:
                         Quantity: {order.qty}
                         Status: {order.status}
                         Submitted At: {order.submitted_at}
-                        """
+                        """]
             if hasattr(order, 'filled_at') and order.filled_at:
-                result += f"Filled At: {order.filled_at}\n"
+                parts.append(f"Filled At: {order.filled_at}\n")
                 
             if hasattr(order, 'filled_avg_price') and order.filled_avg_price:
-                result += f"Filled Price: ${float(order.filled_avg_price):.2f}\n"
+                parts.append(f"Filled Price: ${float(order.filled_avg_price):.2f}\n")
                 
-            result += "-----------------------------------\n"
-            
-        return result
+            parts.append("-----------------------------------\n")
+            if not writer.add_row("".join(parts)):
+                break
+        
+        shown = offset + writer.rows
+        if shown < len(orders):
+            _listing_summary(writer, offset, len(orders), "orders", {
+                "status": Counter(_order_status(order) for order in orders),
+                "side": Counter(_serialize_value(order.side) for order in orders),
+            }, _listing_cursor("orders", query, offset=shown))
+        return writer.getvalue()
     except Exception as e:
-        return f"Error fetching orders: {str(e)}"
+        return ToolError(f"Error fetching orders: {str(e)}")
+
+def _default_client_order_id() -> str:
+    """Unique client order id; the random suffix keeps orders submitted in the same second distinct."""
+    return f"order_{int(time.time())}_{uuid.uuid4().hex[:8]}"
+
+def _build_stock_order_request(
+    symbol: str,
+    side: str,
+    quantity: float,
+    order_type: str = "market",
+    time_in_force: str = "day",
+    limit_price: float = None,
+    stop_price: float = None,
+    trail_price: float = None,
+    trail_percent: float = None,
+    extended_hours: bool = False,
+    client_order_id: str = None
+):
+    """
+    Validate stock order parameters and build the matching Alpaca order request.
+
+    Raises:
+        ValueError: If a parameter is invalid or a price required by the order type is missing
+    """
+    order_side = ORDER_SIDES.get(side.lower())
+    if order_side is None:
+        raise ValueError(f"Invalid order side: {side}. Must be 'buy' or 'sell'.")
+
+    if isinstance(time_in_force, TimeInForce):
+        tif_enum = time_in_force
+    elif isinstance(time_in_force, str):
+        tif_enum = EQUITY_TIME_IN_FORCE.get(time_in_force.upper())
+        if tif_enum is None:
+            raise ValueError(f"Invalid time_in_force: {time_in_force}. Valid options are: DAY, GTC, OPG, CLS, IOC, FOK")
+    else:
+        raise ValueError(f"Invalid time_in_force type: {type(time_in_force)}. Must be string or TimeInForce enum.")
+
+    template = STOCK_ORDER_TEMPLATES.get(order_type.upper())
+    if template is None:
+        raise ValueError(f"Invalid order type: {order_type}. Must be one of: MARKET, LIMIT, STOP, STOP_LIMIT, TRAILING_STOP.")
+    request_class, type_enum, price_fields, require_all, missing_message = template
+    prices = {"limit_price": limit_price, "stop_price": stop_price, "trail_price": trail_price,
+              "trail_percent": trail_percent}
+    prices = {field: prices[field] for field in price_fields}
+    present = [value is not None for value in prices.values()]
+    if price_fields and not (all(present) if require_all else any(present)):
+        raise ValueError(missing_message)
+
+    order_data = request_class(
+        symbol=symbol,
+        qty=quantity,
+        side=order_side,
+        type=type_enum,
+        time_in_force=tif_enum,
+        extended_hours=extended_hours,
+        client_order_id=client_order_id or _default_client_order_id(),
+        **prices
+    )
+    return order_data
 
 @mcp.tool()
 async def place_stock_order(
@@ -720,7 +4435,8 @@ async def place_stock_order(
     trail_price: float = None,
     trail_percent: float = None,
     extended_hours: bool = False,
-    client_order_id: str = None
+    client_order_id: str = None,
+    account: Optional[str] = None
 ) -> str:
     """
     Places an order of any supported type (MARKET, LIMIT, STOP, STOP_LIMIT, TRAILING_STOP) using the correct Alpaca request class.
@@ -738,114 +4454,23 @@ async def place_stock_order(
         trail_percent (float): Trail percent (for TRAILING_STOP)
         extended_hours (bool): Allow execution during extended hours (default: False)
         client_order_id (str): Optional custom identifier for the order
+        account (Optional[str]): Account to act on, by its MCP_ACCOUNTS name (default: the ALPACA_API_KEY account)
 
     Returns:
         str: Formatted string containing order details or error message.
     """
     try:
-        # Validate side
-        if side.lower() == "buy":
-            order_side = OrderSide.BUY
-        elif side.lower() == "sell":
-            order_side = OrderSide.SELL
-        else:
-            return f"Invalid order side: {side}. Must be 'buy' or 'sell'."
-
-        # Validate and convert time_in_force to enum
-        tif_enum = None
-        if isinstance(time_in_force, TimeInForce):
-            tif_enum = time_in_force
-        elif isinstance(time_in_force, str):
-            # Convert string to TimeInForce enum
-            time_in_force_upper = time_in_force.upper()
-            if time_in_force_upper == "DAY":
-                tif_enum = TimeInForce.DAY
-            elif time_in_force_upper == "GTC":
-                tif_enum = TimeInForce.GTC
-            elif time_in_force_upper == "OPG":
-                tif_enum = TimeInForce.OPG
-            elif time_in_force_upper == "CLS":
-                tif_enum = TimeInForce.CLS
-            elif time_in_force_upper == "IOC":
-                tif_enum = TimeInForce.IOC
-            elif time_in_force_upper == "FOK":
-                tif_enum = TimeInForce.FOK
-            else:
-                return f"Invalid time_in_force: {time_in_force}. Valid options are: DAY, GTC, OPG, CLS, IOC, FOK"
-        else:
-            return f"Invalid time_in_force type: {type(time_in_force)}. Must be string or TimeInForce enum."
-
-        # Validate order_type
-        order_type_upper = order_type.upper()
-        if order_type_upper == "MARKET":
-            order_data = MarketOrderRequest(
-                symbol=symbol,
-                qty=quantity,
-                side=order_side,
-                type=OrderType.MARKET,
-                time_in_force=tif_enum,
-                extended_hours=extended_hours,
-                client_order_id=client_order_id or f"order_{int(time.time())}"
-            )
-        elif order_type_upper == "LIMIT":
-            if limit_price is None:
-                return "limit_price is required for LIMIT orders."
-            order_data = LimitOrderRequest(
-                symbol=symbol,
-                qty=quantity,
-                side=order_side,
-                type=OrderType.LIMIT,
-                time_in_force=tif_enum,
-                limit_price=limit_price,
-                extended_hours=extended_hours,
-                client_order_id=client_order_id or f"order_{int(time.time())}"
-            )
-        elif order_type_upper == "STOP":
-            if stop_price is None:
-                return "stop_price is required for STOP orders."
-            order_data = StopOrderRequest(
-                symbol=symbol,
-                qty=quantity,
-                side=order_side,
-                type=OrderType.STOP,
-                time_in_force=tif_enum,
-                stop_price=stop_price,
-                extended_hours=extended_hours,
-                client_order_id=client_order_id or f"order_{int(time.time())}"
-            )
-        elif order_type_upper == "STOP_LIMIT":
-            if stop_price is None or limit_price is None:
-                return "Both stop_price and limit_price are required for STOP_LIMIT orders."
-            order_data = StopLimitOrderRequest(
-                symbol=symbol,
-                qty=quantity,
-                side=order_side,
-                type=OrderType.STOP_LIMIT,
-                time_in_force=tif_enum,
-                stop_price=stop_price,
-                limit_price=limit_price,
-                extended_hours=extended_hours,
-                client_order_id=client_order_id or f"order_{int(time.time())}"
-            )
-        elif order_type_upper == "TRAILING_STOP":
-            if trail_price is None and trail_percent is None:
-                return "Either trail_price or trail_percent is required for TRAILING_STOP orders."
-            order_data = TrailingStopOrderRequest(
-                symbol=symbol,
-                qty=quantity,
-                side=order_side,
-                type=OrderType.TRAILING_STOP,
-                time_in_force=tif_enum,
-                trail_price=trail_price,
-                trail_percent=trail_percent,
-                extended_hours=extended_hours,
-                client_order_id=client_order_id or f"order_{int(time.time())}"
+        try:
+            order_data = _build_stock_order_request(
+                symbol, side, quantity, order_type, time_in_force, limit_price, stop_price,
+                trail_price, trail_percent, extended_hours, client_order_id
             )
-        else:
-            return f"Invalid order type: {order_type}. Must be one of: MARKET, LIMIT, STOP, STOP_LIMIT, TRAILING_STOP."
+        except ValueError as e:
+            return str(e)
 
         # Submit order
-        order = trade_client.submit_order(order_data)
+        order = await _call_api(trade_client.submit_order, order_data)
+        order_mirror.record(order)
         return f"""
 Order Placed Successfully:
 -------------------------
@@ -859,19 +4484,22 @@ Status: {order.status}
 Client Order ID: {order.client_order_id}
 """
     except Exception as e:
-        return f"Error placing order: {str(e)}"
+        return ToolError(f"Error placing order: {str(e)}")
 
 @mcp.tool()
-async def cancel_all_orders() -> str:
+async def cancel_all_orders(account: Optional[str] = None) -> str:
     """
     Cancel all open orders.
     
+    Args:
+        account (Optional[str]): Account to act on, by its MCP_ACCOUNTS name (default: the ALPACA_API_KEY account)
+    
     Returns:
         A formatted string containing the status of each cancelled order.
     """
     try:
         # Cancel all orders
-        cancel_responses = trade_client.cancel_orders()
+        cancel_responses = await _call_api(trade_client.cancel_orders)
         
         if not cancel_responses:
             return "No orders were found to cancel."
@@ -891,22 +4519,23 @@ async def cancel_all_orders() -> str:
         return "\n".join(response_parts)
         
     except Exception as e:
-        return f"Error cancelling orders: {str(e)}"
+        return ToolError(f"Error cancelling orders: {str(e)}")
 
 @mcp.tool()
-async def cancel_order_by_id(order_id: str) -> str:
+async def cancel_order_by_id(order_id: str, account: Optional[str] = None) -> str:
     """
     Cancel a specific order by its ID.
     
     Args:
         order_id: The UUID of the order to cancel
+        account (Optional[str]): Account to act on, by its MCP_ACCOUNTS name (default: the ALPACA_API_KEY account)
         
     Returns:
         A formatted string containing the status of the cancelled order.
     """
     try:
         # Cancel the specific order
-        response = trade_client.cancel_order_by_id(order_id)
+        response = await _call_api(trade_client.cancel_order_by_id, order_id)
         
         # Format the response
         status = "Success" if response.status == 200 else "Failed"
@@ -923,14 +4552,206 @@ async def cancel_order_by_id(order_id: str) -> str:
         return result
         
     except Exception as e:
-        return f"Error cancelling order {order_id}: {str(e)}"
+        return ToolError(f"Error cancelling order {order_id}: {str(e)}")
+
+@mcp.tool()
+async def wait_for_order_status(order_id: str, status: str = "filled", timeout: float = 30.0, account: Optional[str] = None) -> str:
+    """
+    Waits for an order to reach a status, instead of polling get_orders.
+    
+    Returns as soon as the order reaches one of the requested statuses, or a closed
+    status (filled, canceled, expired, rejected, replaced) from which it cannot move on.
+    
+    Args:
+        order_id (str): The UUID of the order to watch
+        status (str): Target status, or several separated by commas, e.g. "filled" or
+            "partially_filled,filled" (default: "filled")
+        timeout (float): Maximum seconds to wait, up to 300 (default: 30)
+        account (Optional[str]): Account to act on, by its MCP_ACCOUNTS name (default: the ALPACA_API_KEY account)
+    
+    Returns:
+        str: Whether the status was reached, plus the order's current status and fill details
+    """
+    try:
+        valid_statuses = {s.value for s in OrderStatus}
+        statuses = {s.strip().lower() for s in status.split(",") if s.strip()}
+        invalid = statuses - valid_statuses
+        if not statuses or invalid:
+            return ToolError(f"Error: Invalid status '{status}'. Must be one of: {', '.join(sorted(valid_statuses))}")
+        
+        started = time.monotonic()
+        order = await order_mirror.wait_for_status(order_id, statuses, min(max(timeout, 0.0), 300.0))
+        waited = time.monotonic() - started
+        current = _order_status(order)
+        
+        if current in statuses:
+            outcome = f"Order reached status '{current}' after {waited:.1f}s."
+        elif current in CLOSED_ORDER_STATUSES:
+            outcome = f"Order closed with status '{current}' without reaching '{status}'."
+        else:
+            outcome = f"Timed out after {waited:.1f}s waiting for '{status}'."
+        
+        result = f"""
+                {outcome}
+                Order ID: {order.id}
+                Symbol: {order.symbol}
+                Status: {current}
+                Filled Quantity: {order.filled_qty}
+                """
+        if order.filled_avg_price:
+            result += f"Filled Price: ${float(order.filled_avg_price):.2f}\n"
+        return result
+    except Exception as e:
+        return ToolError(f"Error waiting for order {order_id}: {str(e)}")
+
+# Fields accepted for each order of place_stock_orders_batch, with their defaults
+BATCH_ORDER_FIELDS = {
+    "symbol": None, "side": None, "quantity": None, "order_type": "market", "time_in_force": "day",
+    "limit_price": None, "stop_price": None, "trail_price": None, "trail_percent": None,
+    "extended_hours": False, "client_order_id": None,
+}
+BATCH_ORDER_COLUMNS = ["index", "symbol", "side", "quantity", "order_type", "result", "order_id", "status",
+                       "client_order_id", "error"]
+
+def _build_batch_order_requests(orders: List[Dict[str, Any]]) -> tuple:
+    """
+    Validate a basket and build one order request per entry.
+
+    Returns:
+        tuple: (requests, errors) where errors lists one message per invalid entry
+    """
+    order_requests, errors = [], []
+    client_ids = set()
+    for index, spec in enumerate(orders, 1):
+        try:
+            if not isinstance(spec, dict):
+                raise ValueError("Each order must be an object with symbol, side and quantity.")
+            unknown = set(spec) - set(BATCH_ORDER_FIELDS)
+            if unknown:
+                raise ValueError(f"Unknown fields: {', '.join(sorted(unknown))}")
+            params = {**BATCH_ORDER_FIELDS, **spec}
+            missing = [field for field in ("symbol", "side", "quantity") if params[field] in (None, "")]
+            if missing:
+                raise ValueError(f"Missing required fields: {', '.join(missing)}")
+            not_text = [field for field in ("side", "order_type", "time_in_force") if not isinstance(params[field], str)]
+            if not_text:
+                raise ValueError(f"Fields must be strings: {', '.join(not_text)}")
+            params["symbol"] = str(params["symbol"]).strip().upper()
+            request = _build_stock_order_request(**params)
+            if request.client_order_id in client_ids:
+                raise ValueError(f"Duplicate client_order_id '{request.client_order_id}'")
+            client_ids.add(request.client_order_id)
+            order_requests.append(request)
+        except (ValueError, TypeError, AttributeError) as e:
+            errors.append(f"Order {index}: {str(e)}")
+    return order_requests, errors
+
+@mcp.tool()
+async def place_stock_orders_batch(orders: List[Dict[str, Any]], format: Optional[str] = None, account: Optional[str] = None) -> str:
+    """
+    Places a basket of stock orders in one call. The whole basket is validated first and
+    nothing is submitted if any order is invalid; valid baskets are submitted concurrently
+    within the API rate limit.
+    
+    Args:
+        orders (List[Dict[str, Any]]): Orders, each with the parameters of place_stock_order:
+            symbol, side, quantity (required) and optionally order_type, time_in_force,
+            limit_price, stop_price, trail_price, trail_percent, extended_hours, client_order_id
+        format (Optional[str]): Output format - "text", "json" or "csv" (default: MCP_OUTPUT_FORMAT)
+        account (Optional[str]): Account to act on, by its MCP_ACCOUNTS name (default: the ALPACA_API_KEY account)
+    
+    Returns:
+        str: One result per order (order ID and status, or the error) and a summary
+    
+    Example:
+        orders = [
+            {"symbol": "AAPL", "side": "buy", "quantity": 10},
+            {"symbol": "MSFT", "side": "sell", "quantity": 5, "order_type": "limit", "limit_price": 420.5}
+        ]
+    """
+    try:
+        fmt = _resolve_format(format)
+        if not orders:
+            return ToolError("Error: No orders provided.")
+        order_requests, errors = _build_batch_order_requests(orders)
+        if errors:
+            return ToolError("No orders were submitted; fix these orders and resubmit the basket:\n" + "\n".join(errors))
+        
+        results = await asyncio.gather(
+            *(_call_api(trade_client.submit_order, request) for request in order_requests),
+            return_exceptions=True
+        )
+        rows = []
+        for index, (request, result) in enumerate(zip(order_requests, results), 1):
+            base = [index, request.symbol, _serialize_value(request.side), request.qty, _serialize_value(request.type)]
+            if isinstance(result, BaseException):
+                rows.append(base + ["failed", None, None, request.client_order_id, str(result)])
+            else:
+                order_mirror.record(result)
+                rows.append(base + ["submitted", str(result.id), _order_status(result), result.client_order_id, None])
+        submitted = sum(1 for row in rows if row[5] == "submitted")
+        
+        if fmt != "text":
+            renderer = TableRenderer(fmt, BATCH_ORDER_COLUMNS)
+            return (renderer.begin({"submitted": submitted, "failed": len(rows) - submitted})
+                    + "".join(renderer.row(row) for row in rows) + renderer.end())
+        
+        result = [f"Batch Order Results ({submitted} of {len(rows)} submitted):", "-" * 30]
+        for index, symbol, side, qty, order_type, outcome, order_id, status, client_id, error in rows:
+            line = f"{index}. {side.upper()} {qty} {symbol} {order_type}: "
+            if outcome == "submitted":
+                line += f"Order ID: {order_id}, Status: {status}, Client Order ID: {client_id}"
+            else:
+                line += f"Failed: {error}"
+            result.append(line)
+        return "\n".join(result)
+    except Exception as e:
+        return ToolError(f"Error placing orders: {str(e)}")
+
+@mcp.tool()
+async def cancel_orders_batch(order_ids: List[str], account: Optional[str] = None) -> str:
+    """
+    Cancels several orders by ID in one call. IDs are validated first and the cancels run
+    concurrently in the rate limiter's priority lane.
+    
+    Args:
+        order_ids (List[str]): UUIDs of the orders to cancel
+        account (Optional[str]): Account to act on, by its MCP_ACCOUNTS name (default: the ALPACA_API_KEY account)
+    
+    Returns:
+        str: One result per order and a summary
+    """
+    try:
+        order_ids = list(dict.fromkeys(o.strip() for o in order_ids if o and o.strip()))
+        if not order_ids:
+            return ToolError("Error: No order IDs provided.")
+        invalid = []
+        for order_id in order_ids:
+            try:
+                uuid.UUID(order_id)
+            except ValueError:
+                invalid.append(order_id)
+        if invalid:
+            return ToolError(f"No orders were cancelled; invalid order IDs: {', '.join(invalid)}")
+        
+        results = await asyncio.gather(
+            *(_call_api(trade_client.cancel_order_by_id, order_id) for order_id in order_ids),
+            return_exceptions=True
+        )
+        failed = {order_id: str(r) for order_id, r in zip(order_ids, results) if isinstance(r, BaseException)}
+        result = [f"Batch Cancel Results ({len(order_ids) - len(failed)} of {len(order_ids)} cancel requests accepted):", "-" * 30]
+        for order_id in order_ids:
+            result.append(f"{order_id}: " + (f"Failed: {failed[order_id]}" if order_id in failed else "Cancel requested"))
+        return "\n".join(result)
+    except Exception as e:
+        return ToolError(f"Error cancelling orders: {str(e)}")
 
 # ============================================================================
 # Position Management Tools
 # ============================================================================
 
 @mcp.tool()
-async def close_position(symbol: str, qty: Optional[str] = None, percentage: Optional[str] = None) -> str:
+async def close_position(symbol: str, qty: Optional[str] = None, percentage: Optional[str] = None, account: Optional[str] = None) -> str:
     """
     Closes a specific position for a single symbol.
     
@@ -938,6 +4759,7 @@ async def close_position(symbol: str, qty: Optional[str] = None, percentage: Opt
         symbol (str): The symbol of the position to close
         qty (Optional[str]): Optional number of shares to liquidate
         percentage (Optional[str]): Optional percentage of shares to liquidate (must result in at least 1 share)
+        account (Optional[str]): Account to act on, by its MCP_ACCOUNTS name (default: the ALPACA_API_KEY account)
     
     Returns:
         str: Formatted string containing position closure details or error message
@@ -952,7 +4774,7 @@ async def close_position(symbol: str, qty: Optional[str] = None, percentage: Opt
             )
         
         # Close the position
-        order = trade_client.close_position(symbol, close_options)
+        order = await _call_api(trade_client.close_position, symbol, close_options)
         
         return f"""
                 Position Closed Successfully:
@@ -965,7 +4787,7 @@ async def close_position(symbol: str, qty: Optional[str] = None, percentage: Opt
     except APIError as api_error:
         error_message = str(api_error)
         if "42210000" in error_message and "would result in order size of zero" in error_message:
-            return """
+            return ToolError("""
             Error: Invalid position closure request.
             
             The requested percentage would result in less than 1 share.
@@ -973,27 +4795,28 @@ async def close_position(symbol: str, qty: Optional[str] = None, percentage: Opt
             1. Use a higher percentage
             2. Close the entire position (100%)
             3. Specify an exact quantity using the qty parameter
-            """
+            """)
         else:
-            return f"Error closing position: {error_message}"
+            return ToolError(f"Error closing position: {error_message}")
             
     except Exception as e:
-        return f"Error closing position: {str(e)}"
+        return ToolError(f"Error closing position: {str(e)}")
     
 @mcp.tool()
-async def close_all_positions(cancel_orders: bool = False) -> str:
+async def close_all_positions(cancel_orders: bool = False, account: Optional[str] = None) -> str:
     """
     Closes all open positions.
     
     Args:
         cancel_orders (bool): If True, cancels all open orders before liquidating positions
+        account (Optional[str]): Account to act on, by its MCP_ACCOUNTS name (default: the ALPACA_API_KEY account)
     
     Returns:
         str: Formatted string containing position closure results
     """
     try:
         # Close all positions
-        close_responses = trade_client.close_all_positions(cancel_orders=cancel_orders)
+        close_responses = await _call_api(trade_client.close_all_positions, cancel_orders=cancel_orders)
         
         if not close_responses:
             return "No positions were found to close."
@@ -1012,12 +4835,457 @@ async def close_all_positions(cancel_orders: bool = False) -> str:
         return "\n".join(response_parts)
         
     except Exception as e:
-        return f"Error closing positions: {str(e)}"
+        return ToolError(f"Error closing positions: {str(e)}")
+
+# ============================================================================
+# Portfolio Analytics
+# ============================================================================
+
+PORTFOLIO_COLUMNS = ["symbol", "asset_class", "exchange", "qty", "price", "market_value", "weight",
+                     "intraday_pl", "unrealized_pl", "beta"]
+# Fewest aligned daily returns for which beta and VaR are reported
+MIN_RISK_OBSERVATIONS = 20
+
+async def _latest_prices(symbols: List[str]) -> Dict[str, float]:
+    """Latest trade prices, from the live stream for subscribed symbols and one batched snapshot pull otherwise."""
+    prices = {}
+    missing = []
+    for symbol in symbols:
+        trade = market_stream.get_trade(symbol)
+        if trade is not None:
+            prices[symbol] = float(trade.price)
+        else:
+            missing.append(symbol)
+    if missing:
+        snapshots, _ = await _fetch_symbol_chunks(
+            stock_historical_data_client.get_stock_snapshot,
+            lambda chunk: StockSnapshotRequest(symbol_or_symbols=chunk),
+            missing
+        )
+        for symbol, snapshot in snapshots.items():
+            if snapshot is not None and snapshot.latest_trade is not None:
+                prices[symbol] = float(snapshot.latest_trade.price)
+    return prices
+
+def _portfolio_risk(
+    closes: Dict[str, Dict[int, float]],
+    market_values: Dict[str, float],
+    equity: float,
+    benchmark: str,
+    confidence: float
+) -> Optional[Dict[str, Any]]:
+    """
+    Beta and one-day historical VaR of the current holdings over their common daily history.
+
+    Args:
+        closes: Daily closes per symbol, keyed by bar timestamp; must include the benchmark
+        market_values: Signed market value per held symbol (shorts negative)
+        equity: Account equity the portfolio beta is expressed against
+        benchmark: Benchmark symbol in closes
+        confidence: VaR confidence level (e.g., 0.95)
+
+    Returns:
+        Optional[Dict[str, Any]]: Per-symbol betas, portfolio beta, VaR, expected shortfall and the
+            number of daily returns used, or None when the common history is too short
+    """
+    symbols = [s for s in market_values if closes.get(s)]
+    if not symbols or not closes.get(benchmark):
+        return None
+    dates = sorted(set(closes[benchmark]).intersection(*(closes[s] for s in symbols)))
+    if len(dates) <= MIN_RISK_OBSERVATIONS:
+        return None
+
+    prices = np.array([[closes[s][d] for d in dates] for s in symbols + [benchmark]], dtype=float)
+    returns = prices[:, 1:] / prices[:, :-1] - 1.0
+    holdings, market = returns[:-1], returns[-1]
+    market_centered = market - market.mean()
+    betas = (holdings - holdings.mean(axis=1, keepdims=True)) @ market_centered / (market_centered @ market_centered)
+
+    # Replay each historical day's returns against today's holdings
+    values = np.array([market_values[s] for s in symbols])
+    pnl = values @ holdings
+    var = -float(np.quantile(pnl, 1.0 - confidence))
+    tail = pnl[pnl <= -var]
+    return {
+        "betas": dict(zip(symbols, betas.tolist())),
+        "beta": float(values @ betas) / equity if equity else None,
+        "var": var,
+        "expected_shortfall": -float(tail.mean()) if tail.size else var,
+        "observations": int(market.size),
+    }
+
+@mcp.tool()
+async def get_portfolio_analytics(
+    lookback_days: int = 365,
+    confidence: float = 0.95,
+    benchmark: str = "SPY",
+    format: Optional[str] = None,
+    account: Optional[str] = None
+) -> str:
+    """
+    Computes portfolio exposure, leverage, P&L, beta and historical VaR server-side in one call.
+
+    Combines one positions and account fetch with a batched price refresh and daily bars from
+    the local bar store, so agents need not pull every holding and do the math themselves.
+    Beta and VaR cover equity positions; other asset classes count toward exposure and P&L only.
+
+    Args:
+        lookback_days (int): Calendar days of daily history for beta and VaR (default: 365)
+        confidence (float): Confidence level of the one-day historical VaR (default: 0.95)
+        benchmark (str): Symbol beta is measured against (default: "SPY")
+        format (Optional[str]): Output format - "text", "json" or "csv" (default: MCP_OUTPUT_FORMAT)
+        account (Optional[str]): Account to act on, by its MCP_ACCOUNTS name (default: the ALPACA_API_KEY account)
+
+    Returns:
+        str: Summary of long/short exposure, gross and net leverage, exposure by asset class and
+            exchange, intraday and unrealized P&L, beta and VaR, followed by one line per position
+    """
+    try:
+        fmt = _resolve_format(format)
+        if not 0.5 <= confidence < 1:
+            return ToolError("Error: confidence must be between 0.5 and 1 (e.g., 0.95).")
+        benchmark = benchmark.strip().upper()
+        positions, account_data = await asyncio.gather(order_mirror.get_positions(), _call_api(trade_client.get_account))
+        if not positions:
+            return "No open positions found."
+        equity = float(account_data.equity)
+
+        equities = [p.symbol for p in positions if _serialize_value(p.asset_class) == "us_equity"]
+        end_time = datetime.now(timezone.utc)
+        start_time = end_time - timedelta(days=lookback_days)
+        history_symbols = list(dict.fromkeys(equities + [benchmark]))
+        prices, *histories = await asyncio.gather(
+            _latest_prices(equities),
+            *(_load_base_bars(symbol, TimeFrame.Day, start_time, end_time) for symbol in history_symbols)
+        )
+
+        rows = []
+        market_values: Dict[str, float] = {}
+        by_class: Dict[str, float] = defaultdict(float)
+        by_exchange: Dict[str, float] = defaultdict(float)
+        for position in positions:
+            asset_class = _serialize_value(position.asset_class)
+            exchange = _serialize_value(position.exchange) or "n/a"
+            qty = float(position.qty)
+            price = prices.get(position.symbol, float(position.current_price))
+            # Option prices are per share and contracts cover 100 shares
+            market_value = qty * price * (100 if asset_class == "us_option" else 1)
+            # Move both P&L figures from the position's last valuation to the refreshed price
+            revaluation = market_value - float(position.market_value)
+            intraday_pl = float(position.unrealized_intraday_pl or 0) + revaluation
+            unrealized_pl = float(position.unrealized_pl or 0) + revaluation
+            by_class[asset_class] += abs(market_value)
+            by_exchange[exchange] += abs(market_value)
+            if asset_class == "us_equity":
+                market_values[position.symbol] = market_value
+            rows.append([position.symbol, asset_class, exchange, qty, price,
+                         market_value, None, intraday_pl, unrealized_pl, None])
+
+        closes = {
+            symbol: {int(r[0]): float(r[4]) for r in records if r[4] is not None}
+            for symbol, records in zip(history_symbols, histories)
+        }
+        risk = await _run_blocking(_portfolio_risk, closes, market_values, equity, benchmark, confidence)
+
+        long_exposure = sum(r[5] for r in rows if r[5] > 0)
+        short_exposure = -sum(r[5] for r in rows if r[5] < 0)
+        gross = long_exposure + short_exposure
+        intraday_total = sum(r[7] for r in rows)
+        unrealized_total = sum(r[8] for r in rows)
+        for row in rows:
+            row[6] = row[5] / equity if equity else None
+            row[9] = risk["betas"].get(row[0]) if risk else None
+        rows.sort(key=lambda r: -abs(r[5]))
+
+        summary = {
+            "equity": equity,
+            "long_exposure": long_exposure,
+            "short_exposure": short_exposure,
+            "gross_leverage": gross / equity if equity else None,
+            "net_leverage": (long_exposure - short_exposure) / equity if equity else None,
+            "intraday_pl": intraday_total,
+            "unrealized_pl": unrealized_total,
+            "exposure_by_asset_class": {k: v / gross for k, v in by_class.items()} if gross else {},
+            "exposure_by_exchange": {k: v / gross for k, v in by_exchange.items()} if gross else {},
+            "benchmark": benchmark,
+            "beta": risk["beta"] if risk else None,
+            "var": risk["var"] if risk else None,
+            "expected_shortfall": risk["expected_shortfall"] if risk else None,
+            "confidence": confidence,
+            "observations": risk["observations"] if risk else 0,
+        }
+        if fmt != "text":
+            return _render_table(fmt, PORTFOLIO_COLUMNS, rows, summary)
+
+        def shares(mapping: Dict[str, float]) -> str:
+            return ", ".join(f"{k} {v:.1%}" for k, v in sorted(mapping.items(), key=lambda kv: -kv[1]))
+
+        def ratio(value: Optional[float], spec: str = ".2f") -> str:
+            return "n/a" if value is None else f"{value:{spec}}"
+
+        result = [
+            f"Portfolio Analytics ({len(rows)} positions, equity ${equity:,.2f}):",
+            "-" * 40,
+            f"Long Exposure: ${long_exposure:,.2f}, Short Exposure: ${short_exposure:,.2f}, "
+            f"Gross Leverage: {ratio(summary['gross_leverage'])}x, Net Leverage: {ratio(summary['net_leverage'])}x",
+            f"Intraday P&L: ${intraday_total:+,.2f}, Unrealized P&L: ${unrealized_total:+,.2f}",
+            f"Exposure by Asset Class: {shares(summary['exposure_by_asset_class'])}",
+            f"Exposure by Exchange: {shares(summary['exposure_by_exchange'])}",
+        ]
+        if risk:
+            result.append(
+                f"Beta vs {benchmark}: {ratio(risk['beta'])}, 1-Day Historical VaR ({confidence:.0%}): "
+                f"${risk['var']:,.2f} ({ratio(risk['var'] / equity if equity else None, '.2%')} of equity), "
+                f"Expected Shortfall: ${risk['expected_shortfall']:,.2f} ({risk['observations']} daily returns)"
+            )
+        else:
+            result.append(f"Beta/VaR: n/a (fewer than {MIN_RISK_OBSERVATIONS} common daily returns with {benchmark})")
+        result.append("")
+        for symbol, _, _, qty, price, market_value, weight, intraday_pl, unrealized_pl, beta in rows:
+            result.append(
+                f"{symbol}: {qty:g} @ ${price:,.2f}, Value ${market_value:,.2f} ({ratio(weight, '.1%')}), "
+                f"Day P&L ${intraday_pl:+,.2f}, Unrealized ${unrealized_pl:+,.2f}, Beta {ratio(beta)}"
+            )
+        return "\n".join(result)
+    except Exception as e:
+        return ToolError(f"Error computing portfolio analytics: {str(e)}")
 
 # ============================================================================
 # Asset Information Tools
 # ============================================================================
 
+# Boolean asset properties search_assets can filter on
+ASSET_FLAGS = ("tradable", "shortable", "fractionable", "marginable", "easy_to_borrow")
+ASSET_COLUMNS = ["symbol", "name", "exchange", "asset_class", "status"] + list(ASSET_FLAGS)
+
+# Asset classes held in the index. /v2/assets without asset_class lists only us_equity, so
+# each class is downloaded on its own; filters for other classes (us_option) go to REST
+INDEXED_ASSET_CLASSES = (AssetClass.US_EQUITY, AssetClass.CRYPTO)
+
+def _asset_facet(value: Any) -> str:
+    return str(_serialize_value(value) or "").lower()
+
+class AssetIndex:
+    """
+    In-memory index of the whole asset universe.
+
+    The universe (every class in INDEXED_ASSET_CLASSES) is downloaded through the response
+    cache ("asset_universe", one day by default), so concurrent first calls share one
+    download and the index is rebuilt only when a cached list changes. Assets are indexed by symbol, by facet (exchange,
+    class, status and each boolean flag) as symbol sets, and by sorted symbol, name and
+    name-word keys for prefix search with bisect. Over the memory budget, an index idle
+    for MEMORY_EVICT_IDLE_SECONDS is dropped and rebuilt by the next load.
+    """
+
+    def __init__(self):
+        self._source = None
+        self.loaded_at: Optional[float] = None
+        self.bytes = 0
+        self._used = 0.0
+        self.by_symbol: Dict[str, Any] = {}
+        self._facets: Dict[tuple, set] = defaultdict(set)
+        self._symbols: List[str] = []
+        self._names: List[tuple] = []
+        self._words: List[tuple] = []
+        self._symbols_by_word: Dict[str, set] = {}
+
+    async def load(self) -> "AssetIndex":
+        """Return the index, downloading the universe if the cached copy has expired."""
+        self._used = time.monotonic()
+        parts = tuple(await asyncio.gather(*(
+            _cached_api("asset_universe", trade_client.get_all_assets, GetAssetsRequest(asset_class=asset_class))
+            for asset_class in INDEXED_ASSET_CLASSES
+        )))
+        if self._source is None or any(part is not source for part, source in zip(parts, self._source)):
+            await _run_blocking(self._build, parts)
+        return self
+
+    @staticmethod
+    def covers(asset_class: Optional[str]) -> bool:
+        """Whether a filter on asset_class can be answered from the index."""
+        return asset_class is None or _asset_facet(asset_class) in {c.value for c in INDEXED_ASSET_CLASSES}
+
+    @property
+    def fresh(self) -> bool:
+        """Whether the index holds a universe that has not outlived its cache TTL."""
+        ttl = CACHE_TTLS.get("asset_universe", 0)
+        return self.loaded_at is not None and not callable(ttl) and time.monotonic() - self.loaded_at < ttl
+
+    def _build(self, parts: tuple) -> None:
+        assets = [asset for part in parts for asset in part]
+        by_symbol, facets = {}, defaultdict(set)
+        names, words = [], []
+        for asset in assets:
+            symbol = asset.symbol
+            by_symbol[symbol] = asset
+            facets[("exchange", _asset_facet(asset.exchange))].add(symbol)
+            facets[("asset_class", _asset_facet(asset.asset_class))].add(symbol)
+            facets[("status", _asset_facet(asset.status))].add(symbol)
+            for flag in ASSET_FLAGS:
+                if getattr(asset, flag, False):
+                    facets[(flag, True)].add(symbol)
+            name = (asset.name or "").lower()
+            names.append((name, symbol))
+            words.extend((word, symbol) for word in set(re.findall(r"\w+", name)))
+        self.by_symbol, self._facets = by_symbol, facets
+        self._symbols = sorted(by_symbol)
+        self._names, self._words = sorted(names), sorted(words)
+        symbols_by_word = defaultdict(set)
+        for word, symbol in words:
+            symbols_by_word[word].add(symbol)
+        self._symbols_by_word = dict(symbols_by_word)
+        self._source = parts
+        self.bytes = sum(_approx_size(part) for part in (
+            assets, by_symbol, facets, self._symbols, self._names, self._words, self._symbols_by_word))
+        self.loaded_at = time.monotonic()
+
+    def evict(self, target: int) -> int:
+        """Drop the whole index when nothing has used it lately; returns the bytes freed."""
+        if time.monotonic() - self._used < MEMORY_EVICT_IDLE_SECONDS:
+            return 0
+        freed, self.bytes = self.bytes, 0
+        self._source, self.loaded_at, self.by_symbol, self._facets = None, None, {}, defaultdict(set)
+        self._symbols, self._names, self._words, self._symbols_by_word = [], [], [], {}
+        return freed
+
+    def get(self, symbol: str):
+        self._used = time.monotonic()
+        return self.by_symbol.get(symbol.strip().upper())
+
+    def filter(self, **facets) -> set:
+        """Symbols matching every given facet; facets set to None are ignored."""
+        result = None
+        for field, value in facets.items():
+            if value is None:
+                continue
+            if field in ASSET_FLAGS:
+                matches = self._facets.get((field, True), set())
+                matches = matches if value else set(self.by_symbol) - matches
+            else:
+                matches = self._facets.get((field, str(value).lower()), set())
+            result = matches if result is None else result & matches
+        return set(self.by_symbol) if result is None else result
+
+    @staticmethod
+    def _prefixed(keys: List[tuple], prefix: str) -> List[str]:
+        start = bisect.bisect_left(keys, (prefix,))
+        matches = []
+        for key, symbol in keys[start:]:
+            if not key.startswith(prefix):
+                break
+            matches.append(symbol)
+        return matches
+
+    def search(self, query: Optional[str], candidates: set, limit: int, fuzzy: bool = True) -> tuple:
+        """
+        Rank candidate symbols against a query: exact symbol, symbol prefix, name prefix,
+        name word prefix, then (optionally) fuzzy name word and symbol matches.
+
+        Returns:
+            tuple: (symbols, total) with up to limit ranked symbols and the number of matches
+        """
+        if not query:
+            matches = sorted(candidates)
+            return matches[:limit], len(matches)
+        text = query.strip().lower()
+        ranked = {}
+        def add(symbols):
+            for symbol in symbols:
+                if symbol in candidates and symbol not in ranked:
+                    ranked[symbol] = len(ranked)
+        add([text.upper()])
+        start = bisect.bisect_left(self._symbols, text.upper())
+        add(s for s in itertools.takewhile(lambda s: s.startswith(text.upper()), self._symbols[start:]))
+        add(self._prefixed(self._names, text))
+        add(self._prefixed(self._words, text))
+        if fuzzy and len(ranked) < limit:
+            # Approximate matching word by word, so "micro devises" finds "Advanced Micro Devices"
+            matched = None
+            for word in re.findall(r"\w+", text):
+                close = difflib.get_close_matches(word, self._symbols_by_word, n=10, cutoff=0.75)
+                symbols = set().union(*(self._symbols_by_word[w] for w in close))
+                matched = symbols if matched is None else matched & symbols
+            add(sorted(matched or ()))
+            add(difflib.get_close_matches(text.upper(), self._symbols, n=limit, cutoff=0.75))
+        matches = list(ranked)
+        return matches[:limit], len(matches)
+
+asset_index = AssetIndex()
+memory_budget.register("asset_index", lambda: asset_index.bytes, asset_index.evict, priority=35)
+
+def _serialize_asset(asset) -> List[Any]:
+    return _serialize_record(asset, ASSET_COLUMNS)
+
+@mcp.tool()
+async def search_assets(
+    query: Optional[str] = None,
+    exchange: Optional[str] = None,
+    asset_class: Optional[str] = None,
+    status: Optional[str] = "active",
+    tradable: Optional[bool] = None,
+    shortable: Optional[bool] = None,
+    fractionable: Optional[bool] = None,
+    marginable: Optional[bool] = None,
+    easy_to_borrow: Optional[bool] = None,
+    fuzzy: bool = True,
+    limit: int = 20,
+    format: Optional[str] = None
+) -> str:
+    """
+    Searches the asset universe in memory by symbol or company name, with filters.
+    The universe is downloaded once per day.
+    
+    Args:
+        query (Optional[str]): Symbol or name to look for (e.g., "AAPL", "appl", "advanced micro").
+            Matches are ranked: exact symbol, symbol prefix, name prefix, name word prefix,
+            then fuzzy matches. Omit to list every asset matching the filters.
+        exchange (Optional[str]): Exchange filter (e.g., "NASDAQ", "NYSE", "ARCA")
+        asset_class (Optional[str]): Asset class filter ("us_equity", "us_option", "crypto")
+        status (Optional[str]): Status filter, "active" or "inactive" (default: "active"; None for both)
+        tradable (Optional[bool]): Only assets that are (True) or are not (False) tradable
+        shortable (Optional[bool]): Filter on shortable
+        fractionable (Optional[bool]): Filter on fractionable
+        marginable (Optional[bool]): Filter on marginable
+        easy_to_borrow (Optional[bool]): Filter on easy to borrow
+        fuzzy (bool): Include approximate name and symbol matches (default: True)
+        limit (int): Maximum number of results (default: 20)
+        format (Optional[str]): Output format - "text", "json" or "csv" (default: MCP_OUTPUT_FORMAT)
+    
+    Returns:
+        str: Matching assets, best match first, with the total number of matches
+    """
+    try:
+        fmt = _resolve_format(format)
+        if asset_index.covers(asset_class):
+            index = await asset_index.load()
+        else:
+            # Classes the index does not hold are searched over a one-off index of that class
+            index = AssetIndex()
+            assets = await _call_api(trade_client.get_all_assets, GetAssetsRequest(asset_class=asset_class))
+            await _run_blocking(index._build, (assets,))
+        candidates = index.filter(
+            exchange=exchange, asset_class=asset_class, status=status, tradable=tradable,
+            shortable=shortable, fractionable=fractionable, marginable=marginable, easy_to_borrow=easy_to_borrow
+        )
+        symbols, total = await _run_blocking(index.search, query, candidates, max(limit, 1), fuzzy)
+        assets = [index.by_symbol[s] for s in symbols]
+        
+        if fmt != "text":
+            return _render_table(fmt, ASSET_COLUMNS, [_serialize_asset(a) for a in assets], {"query": query, "total": total})
+        
+        if not assets:
+            return f"No assets found matching '{query}'." if query else "No assets found matching the filters."
+        result = [f"Asset Search Results ({len(assets)} of {total} matches):", "-" * 30]
+        for asset in assets:
+            flags = ", ".join(flag.replace("_", " ") for flag in ASSET_FLAGS if getattr(asset, flag, False))
+            result.append(
+                f"{asset.symbol}: {asset.name} ({_serialize_value(asset.exchange)}, {_serialize_value(asset.asset_class)}, "
+                f"{_serialize_value(asset.status)}) - {flags or 'no trading flags'}"
+            )
+        return "\n".join(result)
+    except Exception as e:
+        return ToolError(f"Error searching assets: {str(e)}")
+
 @mcp.tool()
 async def get_asset_info(symbol: str) -> str:
     """
@@ -1035,7 +5303,11 @@ async def get_asset_info(symbol: str) -> str:
             - Trading Properties
     """
     try:
-        asset = trade_client.get_asset(symbol)
+        # Answer from the asset index when it is loaded; new listings and option
+        # contracts it does not hold still go to the API
+        asset = asset_index.get(symbol) if asset_index.fresh else None
+        if asset is None:
+            asset = await _cached_api("get_asset_info", trade_client.get_asset, symbol)
         return f"""
                 Asset Information for {symbol}:
                 ----------------------------
@@ -1050,87 +5322,114 @@ async def get_asset_info(symbol: str) -> str:
                 Fractionable: {'Yes' if asset.fractionable else 'No'}
                 """
     except Exception as e:
-        return f"Error fetching asset information: {str(e)}"
+        return ToolError(f"Error fetching asset information: {str(e)}")
 
 @mcp.tool()
 async def get_all_assets(
     status: Optional[str] = None,
     asset_class: Optional[str] = None,
     exchange: Optional[str] = None,
-    attributes: Optional[str] = None
+    attributes: Optional[str] = None,
+    page_token: Optional[str] = None,
+    max_rows: Optional[int] = None,
+    max_bytes: Optional[int] = None
 ) -> str:
     """
     Get all available assets with optional filtering.
+    Responses stop at the row/byte budget with an exchange and class breakdown of all
+    matching assets and a page_token for the rest; narrow the filters or use search_assets
+    to find specific assets.
     
     Args:
         status: Filter by asset status (e.g., 'active', 'inactive')
         asset_class: Filter by asset class (e.g., 'us_equity', 'crypto')
         exchange: Filter by exchange (e.g., 'NYSE', 'NASDAQ')
         attributes: Comma-separated values to query for multiple attributes
+        page_token: Continuation token from a previous truncated response
+        max_rows: Maximum assets in this response (default: MCP_MAX_ROWS)
+        max_bytes: Approximate maximum response size in bytes (default: MCP_MAX_BYTES)
     """
     try:
-        # Create filter if any parameters are provided
-        filter_params = None
-        if any([status, asset_class, exchange, attributes]):
-            filter_params = GetAssetsRequest(
-                status=status,
-                asset_class=asset_class,
-                exchange=exchange,
-                attributes=attributes
-            )
-        
-        # Get all assets
-        assets = trade_client.get_all_assets(filter_params)
+        try:
+            query = {"status": status, "asset_class": asset_class, "exchange": exchange, "attributes": attributes}
+            after = _resume_listing(page_token, "assets", query).get("after")
+        except ValueError as e:
+            return ToolError(f"Error: {str(e)}")
+        if asset_index.covers(asset_class):
+            # Filter the in-memory universe instead of downloading it on every call
+            index = await asset_index.load()
+            symbols = index.filter(status=status, asset_class=asset_class, exchange=exchange)
+            assets = [index.by_symbol[s] for s in sorted(symbols)]
+        else:
+            request = GetAssetsRequest(status=status, asset_class=asset_class, exchange=exchange, attributes=attributes)
+            assets = sorted(await _call_api(trade_client.get_all_assets, request), key=lambda asset: asset.symbol)
+        if attributes:
+            wanted = {a.strip() for a in attributes.split(",") if a.strip()}
+            assets = [a for a in assets if wanted & set(getattr(a, "attributes", None) or [])]
         
         if not assets:
             return "No assets found matching the criteria."
         
-        # Format the response
-        response_parts = ["Available Assets:"]
-        response_parts.append("-" * 30)
+        # Resume after the last symbol shown, so listing changes between calls skip nothing
+        start = bisect.bisect_right([asset.symbol for asset in assets], after) if after else 0
+        writer = ResponseWriter(max_rows or MCP_MAX_ROWS, max_bytes or MCP_MAX_BYTES)
+        writer.write("Available Assets:\n" + "-" * 30 + "\n")
         
-        for asset in assets:
-            response_parts.append(f"Symbol: {asset.symbol}")
-            response_parts.append(f"Name: {asset.name}")
-            response_parts.append(f"Exchange: {asset.exchange}")
-            response_parts.append(f"Class: {asset.asset_class}")
-            response_parts.append(f"Status: {asset.status}")
-            response_parts.append(f"Tradable: {'Yes' if asset.tradable else 'No'}")
-            response_parts.append("-" * 30)
+        for asset in assets[start:]:
+            if not writer.add_row(
+                f"Symbol: {asset.symbol}\n"
+                f"Name: {asset.name}\n"
+                f"Exchange: {_serialize_value(asset.exchange)}\n"
+                f"Class: {_serialize_value(asset.asset_class)}\n"
+                f"Status: {_serialize_value(asset.status)}\n"
+                f"Tradable: {'Yes' if asset.tradable else 'No'}\n"
+                + "-" * 30 + "\n"
+            ):
+                break
         
-        return "\n".join(response_parts)
+        shown = start + writer.rows
+        if start or shown < len(assets):
+            # At least one row is always written, so shown - 1 is the last asset of this response
+            next_cursor = _listing_cursor("assets", query, after=assets[shown - 1].symbol) if start < shown < len(assets) else None
+            _listing_summary(writer, start, len(assets), "assets", {
+                "exchange": Counter(_serialize_value(asset.exchange) for asset in assets),
+                "class": Counter(_serialize_value(asset.asset_class) for asset in assets),
+            }, next_cursor)
+        return writer.getvalue()
         
     except Exception as e:
-        return f"Error fetching assets: {str(e)}"
+        return ToolError(f"Error fetching assets: {str(e)}")
 
 # ============================================================================
 # Watchlist Management Tools
 # ============================================================================
 
 @mcp.tool()
-async def create_watchlist(name: str, symbols: List[str]) -> str:
+async def create_watchlist(name: str, symbols: List[str], account: Optional[str] = None) -> str:
     """
     Creates a new watchlist with specified symbols.
     
     Args:
         name (str): Name of the watchlist
         symbols (List[str]): List of symbols to include in the watchlist
+        account (Optional[str]): Account to act on, by its MCP_ACCOUNTS name (default: the ALPACA_API_KEY account)
     
     Returns:
         str: Confirmation message with watchlist creation status
     """
     try:
         watchlist_data = CreateWatchlistRequest(name=name, symbols=symbols)
-        watchlist = trade_client.create_watchlist(watchlist_data)
+        watchlist = await _call_api(trade_client.create_watchlist, watchlist_data)
+        event_store.invalidate_universe()
         return f"Watchlist '{name}' created successfully with {len(symbols)} symbols."
     except Exception as e:
-        return f"Error creating watchlist: {str(e)}"
+        return ToolError(f"Error creating watchlist: {str(e)}")
 
 @mcp.tool()
-async def get_watchlists() -> str:
+async def get_watchlists(account: Optional[str] = None) -> str:
     """Get all watchlists for the account."""
     try:
-        watchlists = trade_client.get_watchlists()
+        watchlists = await _call_api(trade_client.get_watchlists)
         result = "Watchlists:\n------------\n"
         for wl in watchlists:
             result += f"Name: {wl.name}\n"
@@ -1141,17 +5440,380 @@ async def get_watchlists() -> str:
             result += f"Symbols: {', '.join(getattr(wl, 'symbols', []) or [])}\n\n"
         return result
     except Exception as e:
-        return f"Error fetching watchlists: {str(e)}"
+        return ToolError(f"Error fetching watchlists: {str(e)}")
 
 @mcp.tool()
-async def update_watchlist(watchlist_id: str, name: str = None, symbols: List[str] = None) -> str:
+async def update_watchlist(watchlist_id: str, name: str = None, symbols: List[str] = None, account: Optional[str] = None) -> str:
     """Update an existing watchlist."""
     try:
         update_request = UpdateWatchlistRequest(name=name, symbols=symbols)
-        watchlist = trade_client.update_watchlist_by_id(watchlist_id, update_request)
+        watchlist = await _call_api(trade_client.update_watchlist_by_id, watchlist_id, update_request)
+        event_store.invalidate_universe()
         return f"Watchlist updated successfully: {watchlist.name}"
     except Exception as e:
-        return f"Error updating watchlist: {str(e)}"
+        return ToolError(f"Error updating watchlist: {str(e)}")
+
+# ============================================================================
+# Watchlist Alerts
+# ============================================================================
+
+# Alert condition -> stream message it is evaluated on
+ALERT_CONDITIONS = {
+    "price_above": "trade",
+    "price_below": "trade",
+    "move_pct": "trade",
+    "spread_pct": "quote",
+    "volume_spike": "bar",
+}
+# Minute bars averaged for volume_spike, and how many are needed before it can fire
+ALERT_VOLUME_WINDOW = 20
+ALERT_VOLUME_MIN_BARS = 5
+# Fired alerts held until polled; the oldest are dropped beyond this
+ALERT_QUEUE_SIZE = 1000
+ALERT_COLUMNS = ["alert_id", "symbol", "condition", "threshold", "repeat", "reference", "fired"]
+FIRED_ALERT_COLUMNS = ["alert_id", "symbol", "condition", "threshold", "value", "time"]
+
+class _AlertRule:
+    __slots__ = ("id", "symbol", "condition", "threshold", "repeat", "reference", "armed", "fired")
+
+    def __init__(self, symbol: str, condition: str, threshold: float, repeat: bool, reference: Optional[float]):
+        self.id = uuid.uuid4().hex[:8]
+        self.symbol = symbol
+        self.condition = condition
+        self.threshold = threshold
+        self.repeat = repeat
+        self.reference = reference  # Price move_pct is measured from
+        self.armed = True
+        self.fired = 0
+
+class AlertMonitor:
+    """
+    Evaluates alert rules on every live stream message for their symbols.
+
+    Rules are indexed by symbol and message kind, so a tick only touches the rules it
+    can trigger. A rule fires when its condition holds (at once if it already holds when
+    the first message arrives); one-shot rules are then removed, repeating rules re-arm
+    once the condition stops holding. Fired alerts queue up until poll() collects them.
+
+    Symbols the monitor subscribed itself are unsubscribed by release() once no rule watches
+    them; symbols also subscribed through subscribe_symbols are adopted and stay subscribed.
+    """
+
+    def __init__(self, stream: MarketDataStreamManager):
+        self._stream = stream
+        self._lock = threading.Lock()
+        self._rules: Dict[str, _AlertRule] = {}
+        # symbol -> message kind -> rules
+        self._index: Dict[str, Dict[str, List[_AlertRule]]] = defaultdict(lambda: defaultdict(list))
+        self._volumes: Dict[str, deque] = {}
+        self._fired: deque = deque(maxlen=ALERT_QUEUE_SIZE)
+        self._owned: set = set()
+        self._waiters: List[asyncio.Event] = []
+        self._loop: Optional[asyncio.AbstractEventLoop] = None
+        self.stats: Dict[str, int] = defaultdict(int)
+        stream.add_listener(self._on_message)
+
+    async def add(self, symbols: List[str], condition: str, threshold: float, repeat: bool) -> List[_AlertRule]:
+        """Register one rule per symbol and subscribe the symbols to the live stream."""
+        self._loop = asyncio.get_running_loop()
+        added = await _run_blocking(self._stream.subscribe, symbols)
+        rules = []
+        with self._lock:
+            self._owned.update(added)
+            for symbol in symbols:
+                trade = self._stream.get_trade(symbol)
+                rule = _AlertRule(symbol, condition, threshold, repeat, float(trade.price) if trade else None)
+                self._rules[rule.id] = rule
+                self._index[symbol][ALERT_CONDITIONS[condition]].append(rule)
+                rules.append(rule)
+        return rules
+
+    def remove(self, alert_id: str) -> Optional[_AlertRule]:
+        with self._lock:
+            rule = self._rules.pop(alert_id, None)
+            if rule is not None:
+                self._unindex(rule)
+            return rule
+
+    def adopt(self, symbols: List[str]) -> None:
+        """Keep symbols subscribed after their alerts are gone, because a client subscribed them."""
+        with self._lock:
+            self._owned.difference_update(symbols)
+
+    async def release(self) -> List[str]:
+        """Unsubscribe the symbols the monitor subscribed that no rule watches any more."""
+        with self._lock:
+            idle = sorted(symbol for symbol in self._owned if symbol not in self._index)
+            self._owned.difference_update(idle)
+        if idle:
+            await _run_blocking(self._stream.unsubscribe, idle)
+        return idle
+
+    def rules(self) -> List[_AlertRule]:
+        with self._lock:
+            return sorted(self._rules.values(), key=lambda rule: (rule.symbol, rule.condition))
+
+    def memory_bytes(self) -> int:
+        """Approximate size of the rules, volume windows and fired-alert queue."""
+        with self._lock:
+            return _approx_size(self._rules) + _approx_size(self._volumes) + _approx_size(self._fired)
+
+    def _unindex(self, rule: _AlertRule) -> None:
+        by_kind = self._index[rule.symbol]
+        kind_rules = by_kind[ALERT_CONDITIONS[rule.condition]]
+        kind_rules.remove(rule)
+        if not kind_rules:
+            del by_kind[ALERT_CONDITIONS[rule.condition]]
+        if not by_kind:
+            del self._index[rule.symbol]
+
+    def _on_message(self, kind: str, message) -> None:
+        """Stream thread callback for every quote, trade and minute bar."""
+        if kind == "bar" or message.symbol in self._index:
+            with self._lock:
+                try:
+                    self._evaluate(kind, message)
+                except Exception:
+                    self.stats["evaluation_errors"] += 1
+
+    def _evaluate(self, kind: str, message) -> None:
+        symbol = message.symbol
+        rules = self._index.get(symbol, {}).get(kind, [])
+        if kind == "trade":
+            price = float(message.price)
+        elif kind == "quote":
+            bid, ask = float(message.bid_price or 0), float(message.ask_price or 0)
+            if bid <= 0 or ask <= 0 or ask < bid:
+                return
+            spread_pct = (ask - bid) / ((ask + bid) / 2) * 100
+        else:
+            # Volume history is kept for every streamed symbol, so a new volume_spike rule can fire soon
+            volume = float(message.volume)
+            history = self._volumes.setdefault(symbol, deque(maxlen=ALERT_VOLUME_WINDOW))
+            average = sum(history) / len(history) if len(history) >= ALERT_VOLUME_MIN_BARS else None
+            history.append(volume)
+        fired = False
+        for rule in list(rules):
+            if rule.condition == "price_above":
+                value, holds = price, price >= rule.threshold
+            elif rule.condition == "price_below":
+                value, holds = price, price <= rule.threshold
+            elif rule.condition == "move_pct":
+                if rule.reference is None:
+                    rule.reference = price
+                value = (price / rule.reference - 1) * 100
+                holds = value >= rule.threshold if rule.threshold >= 0 else value <= rule.threshold
+            elif rule.condition == "spread_pct":
+                value, holds = spread_pct, spread_pct >= rule.threshold
+            else:
+                if not average:
+                    continue
+                value = volume / average
+                holds = value >= rule.threshold
+            if not holds:
+                rule.armed = True
+                continue
+            if not rule.armed:
+                continue
+            rule.armed = False
+            rule.fired += 1
+            fired = True
+            self.stats["fired"] += 1
+            if len(self._fired) == self._fired.maxlen:
+                self.stats["dropped"] += 1
+            self._fired.append([rule.id, symbol, rule.condition, rule.threshold, round(value, 4),
+                                _serialize_value(message.timestamp)])
+            if not rule.repeat:
+                self._rules.pop(rule.id, None)
+                self._unindex(rule)
+        if fired and self._loop is not None:
+            for waiter in self._waiters:
+                self._loop.call_soon_threadsafe(waiter.set)
+
+    async def poll(self, timeout: float, max_events: int) -> List[list]:
+        """
+        Take up to max_events fired alerts, waiting up to timeout seconds for the first one.
+        """
+        self._loop = loop = asyncio.get_running_loop()
+        # One-shot rules that fired since the last poll may have left symbols unwatched
+        await self.release()
+        # A rule outlives an unsubscribe_symbols call for its symbol; subscribe it again
+        with self._lock:
+            symbols = {rule.symbol for rule in self._rules.values()}
+        missing = sorted(symbols - set(self._stream.subscribed))
+        if missing:
+            added = await _run_blocking(self._stream.subscribe, missing)
+            with self._lock:
+                self._owned.update(added)
+
+        deadline = loop.time() + timeout
+        waiter = asyncio.Event()
+        with self._lock:
+            self._waiters.append(waiter)
+        try:
+            while True:
+                waiter.clear()
+                with self._lock:
+                    if self._fired:
+                        return [self._fired.popleft() for _ in range(min(max_events, len(self._fired)))]
+                remaining = deadline - loop.time()
+                if remaining <= 0:
+                    return []
+                try:
+                    await asyncio.wait_for(waiter.wait(), remaining)
+                except asyncio.TimeoutError:
+                    pass
+        finally:
+            with self._lock:
+                self._waiters.remove(waiter)
+
+alert_monitor = AlertMonitor(market_stream)
+memory_budget.register("alert_monitor", alert_monitor.memory_bytes)
+
+@mcp.tool()
+async def create_alert(
+    condition: str,
+    threshold: float,
+    symbols: Optional[List[str]] = None,
+    watchlist_id: Optional[str] = None,
+    repeat: bool = False,
+    account: Optional[str] = None
+) -> str:
+    """
+    Registers a server-side alert on symbols or on every symbol of a watchlist. The symbols
+    are subscribed to the live stream and the condition is checked on each tick; collect
+    fired alerts with poll_alerts instead of polling quotes.
+
+    Conditions:
+        price_above / price_below: last trade at or above / at or below threshold
+        move_pct: last trade moved threshold percent from the price when the alert was
+            created (negative thresholds watch for drops)
+        spread_pct: bid/ask spread at least threshold percent of the midpoint
+        volume_spike: a minute bar's volume at least threshold times the average of the
+            previous bars (needs 5 bars of history)
+
+    An alert fires when its condition holds, at once if it already holds at the first tick.
+
+    Args:
+        condition (str): One of price_above, price_below, move_pct, spread_pct, volume_spike
+        threshold (float): Price, percent or volume multiple, depending on the condition
+        symbols (Optional[List[str]]): Stock symbols to watch
+        watchlist_id (Optional[str]): Watch every symbol of this watchlist (in addition to symbols)
+        repeat (bool): Keep the alert after it fires; it fires again each time the condition
+            holds after having stopped holding (default: False, fire once)
+        account (Optional[str]): Account to act on, by its MCP_ACCOUNTS name (default: the ALPACA_API_KEY account)
+
+    Returns:
+        str: The alert IDs created, one per symbol
+    """
+    try:
+        condition = condition.strip().lower()
+        if condition not in ALERT_CONDITIONS:
+            return ToolError(f"Error: Invalid condition '{condition}'. Must be one of: {', '.join(ALERT_CONDITIONS)}")
+        if condition in ("price_above", "price_below", "spread_pct", "volume_spike") and threshold <= 0:
+            return ToolError(f"Error: threshold must be positive for {condition}.")
+        symbols = [s.strip().upper() for s in symbols or [] if s and s.strip()]
+        if watchlist_id:
+            watchlist = await _call_api(trade_client.get_watchlist_by_id, watchlist_id)
+            symbols += [asset.symbol for asset in watchlist.assets or []]
+        symbols = list(dict.fromkeys(symbols))
+        if not symbols:
+            return ToolError("Error: No symbols provided (pass symbols or a non-empty watchlist_id).")
+
+        rules = await alert_monitor.add(symbols, condition, threshold, repeat)
+        result = [f"Created {len(rules)} {condition} alert(s) at {threshold:g}{' (repeating)' if repeat else ''}:"]
+        for rule in rules:
+            reference = f" from ${rule.reference:.2f}" if condition == "move_pct" and rule.reference else ""
+            result.append(f"  {rule.id}: {rule.symbol}{reference}")
+        result.append("Call poll_alerts to collect fired alerts.")
+        return "\n".join(result)
+    except Exception as e:
+        return ToolError(f"Error creating alert: {str(e)}")
+
+@mcp.tool()
+async def list_alerts(format: Optional[str] = None) -> str:
+    """
+    Lists the registered alerts.
+
+    Args:
+        format (Optional[str]): Output format - "text", "json" or "csv" (default: MCP_OUTPUT_FORMAT)
+
+    Returns:
+        str: Each alert's ID, symbol, condition, threshold and how often it has fired
+    """
+    try:
+        fmt = _resolve_format(format)
+        rows = [[rule.id, rule.symbol, rule.condition, rule.threshold, rule.repeat, rule.reference, rule.fired]
+                for rule in alert_monitor.rules()]
+        if fmt != "text":
+            return _render_table(fmt, ALERT_COLUMNS, rows)
+        if not rows:
+            return "No alerts registered."
+        result = [f"Alerts ({len(rows)}):", "-" * 40]
+        for alert_id, symbol, condition, threshold, repeat, _, fired in rows:
+            result.append(f"{alert_id}: {symbol} {condition} {threshold:g}"
+                          f"{', repeating' if repeat else ''}, fired {fired}x")
+        return "\n".join(result)
+    except Exception as e:
+        return ToolError(f"Error listing alerts: {str(e)}")
+
+@mcp.tool()
+async def delete_alert(alert_id: str) -> str:
+    """
+    Deletes an alert, or every alert with alert_id "all". Symbols left without alerts are
+    unsubscribed from the live stream, unless they were subscribed with subscribe_symbols.
+
+    Args:
+        alert_id (str): The alert ID returned by create_alert, or "all"
+
+    Returns:
+        str: Confirmation of the deleted alerts and the symbols unsubscribed
+    """
+    try:
+        if alert_id.strip().lower() == "all":
+            removed = [alert_monitor.remove(rule.id) for rule in alert_monitor.rules()]
+            result = f"Deleted {len([rule for rule in removed if rule])} alert(s)."
+        else:
+            rule = alert_monitor.remove(alert_id.strip())
+            if rule is None:
+                return ToolError(f"Error: No alert with ID '{alert_id}'.")
+            result = f"Deleted alert {rule.id} ({rule.symbol} {rule.condition} {rule.threshold:g})."
+        released = await alert_monitor.release()
+        if released:
+            result += f" Unsubscribed from the live stream: {', '.join(released)}."
+        return result
+    except Exception as e:
+        return ToolError(f"Error deleting alert: {str(e)}")
+
+@mcp.tool()
+async def poll_alerts(timeout: float = 0.0, max_events: int = 100, format: Optional[str] = None) -> str:
+    """
+    Returns the alerts that fired since the last poll. With a timeout it long-polls: it
+    returns as soon as an alert fires, or empty-handed when the timeout passes.
+
+    Args:
+        timeout (float): Seconds to wait for an alert when none is pending, up to 300 (default: 0)
+        max_events (int): Maximum fired alerts to return; the rest stay queued (default: 100)
+        format (Optional[str]): Output format - "text", "json" or "csv" (default: MCP_OUTPUT_FORMAT)
+
+    Returns:
+        str: Fired alerts with the observed value (price, percent or volume multiple) and time
+    """
+    try:
+        fmt = _resolve_format(format)
+        if max_events <= 0:
+            return ToolError("Error: max_events must be positive.")
+        events = await alert_monitor.poll(min(max(timeout, 0.0), 300.0), max_events)
+        if fmt != "text":
+            return _render_table(fmt, FIRED_ALERT_COLUMNS, events)
+        if not events:
+            return f"No alerts fired ({len(alert_monitor.rules())} active)."
+        result = [f"Fired Alerts ({len(events)}):", "-" * 40]
+        for alert_id, symbol, condition, threshold, value, stamp in events:
+            result.append(f"{stamp} {symbol} {condition} {threshold:g}: observed {value:g} (alert {alert_id})")
+        return "\n".join(result)
+    except Exception as e:
+        return ToolError(f"Error polling alerts: {str(e)}")
 
 # ============================================================================
 # Market Information Tools
@@ -1170,7 +5832,7 @@ async def get_market_clock() -> str:
             - Next Close Time
     """
     try:
-        clock = trade_client.get_clock()
+        clock = await _cached_api("get_market_clock", trade_client.get_clock)
         return f"""
                 Market Status:
                 -------------
@@ -1180,12 +5842,13 @@ async def get_market_clock() -> str:
                 Next Close: {clock.next_close}
                 """
     except Exception as e:
-        return f"Error fetching market clock: {str(e)}"
+        return ToolError(f"Error fetching market clock: {str(e)}")
 
 @mcp.tool()
 async def get_market_calendar(start_date: str, end_date: str) -> str:
     """
     Retrieves and formats market calendar for specified date range.
+    Dates within the current year are answered from the prefetched calendar.
     
     Args:
         start_date (str): Start date in YYYY-MM-DD format
@@ -1195,13 +5858,17 @@ async def get_market_calendar(start_date: str, end_date: str) -> str:
         str: Formatted string containing market calendar information
     """
     try:
-        calendar = trade_client.get_calendar(start=start_date, end=end_date)
+        calendar = None
+        if await event_store.ensure_loaded():
+            calendar = event_store.calendar_between(_event_date(start_date), _event_date(end_date))
+        if calendar is None:
+            calendar = await _cached_api("get_market_calendar", trade_client.get_calendar, GetCalendarRequest(start=start_date, end=end_date))
         result = f"Market Calendar ({start_date} to {end_date}):\n----------------------------\n"
         for day in calendar:
             result += f"Date: {day.date}, Open: {day.open}, Close: {day.close}\n"
         return result
     except Exception as e:
-        return f"Error fetching market calendar: {str(e)}"
+        return ToolError(f"Error fetching market calendar: {str(e)}")
 
 # ============================================================================
 # Corporate Actions Tools
@@ -1214,10 +5881,16 @@ async def get_corporate_announcements(
     until: date,
     symbol: Optional[str] = None,
     cusip: Optional[str] = None,
-    date_type: Optional[CorporateActionDateType] = None
+    date_type: Optional[CorporateActionDateType] = None,
+    page_token: Optional[str] = None,
+    max_rows: Optional[int] = None,
+    max_bytes: Optional[int] = None
 ) -> str:
     """
     Retrieves and formats corporate action announcements.
+    Ex-date queries for one symbol within the prefetched window are answered from memory.
+    Responses stop at the row/byte budget with a breakdown of all announcements by type
+    and a page_token for the rest.
     
     Args:
         ca_types (List[CorporateActionType]): List of corporate action types to filter by
@@ -1226,41 +5899,374 @@ async def get_corporate_announcements(
         symbol (Optional[str]): Optional stock symbol to filter by
         cusip (Optional[str]): Optional CUSIP to filter by
         date_type (Optional[CorporateActionDateType]): Optional date type to filter by
+        page_token (Optional[str]): Continuation token from a previous truncated response
+        max_rows (Optional[int]): Maximum announcements in this response (default: MCP_MAX_ROWS)
+        max_bytes (Optional[int]): Approximate maximum response size in bytes (default: MCP_MAX_BYTES)
     
     Returns:
-        str: Formatted string containing corporate announcement details
+        str: Formatted string containing corporate announcement details
+    """
+    try:
+        try:
+            query = {"ca_types": ca_types, "since": since, "until": until, "symbol": symbol, "cusip": cusip,
+                     "date_type": date_type}
+            offset = _resume_listing(page_token, "corporate_announcements", query).get("offset", 0)
+        except ValueError as e:
+            return ToolError(f"Error: {str(e)}")
+        wanted_types = {_serialize_value(t) for t in ca_types}
+        since, until = _event_date(since), _event_date(until)
+        if (symbol and not cusip and date_type == CorporateActionDateType.EX_DATE
+                and wanted_types <= set(PREFETCH_CA_TYPES)
+                and await event_store.ensure_loaded() and event_store.covers(since, until)):
+            announcements = [ann for ann in await event_store.announcements(symbol, "ex_date", since, until)
+                             if _serialize_value(ann.ca_type) in wanted_types]
+        else:
+            request = GetCorporateAnnouncementsRequest(
+                ca_types=ca_types,
+                since=since,
+                until=until,
+                symbol=symbol,
+                cusip=cusip,
+                date_type=date_type
+            )
+            announcements = await _call_api(trade_client.get_corporate_announcements, request)
+        writer = ResponseWriter(max_rows or MCP_MAX_ROWS, max_bytes or MCP_MAX_BYTES)
+        writer.write("Corporate Announcements:\n----------------------\n")
+        for ann in announcements[offset:]:
+            if not writer.add_row(f"""
+                        ID: {ann.id}
+                        Corporate Action ID: {ann.corporate_action_id}
+                        Type: {ann.ca_type}
+                        Sub Type: {ann.ca_sub_type}
+                        Initiating Symbol: {ann.initiating_symbol}
+                        Target Symbol: {ann.target_symbol}
+                        Declaration Date: {ann.declaration_date}
+                        Ex Date: {ann.ex_date}
+                        Record Date: {ann.record_date}
+                        Payable Date: {ann.payable_date}
+                        Cash: {ann.cash}
+                        Old Rate: {ann.old_rate}
+                        New Rate: {ann.new_rate}
+                        ----------------------
+                        """):
+                break
+        shown = offset + writer.rows
+        if shown < len(announcements):
+            _listing_summary(writer, offset, len(announcements), "announcements", {
+                "type": Counter(_serialize_value(ann.ca_type) for ann in announcements),
+            }, _listing_cursor("corporate_announcements", query, offset=shown))
+        return writer.getvalue()
+    except Exception as e:
+        return ToolError(f"Error fetching corporate announcements: {str(e)}")
+
+# ============================================================================
+# Market Calendar and Corporate Actions Store
+# ============================================================================
+
+# Corporate action types prefetched for held and watchlisted symbols
+PREFETCH_CA_TYPES = ("dividend", "split", "merger", "spinoff")
+# Announcement dates indexed for range lookups
+EVENT_DATE_FIELDS = ("ex_date", "record_date", "payable_date", "declaration_date")
+# Prefetched ex-date window around today; the API accepts at most 90 days per request
+EVENT_LOOKBACK_DAYS = 30
+EVENT_LOOKAHEAD_DAYS = 59
+# Seconds between full refreshes of the calendar and the announcements
+EVENT_REFRESH_SECONDS = 86400.0
+# Retry delay after a failed load, doubling up to EVENT_REFRESH_SECONDS
+EVENT_RETRY_SECONDS = 30.0
+# How long get_upcoming_corporate_actions waits for the first load
+EVENT_READY_WAIT_SECONDS = 10.0
+CORPORATE_EVENT_COLUMNS = ["symbol", "ca_type", "ca_sub_type", "ex_date", "record_date", "payable_date",
+                           "declaration_date", "cash", "old_rate", "new_rate"]
+
+def _event_date(value) -> Optional[date]:
+    if value is None or isinstance(value, date):
+        return value
+    return date.fromisoformat(str(value)[:10])
+
+class _SymbolEvents:
+    """One symbol's announcements, sorted by each date field for bisect range lookups."""
+
+    __slots__ = ("announcements", "_index", "size", "used")
+
+    def __init__(self, announcements: List[Any]):
+        self.announcements = announcements
+        self._index = {}
+        for field in EVENT_DATE_FIELDS:
+            keyed = sorted(((_event_date(getattr(a, field, None)), i) for i, a in enumerate(announcements)
+                            if getattr(a, field, None) is not None))
+            self._index[field] = ([d for d, _ in keyed], [announcements[i] for _, i in keyed])
+        # The index lists share the announcement objects, so they only add their slots and dates
+        self.size = _approx_size(announcements) + sum(
+            2 * sys.getsizeof(dates) + 32 * len(dates) for dates, _ in self._index.values())
+        self.used = time.monotonic()
+
+    def between(self, field: str, since: date, until: date) -> List[Any]:
+        self.used = time.monotonic()
+        dates, announcements = self._index[field]
+        return announcements[bisect.bisect_left(dates, since):bisect.bisect_right(dates, until)]
+
+class CorporateEventStore:
+    """
+    The market calendar for the year and the corporate actions (dividends, splits, mergers,
+    spinoffs) of held and watchlisted symbols, prefetched into memory once a day.
+
+    The calendar is a sorted date list and each symbol's announcements are sorted by every
+    date field, so range lookups are O(log n) bisects. The universe spans every account.
+    When positions change (the order mirrors count fills) or a watchlist is edited, only symbols that entered the universe
+    are fetched and symbols that left it are dropped; the rest is kept until the daily refresh.
+    Over the memory budget, the least recently read symbols are dropped and fetched again
+    on their next lookup.
+
+    Started lazily from the first tool call that needs it, like the order mirror. Loading
+    and syncing run only in that background task: lookups never wait on it and go to REST
+    until the first load completes, and a failed load is retried with backoff.
+    """
+
+    def __init__(self, enabled: bool = True):
+        self.enabled = enabled
+        self.last_error: Optional[str] = None
+        self.stats: Dict[str, int] = defaultdict(int)
+        self._calendar_dates: List[date] = []
+        self._calendar: List[Any] = []
+        self._calendar_range: Optional[tuple] = None
+        self._calendar_bytes = 0
+        self._events: Dict[str, _SymbolEvents] = {}
+        self._evicted: set = set()  # Universe symbols dropped for the memory budget, fetched on lookup
+        self._coverage: Optional[tuple] = None  # Ex-date window the announcements cover
+        self._extra: set = set()  # Symbols looked up outside the universe, kept until the refresh
+        self._fill_generation = -1
+        self._universe_stale = True
+        self._loaded_at = 0.0
+        self._lock = asyncio.Lock()
+        self._wake: Optional[asyncio.Event] = None
+        self._ready: Optional[asyncio.Event] = None
+        self._refresher: Optional[asyncio.Task] = None
+
+    @property
+    def ready(self) -> bool:
+        return self._coverage is not None
+
+    async def ensure_loaded(self) -> bool:
+        """
+        Start the background loader and ask it to resync the universe when positions or
+        watchlists changed. Never waits for REST: returns whether the store can answer
+        lookups now, so callers fall back to REST while it loads.
+        """
+        if not self.enabled:
+            return False
+        if self._refresher is None or self._refresher.done():
+            self._wake, self._ready = asyncio.Event(), asyncio.Event()
+            self._refresher = _background_task(self._refresh_loop())
+        elif self._universe_stale or _fills_seen() != self._fill_generation:
+            self._wake.set()
+        return self.ready
+
+    async def wait_ready(self, timeout: float) -> bool:
+        """ensure_loaded, then wait up to timeout for the first load to complete."""
+        if await self.ensure_loaded():
+            return True
+        try:
+            await asyncio.wait_for(self._ready.wait(), timeout)
+        except asyncio.TimeoutError:
+            pass
+        return self.ready
+
+    def invalidate_universe(self) -> None:
+        """Re-read positions and watchlists soon (called after watchlist edits)."""
+        self._universe_stale = True
+        if self._wake is not None:
+            self._wake.set()
+
+    async def _refresh_loop(self) -> None:
+        """Load the store, then keep it current: a full refresh daily, universe syncs when woken."""
+        retry = EVENT_RETRY_SECONDS
+        while True:
+            self._wake.clear()
+            try:
+                if not self._loaded_at or time.monotonic() - self._loaded_at >= EVENT_REFRESH_SECONDS:
+                    await self._refresh()
+                elif self._universe_stale or _fills_seen() != self._fill_generation:
+                    await self._sync_universe()
+                self.last_error = None
+                retry = EVENT_RETRY_SECONDS
+                delay = EVENT_REFRESH_SECONDS - (time.monotonic() - self._loaded_at)
+            except Exception as e:
+                # Back off rather than retrying on every lookup; lookups fall back to REST meanwhile
+                self.stats["errors"] += 1
+                self.last_error = str(e)
+                delay, retry = retry, min(retry * 2, EVENT_REFRESH_SECONDS)
+                await asyncio.sleep(delay)
+                continue
+            try:
+                await asyncio.wait_for(self._wake.wait(), max(delay, 0))
+            except asyncio.TimeoutError:
+                pass
+
+    async def _account_symbols(self, account: TradingAccount) -> set:
+        positions = await account.mirror.get_positions()
+        watchlists = await _call_api(account.client.get_watchlists)
+        details = await asyncio.gather(*(_call_api(account.client.get_watchlist_by_id, wl.id) for wl in watchlists))
+        symbols = {p.symbol for p in positions if _parse_occ_symbol(p.symbol) is None}
+        symbols.update(asset.symbol for wl in details for asset in (wl.assets or []))
+        return symbols
+
+    async def _universe(self) -> set:
+        """Held and watchlisted stock symbols across every account."""
+        generation = _fills_seen()
+        self._universe_stale = False  # Edits made while this runs mark it stale again
+        try:
+            symbols = set().union(*await asyncio.gather(*(self._account_symbols(a) for a in accounts.values())))
+        except Exception:
+            self._universe_stale = True
+            raise
+        self._fill_generation = generation
+        return symbols
+
+    async def _fetch_events(self, symbols: set, coverage: Optional[tuple] = None) -> Dict[str, _SymbolEvents]:
+        since, until = coverage or self._coverage
+
+        async def fetch(symbol: str):
+            request = GetCorporateAnnouncementsRequest(
+                ca_types=[CorporateActionType(t) for t in PREFETCH_CA_TYPES],
+                since=since, until=until, symbol=symbol, date_type=CorporateActionDateType.EX_DATE
+            )
+            return symbol, await _call_api(trade_client.get_corporate_announcements, request)
+
+        results = await asyncio.gather(*(fetch(symbol) for symbol in sorted(symbols)))
+        self.stats["symbol_loads"] += len(results)
+        return {symbol: _SymbolEvents(list(announcements or [])) for symbol, announcements in results}
+
+    async def _refresh(self) -> None:
+        # Everything is fetched before anything is replaced, so a failed refresh leaves the
+        # previous data (or an unready store) and never a half-loaded one
+        today = datetime.now(MARKET_TIMEZONE).date()
+        year_start, year_end = date(today.year, 1, 1), date(today.year, 12, 31)
+        if today.month == 12:
+            year_end = date(today.year + 1, 12, 31)  # Year-end questions reach into next year
+        calendar = await _call_api(trade_client.get_calendar, GetCalendarRequest(start=year_start, end=year_end))
+        coverage = (today - timedelta(days=EVENT_LOOKBACK_DAYS), today + timedelta(days=EVENT_LOOKAHEAD_DAYS))
+        events = await self._fetch_events(await self._universe(), coverage)
+
+        self._calendar = sorted(calendar, key=lambda day: _event_date(day.date))
+        self._calendar_dates = [_event_date(day.date) for day in self._calendar]
+        self._calendar_range = (year_start, year_end)
+        self._calendar_bytes = _approx_size(self._calendar) + _approx_size(self._calendar_dates)
+        self._coverage = coverage
+        self._events, self._extra, self._evicted = events, set(), set()
+        self._loaded_at = time.monotonic()
+        self._ready.set()
+        self.stats["refreshes"] += 1
+
+    async def _sync_universe(self) -> None:
+        symbols = await self._universe() | self._extra
+        self._evicted &= symbols
+        added = symbols - set(self._events) - self._evicted
+        if added:
+            self._events.update(await self._fetch_events(added))
+        for symbol in set(self._events) - symbols - self._extra:
+            del self._events[symbol]
+        self.stats["universe_syncs"] += 1
+
+    def calendar_between(self, start: date, end: date) -> Optional[List[Any]]:
+        """Trading days in [start, end], or None when the range is outside the prefetched year."""
+        if self._calendar_range is None or start < self._calendar_range[0] or end > self._calendar_range[1]:
+            return None
+        self.stats["calendar_hits"] += 1
+        return self._calendar[bisect.bisect_left(self._calendar_dates, start):bisect.bisect_right(self._calendar_dates, end)]
+
+    def covers(self, since: date, until: date) -> bool:
+        return self._coverage is not None and self._coverage[0] <= since and until <= self._coverage[1]
+
+    async def announcements(self, symbol: str, field: str, since: date, until: date) -> List[Any]:
+        """A symbol's prefetched announcements with field in [since, until]; loads symbols outside the universe."""
+        symbol = symbol.upper()
+        if symbol not in self._events:
+            async with self._lock:  # Concurrent lookups of one new symbol share a fetch
+                if symbol not in self._events:
+                    self._events.update(await self._fetch_events({symbol}))
+                    if symbol in self._evicted:
+                        self._evicted.discard(symbol)
+                    else:
+                        self._extra.add(symbol)
+        self.stats["announcement_hits"] += 1
+        return self._events[symbol].between(field, since, until)
+
+    @property
+    def symbols(self) -> List[str]:
+        return sorted(set(self._events) | self._evicted)
+
+    def memory_bytes(self) -> int:
+        return self._calendar_bytes + sum(events.size for events in self._events.values())
+
+    def evict(self, target: int) -> int:
+        """Drop the least recently read symbols until about target bytes are freed; the calendar stays."""
+        freed = 0
+        for symbol, events in sorted(self._events.items(), key=lambda item: item[1].used):
+            if freed >= target:
+                break
+            del self._events[symbol]
+            if symbol in self._extra:
+                self._extra.discard(symbol)  # An ad-hoc lookup: simply forgotten
+            else:
+                self._evicted.add(symbol)
+            freed += events.size
+            self.stats["evictions"] += 1
+        return freed
+
+def _fills_seen() -> int:
+    return sum(account.mirror.fill_generation for account in accounts.values())
+
+event_store = CorporateEventStore(enabled=MCP_EVENT_PREFETCH)
+memory_budget.register("event_store", event_store.memory_bytes, event_store.evict, priority=20)
+
+@mcp.tool()
+async def get_upcoming_corporate_actions(
+    symbols: Optional[List[str]] = None,
+    days: int = 30,
+    format: Optional[str] = None
+) -> str:
+    """
+    Lists dividends, splits, mergers and spinoffs with an ex-date in the next days, for the
+    given symbols or, by default, every held and watchlisted symbol. Answered from the daily
+    prefetched store, so checking a whole portfolio costs no API requests.
+
+    Args:
+        symbols (Optional[List[str]]): Stock symbols to check (default: all positions and watchlist symbols)
+        days (int): Days ahead to look, up to 59 (default: 30)
+        format (Optional[str]): Output format - "text", "json" or "csv" (default: MCP_OUTPUT_FORMAT)
+
+    Returns:
+        str: Each upcoming corporate action with its type and ex, record and payable dates
     """
     try:
-        request = GetCorporateAnnouncementsRequest(
-            ca_types=ca_types,
-            since=since,
-            until=until,
-            symbol=symbol,
-            cusip=cusip,
-            date_type=date_type
-        )
-        announcements = trade_client.get_corporate_announcements(request)
-        result = "Corporate Announcements:\n----------------------\n"
-        for ann in announcements:
-            result += f"""
-                        ID: {ann.id}
-                        Corporate Action ID: {ann.corporate_action_id}
-                        Type: {ann.ca_type}
-                        Sub Type: {ann.ca_sub_type}
-                        Initiating Symbol: {ann.initiating_symbol}
-                        Target Symbol: {ann.target_symbol}
-                        Declaration Date: {ann.declaration_date}
-                        Ex Date: {ann.ex_date}
-                        Record Date: {ann.record_date}
-                        Payable Date: {ann.payable_date}
-                        Cash: {ann.cash}
-                        Old Rate: {ann.old_rate}
-                        New Rate: {ann.new_rate}
-                        ----------------------
-                        """
-        return result
+        fmt = _resolve_format(format)
+        if not 0 <= days <= EVENT_LOOKAHEAD_DAYS:
+            return ToolError(f"Error: days must be between 0 and {EVENT_LOOKAHEAD_DAYS}.")
+        if not await event_store.wait_ready(EVENT_READY_WAIT_SECONDS):
+            reason = event_store.last_error or ("still loading" if event_store.enabled else "MCP_EVENT_PREFETCH is off")
+            return ToolError(f"Error: Corporate actions store unavailable ({reason}). Use get_corporate_announcements instead.")
+        today = datetime.now(MARKET_TIMEZONE).date()
+        until = today + timedelta(days=days)
+        wanted = [s.strip().upper() for s in symbols if s and s.strip()] if symbols else event_store.symbols
+        rows = []
+        for symbol in dict.fromkeys(wanted):
+            for ann in await event_store.announcements(symbol, "ex_date", today, until):
+                rows.append([symbol] + [_serialize_value(getattr(ann, column, None)) for column in CORPORATE_EVENT_COLUMNS[1:]])
+        rows.sort(key=lambda row: (row[3] or "", row[0]))
+        if fmt != "text":
+            return _render_table(fmt, CORPORATE_EVENT_COLUMNS, rows,
+                                 {"since": today.isoformat(), "until": until.isoformat(), "symbols_checked": len(wanted)})
+        if not rows:
+            return f"No corporate actions with an ex-date through {until} for {len(wanted)} symbols."
+        result = [f"Upcoming Corporate Actions ({today} to {until}, {len(wanted)} symbols checked):", "-" * 40]
+        for symbol, ca_type, sub_type, ex_date, record_date, payable_date, _, cash, old_rate, new_rate in rows:
+            detail = f"${float(cash):.4f}/share" if cash else (f"{old_rate}:{new_rate}" if new_rate else "")
+            result.append(f"{ex_date} {symbol} {ca_type}{f' ({sub_type})' if sub_type else ''} {detail}".rstrip()
+                          + (f", record {record_date}, payable {payable_date}" if payable_date else ""))
+        return "\n".join(result)
     except Exception as e:
-        return f"Error fetching corporate announcements: {str(e)}"
+        return ToolError(f"Error fetching upcoming corporate actions: {str(e)}")
 
 # ============================================================================
 # Options Trading Tools
@@ -1275,11 +6281,16 @@ async def get_option_contracts(
     type: Optional[ContractType] = None,
     status: Optional[AssetStatus] = None,
     root_symbol: Optional[str] = None,
-    limit: Optional[int] = None
+    limit: Optional[int] = None,
+    page_token: Optional[str] = None,
+    max_rows: Optional[int] = None,
+    max_bytes: Optional[int] = None,
+    format: Optional[str] = None
 ) -> str:
     """
     Retrieves metadata for option contracts based on specified criteria. This endpoint returns contract specifications
-    and static data, not real-time pricing information.
+    and static data, not real-time pricing information. Responses stop at the row/byte budget, or at the end
+    of an upstream page, with a page_token for the rest.
     
     Args:
         underlying_symbol (str): The symbol of the underlying asset (e.g., 'AAPL')
@@ -1289,7 +6300,11 @@ async def get_option_contracts(
         type (Optional[ContractType]): Optional contract type (CALL or PUT)
         status (Optional[AssetStatus]): Optional asset status filter (e.g., ACTIVE)
         root_symbol (Optional[str]): Optional root symbol for the option
-        limit (Optional[int]): Optional maximum number of contracts to return
+        limit (Optional[int]): Optional maximum number of contracts per upstream page
+        page_token (Optional[str]): Continuation token from a previous response
+        max_rows (Optional[int]): Maximum contracts in this response (default: MCP_MAX_ROWS)
+        max_bytes (Optional[int]): Approximate maximum response size in bytes (default: MCP_MAX_BYTES)
+        format (Optional[str]): Output format - "text", "json" or "csv" (default: MCP_OUTPUT_FORMAT)
     
     Returns:
         str: Formatted string containing option contract metadata including:
@@ -1307,6 +6322,15 @@ async def get_option_contracts(
         information (bid/ask prices, sizes, etc.), use get_option_latest_quote instead.
     """
     try:
+        fmt = _resolve_format(format)
+        try:
+            query = {"underlying_symbol": underlying_symbol, "expiration_date": expiration_date,
+                     "strike_price_gte": strike_price_gte, "strike_price_lte": strike_price_lte, "type": type,
+                     "status": status, "root_symbol": root_symbol, "limit": limit}
+            state = _resume_listing(page_token, "option_contracts", query)
+        except ValueError as e:
+            return ToolError(f"Error: {str(e)}")
+        token, offset = state.get("token"), state.get("offset", 0)
         # Create the request object with all available parameters
         request = GetOptionContractsRequest(
             underlying_symbols=[underlying_symbol],
@@ -1316,21 +6340,43 @@ async def get_option_contracts(
             type=type,
             status=status,
             root_symbol=root_symbol,
-            limit=limit
+            limit=limit,
+            page_token=token
         )
         
         # Get the option contracts
-        response = trade_client.get_option_contracts(request)
+        response = await _cached_api("get_option_contracts", trade_client.get_option_contracts, request)
+        contracts = response.option_contracts if response and response.option_contracts else []
+        upstream_token = getattr(response, "next_page_token", None) if response else None
+        writer = ResponseWriter(max_rows or MCP_MAX_ROWS, max_bytes or MCP_MAX_BYTES)
         
-        if not response or not response.option_contracts:
+        def next_cursor() -> Optional[str]:
+            # The rest of this upstream page first, then the next upstream page
+            shown = offset + writer.rows
+            if shown < len(contracts):
+                return _listing_cursor("option_contracts", query, token=token, offset=shown)
+            if upstream_token:
+                return _listing_cursor("option_contracts", query, token=upstream_token, offset=0)
+            return None
+        
+        if fmt != "text":
+            renderer = TableRenderer(fmt, OPTION_CONTRACT_COLUMNS)
+            writer.write(renderer.begin({"underlying_symbol": underlying_symbol}))
+            for contract in contracts[offset:]:
+                if not writer.add_row(renderer.row(_serialize_option_contract(contract))):
+                    break
+            writer.write(renderer.end({"next_page_token": next_cursor()}))
+            return writer.getvalue()
+        
+        if not contracts:
             return f"No option contracts found for {underlying_symbol} matching the criteria."
         
         # Format the response
-        result = f"Option Contracts for {underlying_symbol}:\n"
-        result += "----------------------------------------\n"
+        writer.write(f"Option Contracts for {underlying_symbol}:\n")
+        writer.write("----------------------------------------\n")
         
-        for contract in response.option_contracts:
-            result += f"""
+        for contract in contracts[offset:]:
+            if not writer.add_row(f"""
                 Symbol: {contract.symbol}
                 Name: {contract.name}
                 Type: {contract.type}
@@ -1346,12 +6392,23 @@ async def get_option_contracts(
                 Close Price: ${float(contract.close_price) if contract.close_price else 'N/A'}
                 Close Price Date: {contract.close_price_date}
                 -------------------------
-                """
+                """):
+                break
         
-        return result
+        cursor = next_cursor()
+        if offset + writer.rows < len(contracts):
+            _listing_summary(writer, offset, len(contracts), "contracts", {
+                "type": Counter(_serialize_value(contract.type) for contract in contracts),
+                "expiration": Counter(str(contract.expiration_date) for contract in contracts),
+            }, cursor)
+            if upstream_token:
+                writer.write("Breakdowns cover this upstream page; further pages follow.\n")
+        elif cursor:
+            writer.write(f"\nMore contracts available - call again with page_token='{cursor}'\n")
+        return writer.getvalue()
         
     except Exception as e:
-        return f"Error fetching option contracts: {str(e)}"
+        return ToolError(f"Error fetching option contracts: {str(e)}")
 
 @mcp.tool()
 async def get_option_latest_quote(
@@ -1388,7 +6445,7 @@ async def get_option_latest_quote(
         )
         
         # Get the latest quote
-        quotes = option_historical_data_client.get_option_latest_quote(request)
+        quotes = await _call_api(option_historical_data_client.get_option_latest_quote, request)
         
         if symbol in quotes:
             quote = quotes[symbol]
@@ -1409,11 +6466,15 @@ async def get_option_latest_quote(
             return f"No quote data found for {symbol}."
             
     except Exception as e:
-        return f"Error fetching option quote: {str(e)}"
+        return ToolError(f"Error fetching option quote: {str(e)}")
 
 
 @mcp.tool()
-async def get_option_snapshot(symbol_or_symbols: Union[str, List[str]], feed: Optional[OptionsFeed] = None) -> str:
+async def get_option_snapshot(
+    symbol_or_symbols: Union[str, List[str]],
+    feed: Optional[OptionsFeed] = None,
+    format: Optional[str] = None
+) -> str:
     """
     Retrieves comprehensive snapshots of option contracts including latest trade, quote, implied volatility, and Greeks.
     This endpoint provides a complete view of an option's current market state and theoretical values.
@@ -1423,6 +6484,7 @@ async def get_option_snapshot(symbol_or_symbols: Union[str, List[str]], feed: Op
             (e.g., 'AAPL250613P00205000')
         feed (Optional[OptionsFeed]): The source feed of the data (opra or indicative).
             Default: opra if the user has the options subscription, indicative otherwise.
+        format (Optional[str]): Output format - "text", "json" or "csv" (default: MCP_OUTPUT_FORMAT)
     
     Returns:
         str: Formatted string containing a comprehensive snapshot including:
@@ -1447,6 +6509,7 @@ async def get_option_snapshot(symbol_or_symbols: Union[str, List[str]], feed: Op
                 * Vega (volatility sensitivity)
     """
     try:
+        fmt = _resolve_format(format)
         # Create snapshot request
         request = OptionSnapshotRequest(
             symbol_or_symbols=symbol_or_symbols,
@@ -1454,7 +6517,12 @@ async def get_option_snapshot(symbol_or_symbols: Union[str, List[str]], feed: Op
         )
         
         # Get snapshots
-        snapshots = option_historical_data_client.get_option_snapshot(request)
+        snapshots = await _call_api(option_historical_data_client.get_option_snapshot, request)
+        
+        if fmt != "text":
+            symbols = [symbol_or_symbols] if isinstance(symbol_or_symbols, str) else symbol_or_symbols
+            rows = [_serialize_option_snapshot(symbol, snapshots[symbol]) for symbol in symbols if snapshots.get(symbol)]
+            return _render_table(fmt, OPTION_SNAPSHOT_COLUMNS, rows)
         
         # Format the response
         result = "Option Snapshots:\n"
@@ -1523,7 +6591,203 @@ async def get_option_snapshot(symbol_or_symbols: Union[str, List[str]], feed: Op
         return result
         
     except Exception as e:
-        return f"Error retrieving option snapshots: {str(e)}"
+        return ToolError(f"Error retrieving option snapshots: {str(e)}")
+
+# ============================================================================
+# Options Trading Tools - Option Chain
+# ============================================================================
+
+# Maximum page size accepted by the option contracts endpoint
+OPTION_CONTRACTS_PAGE_LIMIT = 10000
+
+OPTION_CHAIN_COLUMNS = ["expiration_date", "dte", "strike_price"] + [
+    f"{side}_{field}" for side in ("call", "put")
+    for field in ("symbol", "bid", "ask", "iv", "delta", "gamma", "theta", "vega")
+]
+
+async def _get_underlying_price(symbol: str) -> Optional[float]:
+    """Latest trade price for a stock, from the live stream when subscribed, otherwise REST."""
+    trade = market_stream.get_trade(symbol)
+    if trade is None:
+        trades = await _call_api(
+            stock_historical_data_client.get_stock_latest_trade,
+            StockLatestTradeRequest(symbol_or_symbols=symbol)
+        )
+        trade = trades.get(symbol)
+    return float(trade.price) if trade is not None else None
+
+async def _get_all_option_contracts(
+    underlying_symbol: str,
+    expiration_date_gte: Optional[date],
+    expiration_date_lte: Optional[date],
+    contract_type: Optional[ContractType]
+) -> List[Any]:
+    """
+    Page through every active contract for an underlying. Contract metadata changes
+    slowly, so the full list is cached and repeat chain pulls only refresh prices.
+    """
+    async def fetch_all() -> List[Any]:
+        contracts = []
+        page_token = None
+        while True:
+            response = await _call_api(trade_client.get_option_contracts, GetOptionContractsRequest(
+                underlying_symbols=[underlying_symbol],
+                status=AssetStatus.ACTIVE,
+                expiration_date_gte=expiration_date_gte,
+                expiration_date_lte=expiration_date_lte,
+                type=contract_type,
+                limit=OPTION_CONTRACTS_PAGE_LIMIT,
+                page_token=page_token
+            ))
+            contracts.extend(response.option_contracts or [])
+            page_token = response.next_page_token
+            if not page_token:
+                return contracts
+
+    key = ResponseCache.make_key("get_option_chain_contracts", (), {
+        "underlying_symbol": underlying_symbol, "expiration_date_gte": expiration_date_gte,
+        "expiration_date_lte": expiration_date_lte, "type": contract_type,
+    })
+    return await response_cache.get_or_fetch("get_option_chain_contracts", key, fetch_all)
+
+def _in_range(value: Optional[float], low: Optional[float], high: Optional[float]) -> bool:
+    if low is None and high is None:
+        return True
+    if value is None:
+        return False
+    return (low is None or value >= low) and (high is None or value <= high)
+
+@mcp.tool()
+async def get_option_chain(
+    underlying_symbol: str,
+    min_dte: Optional[int] = 0,
+    max_dte: Optional[int] = 60,
+    contract_type: Optional[ContractType] = None,
+    max_moneyness_pct: Optional[float] = None,
+    min_delta: Optional[float] = None,
+    max_delta: Optional[float] = None,
+    feed: Optional[OptionsFeed] = None,
+    max_rows: Optional[int] = None,
+    format: Optional[str] = None
+) -> str:
+    """
+    Builds an option chain for an underlying in one call: pages through all matching contracts,
+    fetches their snapshots in parallel chunks and returns a strike x expiration grid with
+    bid/ask, implied volatility and Greeks for calls and puts side by side.
+    
+    Args:
+        underlying_symbol (str): The symbol of the underlying asset (e.g., 'AAPL')
+        min_dte (Optional[int]): Minimum days to expiration (default: 0)
+        max_dte (Optional[int]): Maximum days to expiration (default: 60)
+        contract_type (Optional[ContractType]): Only calls or only puts (default: both)
+        max_moneyness_pct (Optional[float]): Only strikes within this percentage of the underlying
+            price (e.g., 10 keeps strikes within +/-10% of spot)
+        min_delta (Optional[float]): Minimum absolute delta (e.g., 0.2)
+        max_delta (Optional[float]): Maximum absolute delta (e.g., 0.8)
+        feed (Optional[OptionsFeed]): The source feed of the data (opra or indicative)
+        max_rows (Optional[int]): Maximum grid rows in the response (default: MCP_MAX_ROWS)
+        format (Optional[str]): Output format - "text", "json" or "csv" (default: MCP_OUTPUT_FORMAT)
+    
+    Returns:
+        str: Option chain grid ordered by expiration and strike
+    """
+    try:
+        fmt = _resolve_format(format)
+        underlying_symbol = underlying_symbol.strip().upper()
+        today = date.today()
+        expiration_gte = today + timedelta(days=min_dte) if min_dte is not None else None
+        expiration_lte = today + timedelta(days=max_dte) if max_dte is not None else None
+        
+        contracts, spot = await asyncio.gather(
+            _get_all_option_contracts(underlying_symbol, expiration_gte, expiration_lte, contract_type),
+            _get_underlying_price(underlying_symbol)
+        )
+        if not contracts:
+            return f"No option contracts found for {underlying_symbol} matching the criteria."
+        
+        # Apply the moneyness filter before fetching prices so only relevant strikes are priced
+        if max_moneyness_pct is not None:
+            if spot is None:
+                return ToolError(f"Error: Could not determine the price of {underlying_symbol} for the moneyness filter.")
+            band = spot * max_moneyness_pct / 100
+            contracts = [c for c in contracts if abs(float(c.strike_price) - spot) <= band]
+        
+        snapshots, failed = await _fetch_symbol_chunks(
+            option_historical_data_client.get_option_snapshot,
+            lambda chunk: OptionSnapshotRequest(symbol_or_symbols=chunk, feed=feed),
+            [c.symbol for c in contracts]
+        )
+        
+        # Merge calls and puts into one row per (expiration, strike)
+        grid: Dict[tuple, Dict[str, Any]] = {}
+        for contract in contracts:
+            snapshot = snapshots.get(contract.symbol)
+            greeks = snapshot.greeks if snapshot else None
+            delta = greeks.delta if greeks else None
+            if not _in_range(abs(delta) if delta is not None else None, min_delta, max_delta):
+                continue
+            quote = snapshot.latest_quote if snapshot else None
+            side = "call" if contract.type == ContractType.CALL else "put"
+            row = grid.setdefault((contract.expiration_date, float(contract.strike_price)), {})
+            row.update({
+                f"{side}_symbol": contract.symbol,
+                f"{side}_bid": quote.bid_price if quote else None,
+                f"{side}_ask": quote.ask_price if quote else None,
+                f"{side}_iv": snapshot.implied_volatility if snapshot else None,
+                f"{side}_delta": delta,
+                f"{side}_gamma": greeks.gamma if greeks else None,
+                f"{side}_theta": greeks.theta if greeks else None,
+                f"{side}_vega": greeks.vega if greeks else None,
+            })
+        
+        rows = []
+        for (expiration, strike), values in sorted(grid.items()):
+            values.update(expiration_date=expiration.isoformat(), dte=(expiration - today).days, strike_price=strike)
+            rows.append([values.get(column) for column in OPTION_CHAIN_COLUMNS])
+        
+        writer = ResponseWriter(max_rows or MCP_MAX_ROWS, MCP_MAX_BYTES)
+        meta = {"underlying_symbol": underlying_symbol, "underlying_price": spot}
+        if fmt != "text":
+            renderer = TableRenderer(fmt, OPTION_CHAIN_COLUMNS)
+            writer.write(renderer.begin(meta))
+            for row in rows:
+                if not writer.add_row(renderer.row(row)):
+                    break
+            writer.write(renderer.end({
+                "truncated_rows": len(rows) - writer.rows or None,
+                "unpriced_contracts": len(failed) or None
+            }))
+            return writer.getvalue()
+        
+        spot_text = f"${spot:.2f}" if spot is not None else "N/A"
+        writer.write(f"Option Chain for {underlying_symbol} (Underlying: {spot_text}, {len(rows)} strikes):\n")
+        writer.write("Strike | Call Bid/Ask IV Delta | Put Bid/Ask IV Delta\n")
+        
+        def leg_text(row: List[Any], side: str) -> str:
+            values = dict(zip(OPTION_CHAIN_COLUMNS, row))
+            if values[f"{side}_symbol"] is None:
+                return "-"
+            bid, ask, iv, delta = (values[f"{side}_{field}"] for field in ("bid", "ask", "iv", "delta"))
+            return (f"{f'{bid:.2f}' if bid is not None else 'N/A'}/{f'{ask:.2f}' if ask is not None else 'N/A'} "
+                    f"{f'{iv:.1%}' if iv is not None else 'N/A'} {f'{delta:.3f}' if delta is not None else 'N/A'}")
+        
+        current_expiration = None
+        for row in rows:
+            expiration, dte, strike = row[0], row[1], row[2]
+            text = f"{strike:.2f} | {leg_text(row, 'call')} | {leg_text(row, 'put')}\n"
+            if expiration != current_expiration:
+                text = f"\nExpiration {expiration} ({dte} DTE):\n" + text
+                current_expiration = expiration
+            if not writer.add_row(text):
+                break
+        
+        if writer.rows < len(rows):
+            writer.write(f"\nShowing {writer.rows} of {len(rows)} strikes. Narrow the DTE, moneyness or delta range to see the rest.\n")
+        if failed:
+            writer.write(f"\nCould not price {len(failed)} contracts: {next(iter(failed.values()))}\n")
+        return writer.getvalue()
+    except Exception as e:
+        return ToolError(f"Error building option chain: {str(e)}")
 
 # ============================================================================
 # Options Trading Helper Functions
@@ -1532,13 +6796,13 @@ async def get_option_snapshot(symbol_or_symbols: Union[str, List[str]], feed: Op
 def _validate_option_order_inputs(legs: List[Dict[str, Any]], quantity: int, time_in_force: TimeInForce) -> Optional[str]:
     """Validate inputs for option order placement."""
     if not legs:
-        return "Error: No option legs provided"
+        return ToolError("Error: No option legs provided")
     if len(legs) > 4:
-        return "Error: Maximum of 4 legs allowed for option orders"
+        return ToolError("Error: Maximum of 4 legs allowed for option orders")
     if quantity <= 0:
-        return "Error: Quantity must be positive"
+        return ToolError("Error: Quantity must be positive")
     if time_in_force != TimeInForce.DAY:
-        return "Error: Only DAY time_in_force is supported for options trading"
+        return ToolError("Error: Only DAY time_in_force is supported for options trading")
     return None
 
 def _convert_order_class_string(order_class: Optional[Union[str, OrderClass]]) -> Union[OrderClass, str]:
@@ -1555,7 +6819,7 @@ def _convert_order_class_string(order_class: Optional[Union[str, OrderClass]]) -
         if order_class_upper in class_mapping:
             return class_mapping[order_class_upper]
         else:
-            return f"Invalid order class: {order_class}. Must be one of: simple, bracket, oco, oto, mleg"
+            return ToolError(f"Invalid order class: {order_class}. Must be one of: simple, bracket, oco, oto, mleg")
     return order_class
 
 def _process_option_legs(legs: List[Dict[str, Any]]) -> Union[List[OptionLegRequest], str]:
@@ -1564,15 +6828,11 @@ def _process_option_legs(legs: List[Dict[str, Any]]) -> Union[List[OptionLegRequ
     for leg in legs:
         # Validate ratio_qty
         if not isinstance(leg['ratio_qty'], int) or leg['ratio_qty'] <= 0:
-            return f"Error: Invalid ratio_qty for leg {leg['symbol']}. Must be positive integer."
+            return ToolError(f"Error: Invalid ratio_qty for leg {leg['symbol']}. Must be positive integer.")
         
-        # Convert side string to enum
-        if leg['side'].lower() == "buy":
-            order_side = OrderSide.BUY
-        elif leg['side'].lower() == "sell":
-            order_side = OrderSide.SELL
-        else:
-            return f"Invalid order side: {leg['side']}. Must be 'buy' or 'sell'."
+        order_side = ORDER_SIDES.get(leg['side'].lower())
+        if order_side is None:
+            return ToolError(f"Invalid order side: {leg['side']}. Must be 'buy' or 'sell'.")
         
         order_legs.append(OptionLegRequest(
             symbol=leg['symbol'],
@@ -1589,13 +6849,15 @@ def _create_option_market_order_request(
     extended_hours: bool
 ) -> MarketOrderRequest:
     """Create the appropriate MarketOrderRequest based on order class."""
+    # Unique per order, so a retried submission can be looked up by it without matching another order
+    option_order_id = f"mcp_opt_{int(time.time())}_{uuid.uuid4().hex[:8]}"
     if order_class == OrderClass.MLEG:
         return MarketOrderRequest(
             qty=quantity,
             order_class=order_class,
             time_in_force=time_in_force,
             extended_hours=extended_hours,
-            client_order_id=f"mcp_opt_{int(time.time())}",
+            client_order_id=option_order_id,
             type=OrderType.MARKET,
             legs=order_legs
         )
@@ -1608,7 +6870,7 @@ def _create_option_market_order_request(
             order_class=order_class,
             time_in_force=time_in_force,
             extended_hours=extended_hours,
-            client_order_id=f"mcp_opt_{int(time.time())}",
+            client_order_id=option_order_id,
             type=OrderType.MARKET
         )
 
@@ -1662,30 +6924,24 @@ def _analyze_option_strategy_type(order_legs: List[OptionLegRequest], order_clas
     
     if order_class == OrderClass.MLEG and len(order_legs) == 2:
         both_short = order_legs[0].side == OrderSide.SELL and order_legs[1].side == OrderSide.SELL
+        first, second = (_parse_occ_symbol(leg.symbol) for leg in order_legs)
         
-        if both_short:
-            # Check for short straddle (same strike, same expiration, both short)
-            if (order_legs[0].symbol.split('C')[0] == order_legs[1].symbol.split('P')[0]):
-                is_short_straddle = True
-            else:
-                is_short_strangle = True
-                
-            # Check for short calendar spread (same strike, different expirations, both short)
-            leg1_type = 'C' if 'C' in order_legs[0].symbol else 'P'
-            leg2_type = 'C' if 'C' in order_legs[1].symbol else 'P'
-            
-            if leg1_type == 'C' and leg2_type == 'C':
-                leg1_exp = order_legs[0].symbol.split(leg1_type)[1][:6]
-                leg2_exp = order_legs[1].symbol.split(leg2_type)[1][:6]
-                if leg1_exp != leg2_exp:
-                    is_short_calendar = True
-                    is_short_strangle = False  # Override strangle detection
+        if both_short and first and second and first[0] == second[0]:
+            if first[2] != second[2] and first[1] == second[1]:
+                # Short straddle: same strike and expiration; short strangle: different strikes
+                if first[3] == second[3]:
+                    is_short_straddle = True
+                else:
+                    is_short_strangle = True
+            elif first[2] == second[2] == 'C' and first[1] != second[1]:
+                # Short call calendar: both calls, different expirations
+                is_short_calendar = True
     
     return is_short_straddle, is_short_strangle, is_short_calendar
 
 def _get_short_straddle_error_message() -> str:
     """Get error message for short straddle permission issues."""
-    return """
+    return ToolError("""
     Error: Account not eligible to trade short straddles.
     
     This error occurs because short straddles require Level 4 options trading permission.
@@ -1702,11 +6958,11 @@ def _get_short_straddle_error_message() -> str:
     - Consider using a long straddle instead
     - Use a debit spread strategy
     - Implement a covered call or cash-secured put
-    """
+    """)
 
 def _get_short_strangle_error_message() -> str:
     """Get error message for short strangle permission issues."""
-    return """
+    return ToolError("""
     Error: Account not eligible to trade short strangles.
     
     This error occurs because short strangles require Level 4 options trading permission.
@@ -1723,11 +6979,11 @@ def _get_short_strangle_error_message() -> str:
     - Consider using a long strangle instead
     - Use a debit spread strategy
     - Implement a covered call or cash-secured put
-    """
+    """)
 
 def _get_short_calendar_error_message() -> str:
     """Get error message for short calendar spread permission issues."""
-    return """
+    return ToolError("""
     Error: Account not eligible to trade short calendar spreads.
     
     This error occurs because short calendar spreads require Level 4 options trading permission.
@@ -1744,11 +7000,11 @@ def _get_short_calendar_error_message() -> str:
     - Consider using a long calendar spread instead
     - Use a debit spread strategy
     - Implement a covered call or cash-secured put
-    """
+    """)
 
 def _get_uncovered_options_error_message() -> str:
     """Get error message for uncovered options permission issues."""
-    return """
+    return ToolError("""
     Error: Account not eligible to trade uncovered option contracts.
     
     This error occurs when attempting to place an order that could result in an uncovered position.
@@ -1765,23 +7021,27 @@ def _get_uncovered_options_error_message() -> str:
     - Consider using covered calls instead of naked calls
     - Use debit spreads instead of calendar spreads
     - Ensure all positions are properly hedged
-    """
+    """)
+
+def _get_uncovered_option_error(order_legs: List[OptionLegRequest], order_class: OrderClass) -> str:
+    """Error message for an uncovered position, specific to the strategy when it is recognized."""
+    is_short_straddle, is_short_strangle, is_short_calendar = _analyze_option_strategy_type(order_legs, order_class)
+    
+    if is_short_straddle:
+        return _get_short_straddle_error_message()
+    elif is_short_strangle:
+        return _get_short_strangle_error_message()
+    elif is_short_calendar:
+        return _get_short_calendar_error_message()
+    else:
+        return _get_uncovered_options_error_message()
 
 def _handle_option_api_error(error_message: str, order_legs: List[OptionLegRequest], order_class: OrderClass) -> str:
     """Handle API errors with specific option strategy analysis."""
     if "40310000" in error_message and "not eligible to trade uncovered option contracts" in error_message:
-        is_short_straddle, is_short_strangle, is_short_calendar = _analyze_option_strategy_type(order_legs, order_class)
-        
-        if is_short_straddle:
-            return _get_short_straddle_error_message()
-        elif is_short_strangle:
-            return _get_short_strangle_error_message()
-        elif is_short_calendar:
-            return _get_short_calendar_error_message()
-        else:
-            return _get_uncovered_options_error_message()
+        return _get_uncovered_option_error(order_legs, order_class)
     elif "403" in error_message:
-        return f"""
+        return ToolError(f"""
         Error: Permission denied for option trading.
         
         Possible reasons:
@@ -1795,9 +7055,9 @@ def _handle_option_api_error(error_message: str, order_legs: List[OptionLegReque
         3. Required permissions for the strategy you're trying to implement
         
         Original error: {error_message}
-        """
+        """)
     else:
-        return f"""
+        return ToolError(f"""
         Error placing option order: {error_message}
         
         Please check:
@@ -1805,7 +7065,146 @@ def _handle_option_api_error(error_message: str, order_legs: List[OptionLegReque
         2. Your account has sufficient buying power
         3. The market is open for trading
         4. Your account has the required permissions
-        """
+        """)
+
+# ============================================================================
+# Options Order Pre-Validation
+# ============================================================================
+
+# OCC option symbol: root, expiration (YYMMDD), C or P, and strike times 1000 in 8 digits
+_OCC_SYMBOL = re.compile(r"^([A-Z0-9]{1,6})(\d{6})([CP])(\d{8})$")
+# Seconds an account snapshot is reused for pre-validation; a fill refreshes it sooner
+OPTION_ACCOUNT_MAX_AGE = 60.0
+# Options trading levels as the broker assigns them; 4 stands for uncovered short options
+OPTION_LEVEL_STRATEGIES = {
+    1: "covered calls and cash-secured puts",
+    2: "long calls and puts",
+    3: "spreads",
+    4: "uncovered options",
+}
+
+@functools.lru_cache(maxsize=4096)
+def _parse_occ_symbol(symbol: str) -> Optional[tuple]:
+    """
+    Split an OCC option symbol such as 'AAPL230616C00150000'.
+
+    Returns:
+        Optional[tuple]: (underlying, expiration date, 'C' or 'P', strike), or None if not an OCC symbol
+    """
+    match = _OCC_SYMBOL.match(symbol.upper())
+    if not match:
+        return None
+    root, expiry, kind, strike = match.groups()
+    try:
+        expiration = datetime.strptime(expiry, "%y%m%d").date()
+    except ValueError:
+        return None
+    return root, expiration, kind, int(strike) / 1000
+
+def _option_order_requirements(order_legs: List[OptionLegRequest], quantity: int, positions: Dict[str, Any]) -> tuple:
+    """
+    Classify a leg structure by the options trading level it needs.
+
+    Legs that close held positions need no level of their own, so an order that only
+    closes needs level 0. Opening long legs need level 2. A short leg is covered by a long
+    leg of the same underlying and type expiring no earlier (a spread, level 3), by 100
+    shares per contract for calls (a covered call, level 1) or, for a single-leg put, by
+    cash (a cash-secured put, level 1). Anything else is uncovered (level 4).
+
+    Args:
+        order_legs: Parsed legs, all with valid OCC symbols
+        quantity: Order quantity the leg ratios are multiplied by
+        positions: Held positions by symbol (may be empty)
+
+    Returns:
+        tuple: (required level, cash collateral needed for a cash-secured put)
+    """
+    legs = [(leg, _parse_occ_symbol(leg.symbol), leg.ratio_qty * quantity) for leg in order_legs]
+    level, collateral = 0, 0.0
+    longs = []
+    for leg, contract, contracts in legs:
+        if leg.side != OrderSide.BUY:
+            continue
+        held = positions.get(leg.symbol)
+        if held is None or float(held.qty) > -contracts:  # Not just buying to close a short
+            level = max(level, 2)
+            longs.append((contract, leg.ratio_qty))
+    for leg, (root, expiration, kind, strike), contracts in legs:
+        if leg.side != OrderSide.SELL:
+            continue
+        held = positions.get(leg.symbol)
+        if held is not None and float(held.qty) >= contracts:
+            continue  # Selling to close
+        covering = sum(ratio for (r, e, k, _), ratio in longs if r == root and k == kind and e >= expiration)
+        if covering >= leg.ratio_qty:
+            level = max(level, 3)
+            continue
+        shares = positions.get(root)
+        if kind == "C" and shares is not None and float(shares.qty) >= 100 * contracts:
+            level = max(level, 1)
+            continue
+        if kind == "P" and len(legs) == 1:
+            level = max(level, 1)
+            collateral += strike * 100 * contracts
+            continue
+        level = 4
+    return level, collateral
+
+async def _precheck_option_order(
+    order_legs: List[OptionLegRequest],
+    order_class: OrderClass,
+    quantity: int
+) -> Optional[str]:
+    """
+    Check an option order against the account's options level and buying power before it
+    is submitted, so orders the broker would reject fail locally without a round trip.
+
+    The account snapshot comes from the order mirror, refreshed after fills; positions are
+    only loaded when held contracts or shares could cover a leg. Orders are only rejected
+    here when the broker would certainly reject them; anything uncertain is submitted.
+
+    Returns:
+        Optional[str]: The rejection message, or None if the order may be submitted
+    """
+    for leg in order_legs:
+        if _parse_occ_symbol(leg.symbol) is None:
+            return ToolError(f"Error: Invalid option symbol '{leg.symbol}'. Expected OCC format like 'AAPL230616C00150000'.")
+
+    account = await order_mirror.get_account(OPTION_ACCOUNT_MAX_AGE)
+    approved = getattr(account, "options_trading_level", None)
+    if approved is None:
+        approved = getattr(account, "options_approved_level", None)
+    if approved is None:
+        return None  # Older API versions do not report a level; let the broker decide
+    approved = int(approved)
+
+    level, collateral = _option_order_requirements(order_legs, quantity, {})
+    if level > approved or collateral:
+        positions = {position.symbol: position for position in await order_mirror.get_positions()}
+        level, collateral = _option_order_requirements(order_legs, quantity, positions)
+
+    if level > approved:
+        if level >= 4:
+            return _get_uncovered_option_error(order_legs, order_class)
+        return ToolError(f"""
+        Error: This order needs options trading level {level} ({OPTION_LEVEL_STRATEGIES[level]}).
+        The account is approved for level {approved}{f" ({OPTION_LEVEL_STRATEGIES[approved]})" if approved in OPTION_LEVEL_STRATEGIES else ""}.
+        The order was not submitted.
+        """)
+    if collateral:
+        buying_power = float(getattr(account, "options_buying_power", None) or "inf")
+        if buying_power < collateral:
+            # The snapshot may predate a cancel that released buying power; confirm before rejecting
+            account = await order_mirror.get_account(0)
+            buying_power = float(getattr(account, "options_buying_power", None) or "inf")
+        if buying_power < collateral:
+            return ToolError(f"""
+        Error: Insufficient options buying power for a cash-secured put.
+        Required collateral: ${collateral:,.2f}
+        Options buying power: ${buying_power:,.2f}
+        The order was not submitted.
+        """)
+    return None
 
 # ============================================================================
 # Options Trading Tool
@@ -1817,7 +7216,8 @@ async def place_option_market_order(
     order_class: Optional[Union[str, OrderClass]] = None,
     quantity: int = 1,
     time_in_force: TimeInForce = TimeInForce.DAY,
-    extended_hours: bool = False
+    extended_hours: bool = False,
+    account: Optional[str] = None
 ) -> str:
     """
     Places a market order for options (single or multi-leg) and returns the order details.
@@ -1842,6 +7242,7 @@ async def place_option_market_order(
         time_in_force (TimeInForce): Time in force for the order. For options trading, 
             only DAY is supported (default: TimeInForce.DAY)
         extended_hours (bool): Whether to allow execution during extended hours (default: False)
+        account (Optional[str]): Account to act on, by its MCP_ACCOUNTS name (default: the ALPACA_API_KEY account)
     
     Returns:
         str: Formatted string containing order details or error message
@@ -1863,6 +7264,8 @@ async def place_option_market_order(
         - Level 3: Spreads and combinations: Butterfly Spreads, Straddles, Strangles, Calendar Spreads (except for short call calendar spread, short strangles, short straddles)
         - Level 4: Uncovered options (naked calls/puts), Short Strangles, Short Straddles, Short Call Calendar Spread, etc.
         If you receive a permission error, please check your account's option trading level.
+        Orders are checked against the account's options level and buying power before
+        submission, so orders the broker would reject fail without an API round trip.
     """
     # Initialize variables that might be used in exception handlers
     order_legs: List[OptionLegRequest] = []
@@ -1890,13 +7293,22 @@ async def place_option_market_order(
             return processed_legs
         order_legs = processed_legs
         
+        # Reject locally what the broker would reject; a failed check never blocks the order
+        try:
+            rejection = await _precheck_option_order(order_legs, order_class, quantity)
+        except Exception:
+            rejection = None
+        if rejection:
+            return rejection
+        
         # Create order request
         order_data = _create_option_market_order_request(
             order_legs, order_class, quantity, time_in_force, extended_hours
         )
         
         # Submit order
-        order = trade_client.submit_order(order_data)
+        order = await _call_api(trade_client.submit_order, order_data)
+        order_mirror.record(order)
         
         # Format and return response
         return _format_option_order_response(order, order_class, order_legs)
@@ -1905,7 +7317,7 @@ async def place_option_market_order(
         return _handle_option_api_error(str(api_error), order_legs, order_class)
         
     except Exception as e:
-        return f"""
+        return ToolError(f"""
         Unexpected error placing option order: {str(e)}
         
         Please try:
@@ -1913,12 +7325,434 @@ async def place_option_market_order(
         2. Checking your account status
         3. Ensuring market is open
         4. Contacting support if the issue persists
-        """
+        """)
+
+# Limits on walking a limit order toward the natural price
+OPTION_WALK_MAX_STEPS = 20
+OPTION_WALK_MAX_SECONDS = 300.0
+
+async def _option_leg_prices(order_legs: List[OptionLegRequest], feed: Optional[OptionsFeed]) -> tuple:
+    """
+    Net mid and natural price of one unit of a leg structure, from the latest quotes of all
+    legs fetched in a single request. Prices are per share, positive for a debit.
+
+    Raises:
+        ValueError: If a leg has no usable quote
+    """
+    request = OptionLatestQuoteRequest(symbol_or_symbols=[leg.symbol for leg in order_legs], feed=feed)
+    quotes = await _call_api(option_historical_data_client.get_option_latest_quote, request)
+    mid = natural = 0.0
+    for leg in order_legs:
+        quote = quotes.get(leg.symbol)
+        bid = float(quote.bid_price or 0) if quote else 0.0
+        ask = float(quote.ask_price or 0) if quote else 0.0
+        if ask <= 0 or bid > ask:
+            raise ValueError(f"No usable quote for {leg.symbol}")
+        if leg.side == OrderSide.BUY:
+            mid += leg.ratio_qty * (bid + ask) / 2
+            natural += leg.ratio_qty * ask
+        else:
+            mid -= leg.ratio_qty * (bid + ask) / 2
+            natural -= leg.ratio_qty * bid
+    return mid, natural
+
+def _round_option_price(price: float, multi_leg: bool) -> float:
+    """
+    Round a computed price to a tick every contract accepts: $0.01 for multi-leg net prices,
+    else the standard $0.05 below $3 and $0.10 from $3. Penny-program classes quote finer
+    ticks, which these are multiples of.
+    """
+    tick = 0.01 if multi_leg else (0.05 if abs(price) < 3 else 0.10)
+    return round(round(price / tick) * tick, 2)
+
+def _option_limit_request(order_legs: List[OptionLegRequest], quantity: int, net_price: float,
+                          time_in_force: TimeInForce, extended_hours: bool) -> LimitOrderRequest:
+    """Limit order for a leg structure at a net price (positive for a debit)."""
+    if len(order_legs) > 1:
+        return LimitOrderRequest(
+            qty=quantity,
+            order_class=OrderClass.MLEG,
+            time_in_force=time_in_force,
+            extended_hours=extended_hours,
+            limit_price=net_price,
+            client_order_id=_default_client_order_id(),
+            type=OrderType.LIMIT,
+            legs=order_legs
+        )
+    # A single leg is priced as the contract price: the debit to buy, the credit to sell
+    return LimitOrderRequest(
+        symbol=order_legs[0].symbol,
+        qty=quantity,
+        side=order_legs[0].side,
+        time_in_force=time_in_force,
+        extended_hours=extended_hours,
+        limit_price=abs(net_price),
+        client_order_id=_default_client_order_id(),
+        type=OrderType.LIMIT
+    )
+
+@mcp.tool()
+async def place_option_limit_order(
+    legs: List[Dict[str, Any]],
+    quantity: int = 1,
+    limit_price: Optional[float] = None,
+    walk_steps: int = 0,
+    walk_interval: float = 10.0,
+    time_in_force: TimeInForce = TimeInForce.DAY,
+    extended_hours: bool = False,
+    feed: Optional[OptionsFeed] = None,
+    account: Optional[str] = None
+) -> str:
+    """
+    Places a limit order for options (single or multi-leg), priced from the legs' live quotes,
+    and can walk the price toward the natural price until it fills. Prefer this over
+    place_option_market_order for contracts with wide spreads.
+
+    Pricing (per share, for one unit of the legs' ratios):
+    - mid: sum of leg midpoints, bought legs added and sold legs subtracted
+    - natural: bought legs at the ask, sold legs at the bid, the price that fills at once
+    Multi-leg orders use a net limit price, positive for a debit and negative for a credit;
+    single-leg orders use the contract price.
+
+    With walk_steps, the order starts at limit_price (default: mid) and every walk_interval
+    seconds it is replaced at a price one step closer to the current natural price, reaching
+    it after walk_steps steps. Fills are detected through the order mirror, not by polling.
+    Computed prices are rounded to a tick every contract accepts ($0.01 for multi-leg net
+    prices, else $0.05 below $3 and $0.10 from $3); a given limit_price is sent as is.
+
+    Args:
+        legs (List[Dict[str, Any]]): Option legs as for place_option_market_order, each with
+            symbol, side ('buy' or 'sell') and ratio_qty
+        quantity (int): Number of units of the leg structure (default: 1)
+        limit_price (Optional[float]): Starting net price (default: the current mid)
+        walk_steps (int): Replacements toward natural while unfilled, up to 20 (default: 0, no walking)
+        walk_interval (float): Seconds between steps; walk_steps x walk_interval may not exceed 300 (default: 10)
+        time_in_force (TimeInForce): Only DAY is supported for options (default: TimeInForce.DAY)
+        extended_hours (bool): Whether to allow execution during extended hours (default: False)
+        feed (Optional[OptionsFeed]): Quote feed (opra or indicative)
+        account (Optional[str]): Account to act on, by its MCP_ACCOUNTS name (default: the ALPACA_API_KEY account)
+
+    Returns:
+        str: Order details with the mid and natural prices, each price the order was placed at,
+            and its final status
+    """
+    order_legs: List[OptionLegRequest] = []
+    order_class = OrderClass.SIMPLE
+    try:
+        validation_error = _validate_option_order_inputs(legs, quantity, time_in_force)
+        if validation_error:
+            return validation_error
+        if not 0 <= walk_steps <= OPTION_WALK_MAX_STEPS:
+            return ToolError(f"Error: walk_steps must be between 0 and {OPTION_WALK_MAX_STEPS}.")
+        if walk_steps and (walk_interval <= 0 or walk_steps * walk_interval > OPTION_WALK_MAX_SECONDS):
+            return ToolError(f"Error: walk_interval must be positive and walk_steps x walk_interval at most {OPTION_WALK_MAX_SECONDS:g} seconds.")
+        processed_legs = _process_option_legs(legs)
+        if isinstance(processed_legs, str):
+            return processed_legs
+        order_legs = processed_legs
+        order_class = OrderClass.MLEG if len(order_legs) > 1 else OrderClass.SIMPLE
+
+        # The pre-check and the leg quotes are independent requests; a failed pre-check
+        # never blocks the order
+        rejection, prices = await asyncio.gather(
+            _precheck_option_order(order_legs, order_class, quantity),
+            _option_leg_prices(order_legs, feed),
+            return_exceptions=True
+        )
+        if isinstance(rejection, str):
+            return rejection
+        if isinstance(prices, Exception):
+            return ToolError(f"Error pricing option order: {str(prices)}")
+        mid, natural = prices
+        if len(order_legs) == 1 and limit_price is not None and order_legs[0].side == OrderSide.SELL:
+            limit_price = -abs(limit_price)  # Single-leg prices are given as the credit
+        multi_leg = order_class == OrderClass.MLEG
+        price = _round_option_price(mid, multi_leg) if limit_price is None else limit_price
+
+        order = await _call_api(trade_client.submit_order,
+                                _option_limit_request(order_legs, quantity, price, time_in_force, extended_hours))
+        order_mirror.record(order)
+        placed = [f"{price:.2f} (submitted)"]
+
+        for step in range(1, walk_steps + 1):
+            order = await order_mirror.wait_for_status(str(order.id), {"filled"}, walk_interval)
+            if _order_status(order) in CLOSED_ORDER_STATUSES:
+                break
+            mid, natural = await _option_leg_prices(order_legs, feed)
+            # Only ever move toward natural, whichever way the market moved
+            target = _round_option_price(mid + (natural - mid) * step / walk_steps, multi_leg)
+            if target <= price:
+                continue
+            price = target
+            try:
+                order = await _call_api(trade_client.replace_order_by_id, str(order.id),
+                                        ReplaceOrderRequest(limit_price=price if multi_leg else abs(price)))
+            except APIError:
+                # Typically filled or canceled in the meantime
+                order = await _call_api(trade_client.get_order_by_id, str(order.id))
+                order_mirror.record(order)
+                break
+            order_mirror.record(order)
+            placed.append(f"{price:.2f} (step {step})")
+        if walk_steps and _order_status(order) not in CLOSED_ORDER_STATUSES:
+            order = await order_mirror.wait_for_status(str(order.id), {"filled"}, walk_interval)
+
+        kind = "debit" if natural >= 0 else "credit"
+        result = f"""
+            Option Limit Order Placed:
+            --------------------------
+            Order ID: {order.id}
+            Client Order ID: {order.client_order_id}
+            Order Class: {order_class.value}
+            Legs: {', '.join(f"{leg.side.value} {leg.ratio_qty} {leg.symbol}" for leg in order_legs)}
+            Quantity: {quantity}
+            Mid: {mid:.2f}  Natural: {natural:.2f} ({kind}, per share)
+            Prices Placed: {', '.join(placed)}
+            Status: {_order_status(order)}
+            """
+        if order.filled_avg_price:
+            result += f"Filled Price: {float(order.filled_avg_price):.2f}\n"
+        return result
+
+    except APIError as api_error:
+        return _handle_option_api_error(str(api_error), order_legs, order_class)
+    except Exception as e:
+        return ToolError(f"Error placing option limit order: {str(e)}")
+
+# ============================================================================
+# Server Diagnostics Tools
+# ============================================================================
+
+@mcp.tool()
+async def get_cache_stats() -> str:
+    """
+    Retrieves response cache counters for tuning cache lifetimes.
+    
+    Returns:
+        str: Per-tool TTL, hits, misses, coalesced (deduplicated in-flight) requests and hit rate
+    """
+    stats = response_cache.stats()
+    if not stats:
+        return "No cached tool calls recorded yet."
+    
+    result = ["Response Cache Statistics:", "-" * 30]
+    for name, counts in stats.items():
+        total = counts["hits"] + counts["misses"] + counts["coalesced"]
+        hit_rate = (counts["hits"] + counts["coalesced"]) / total if total else 0.0
+        ttl = CACHE_TTLS.get(name, 0)
+        ttl_text = "until next transition" if callable(ttl) else f"{ttl:g}s"
+        result.append(
+            f"{name}: TTL {ttl_text}, Hits: {counts['hits']}, Misses: {counts['misses']}, "
+            f"Coalesced: {counts['coalesced']}, Hit Rate: {hit_rate:.1%}"
+        )
+    return "\n".join(result)
+
+@mcp.tool()
+async def get_rate_limit_status() -> str:
+    """
+    Retrieves the state of the upstream rate limit scheduler.
+    
+    Returns:
+        str: Per API key and API: limit, available tokens, the reserve held for order entry,
+            the last remaining count reported by Alpaca and request counters per lane
+    """
+    if not _rate_limit_buckets:
+        return "No rate limit buckets in use yet."
+    
+    result = ["Rate Limit Status:", "-" * 30]
+    for bucket in _rate_limit_buckets.values():
+        status = bucket.status()
+        remaining = "n/a" if status["remaining"] is None else status["remaining"]
+        line = (
+            f"{bucket.name}: Limit {status['limit']}/min, Tokens: {status['tokens']:.1f}, "
+            f"Reserved for Orders: {status['reserve']}, Last Reported Remaining: {remaining}, "
+            f"Priority Requests: {status.get('priority', 0)}, Data Requests: {status.get('data', 0)}, "
+            f"Queued: {status.get('waited', 0)}, Throttled (429): {status.get('throttled', 0)}"
+        )
+        if status["blocked_for"] > 0:
+            line += f", Paused for {status['blocked_for']:.1f}s"
+        result.append(line)
+    return "\n".join(result)
+
+@mcp.tool()
+async def get_upstream_status() -> str:
+    """
+    Retrieves per-endpoint deadlines, latency and retry counters of upstream calls.
+    
+    Returns:
+        str: Per SDK method: calls, deadline, p95 latency of recent successful attempts,
+            retries, hedged requests fired (and how many answered first) and deadline timeouts
+    """
+    if not _endpoint_stats:
+        return "No upstream calls made yet."
+    
+    result = [f"Upstream Status (retries: {MCP_API_RETRIES}, hedging: {'on' if MCP_API_HEDGE else 'off'}):", "-" * 30]
+    for name, stats in sorted(_endpoint_stats.items(), key=lambda item: -item[1].calls):
+        p95 = stats.p95
+        p95_text = f"{p95 * 1000:.1f}ms" if p95 is not None else f"n/a ({len(stats.samples)} samples)"
+        result.append(
+            f"{name}: Calls: {stats.calls}, Deadline: {API_DEADLINES.get(name, MCP_API_DEADLINE):g}s, "
+            f"p95: {p95_text}, Retries: {stats.retries}, Hedges: {stats.hedges} (won {stats.hedge_wins}), "
+            f"Timeouts: {stats.timeouts}"
+        )
+    return "\n".join(result)
+
+@mcp.tool()
+async def get_order_mirror_status(account: Optional[str] = None) -> str:
+    """
+    Retrieves the state of the in-memory order and position mirror.
+    
+    Args:
+        account (Optional[str]): Account to act on, by its MCP_ACCOUNTS name (default: the ALPACA_API_KEY account)
+    
+    Returns:
+        str: Whether the trade updates stream is live, when it last reconciled with REST,
+            and how many reads it answered from memory
+    """
+    mirror = order_mirror
+    if not mirror.enabled:
+        return "Order mirror is disabled (MCP_ORDER_MIRROR=False); order and position tools use REST."
+    synced = f"{time.monotonic() - mirror._orders_synced:.0f}s ago" if mirror._orders_synced else "never"
+    result = f"""
+            Order Mirror Status ({_current_account().name} account):
+            --------------------
+            Live: {mirror.live}
+            Last Reconcile: {synced} (every {mirror.reconcile_seconds:g}s)
+            Orders Tracked: {len(mirror._orders)}
+            Trade Updates Received: {mirror.stats['updates']}
+            Open Order Reads From Memory: {mirror.stats['order_hits']}
+            Position Reads From Memory: {mirror.stats['position_hits']}
+            Reconciles: {mirror.stats['reconciles']} (errors: {mirror.stats['reconcile_errors']})
+            """
+    if mirror.last_error:
+        result += f"Last Reconcile Error: {mirror.last_error}\n"
+    return result
+
+@mcp.tool()
+async def get_server_metrics(tool_name: Optional[str] = None) -> str:
+    """
+    Retrieves per-tool call counts, latency percentiles and error counts.
+    
+    Latency is split into upstream time (Alpaca requests, including rate limit
+    queueing) and formatting time (everything else the tool does). The same
+    metrics are served in Prometheus format at /metrics on network transports.
+    
+    Args:
+        tool_name: Only report this tool (default: all tools called so far)
+    
+    Returns:
+        str: Per tool: calls, errors by class, cache hits, average response size, and
+            p50/p95/p99 total, upstream and formatting latency in milliseconds; without
+            tool_name, also the approximate memory held by each in-memory structure
+            against MCP_MEMORY_BUDGET_MB and what the budget has evicted
+    """
+    metrics = tool_metrics
+    tools = [tool_name] if tool_name else sorted(metrics.calls, key=lambda t: -metrics.calls[t])
+    tools = [t for t in tools if metrics.calls.get(t)]
+    if not tools:
+        return f"No calls recorded for {tool_name}." if tool_name else "No tool calls recorded yet."
+    
+    uptime = time.time() - metrics.started
+    result = [f"Server Metrics (uptime {uptime / 60:.1f} min, {len(_session_slots)} active sessions):", "-" * 30]
+    for tool in tools:
+        calls = metrics.calls[tool]
+        errors = metrics.errors.get(tool, {})
+        error_text = ", ".join(f"{k}: {v}" for k, v in sorted(errors.items())) or "none"
+        quantiles = metrics.quantiles(tool)
+        latency = "; ".join(
+            f"{phase} " + "/".join(f"{v * 1000:.1f}" for v in quantiles[phase])
+            for phase in METRIC_PHASES
+        )
+        result.append(
+            f"{tool}: Calls: {calls}, Errors: {sum(errors.values())} ({error_text}), "
+            f"Cache Hits: {metrics.cache_hits[tool]}, Avg Response: {metrics.response_bytes[tool] / calls:.0f} bytes, "
+            f"p50/p95/p99 ms: {latency}"
+        )
+    if not tool_name:
+        usage = memory_budget.usage()
+        budget = f"{memory_budget.limit / 2**20:.0f} MB" if memory_budget.limit > 0 else "unlimited"
+        result += ["", f"Memory: {sum(usage.values()) / 2**20:.1f} MB of {budget} budget", "-" * 30]
+        for name, size in sorted(usage.items(), key=lambda item: -item[1]):
+            result.append(
+                f"{name}: {size / 2**20:.2f} MB, Evictions: {memory_budget.evictions[name]} "
+                f"({memory_budget.evicted_bytes[name] / 2**20:.2f} MB)"
+            )
+    return "\n".join(result)
+
+@mcp.custom_route("/metrics", methods=["GET"])
+async def metrics_endpoint(request) -> PlainTextResponse:
+    """Prometheus scrape endpoint, served alongside the MCP endpoints on network transports."""
+    return PlainTextResponse(tool_metrics.prometheus() + memory_budget.prometheus(), media_type="text/plain; version=0.0.4")
+
+# ============================================================================
+# Argument Parsing
+# ============================================================================
+
+# Tool arguments repeat heavily from call to call (the same timeframes, dates, sides and
+# statuses), so they are parsed through module-level tables and memoized parsers instead
+# of rebuilding mappings and patterns on every call.
+
+ORDER_SIDES = {"buy": OrderSide.BUY, "sell": OrderSide.SELL}
+# Time in force values accepted for equity orders, by upper-case name
+EQUITY_TIME_IN_FORCE = {
+    "DAY": TimeInForce.DAY, "GTC": TimeInForce.GTC, "OPG": TimeInForce.OPG,
+    "CLS": TimeInForce.CLS, "IOC": TimeInForce.IOC, "FOK": TimeInForce.FOK,
+}
+# get_orders status filters; anything else lists all orders
+ORDER_QUERY_STATUSES = {"open": QueryOrderStatus.OPEN, "closed": QueryOrderStatus.CLOSED}
+# Order type -> (request class, OrderType, price fields passed through, whether all of them
+# (rather than any) are required, message when they are missing)
+STOCK_ORDER_TEMPLATES = {
+    "MARKET": (MarketOrderRequest, OrderType.MARKET, (), True, None),
+    "LIMIT": (LimitOrderRequest, OrderType.LIMIT, ("limit_price",), True,
+              "limit_price is required for LIMIT orders."),
+    "STOP": (StopOrderRequest, OrderType.STOP, ("stop_price",), True,
+             "stop_price is required for STOP orders."),
+    "STOP_LIMIT": (StopLimitOrderRequest, OrderType.STOP_LIMIT, ("stop_price", "limit_price"), True,
+                   "Both stop_price and limit_price are required for STOP_LIMIT orders."),
+    "TRAILING_STOP": (TrailingStopOrderRequest, OrderType.TRAILING_STOP, ("trail_price", "trail_percent"), False,
+                      "Either trail_price or trail_percent is required for TRAILING_STOP orders."),
+}
+
+PREDEFINED_TIMEFRAMES = {
+    "1Min": TimeFrame.Minute,
+    "1Hour": TimeFrame.Hour,
+    "1Day": TimeFrame.Day,
+    "1Week": TimeFrame.Week,
+    "1Month": TimeFrame.Month,
+}
+# <number><unit> where unit can be Min, Hour, Day, Week, Month
+_TIMEFRAME_PATTERN = re.compile(r"^(\d+)(Min|Hour|Day|Week|Month)$", re.IGNORECASE)
+# Lower-case unit -> (TimeFrameUnit, largest accepted amount)
+TIMEFRAME_UNITS = {
+    "min": (TimeFrameUnit.Minute, 59),
+    "hour": (TimeFrameUnit.Hour, 23),
+    "day": (TimeFrameUnit.Day, 365),
+    "week": (TimeFrameUnit.Week, 365),
+    "month": (TimeFrameUnit.Month, 365),
+}
+
+@functools.lru_cache(maxsize=1024)
+def _parse_iso_datetime(value: str) -> datetime:
+    """
+    Parse an ISO 8601 date or datetime argument; a trailing "Z" means UTC.
+
+    Raises:
+        ValueError: If the value is not in ISO format
+    """
+    return datetime.fromisoformat(value)
 
+@functools.lru_cache(maxsize=64)
+def _orders_request(query_status: QueryOrderStatus, limit: int) -> GetOrdersRequest:
+    """Shared, already validated GetOrdersRequest for a status filter and limit."""
+    return GetOrdersRequest(status=query_status, limit=limit)
+
+@functools.lru_cache(maxsize=256)
 def parse_timeframe_with_enums(timeframe_str: str) -> Optional[TimeFrame]:
     """
     Parse timeframe string to Alpaca TimeFrame object using proper enumerations.
-    Supports flexible parsing of any valid timeframe format.
+    Supports flexible parsing of any valid timeframe format. Results are memoized,
+    so callers share the returned TimeFrame and must not modify it.
     
     Args:
         timeframe_str (str): Timeframe string (e.g., "1Min", "4Min", "2Hour", "1Day")
@@ -1934,50 +7768,17 @@ def parse_timeframe_with_enums(timeframe_str: str) -> Optional[TimeFrame]:
         timeframe_str = timeframe_str.strip()
         
         # Use predefined TimeFrame objects for common cases (more efficient)
-        predefined_timeframes = {
-            "1Min": TimeFrame.Minute,
-            "1Hour": TimeFrame.Hour, 
-            "1Day": TimeFrame.Day,
-            "1Week": TimeFrame.Week,
-            "1Month": TimeFrame.Month
-        }
-        
-        if timeframe_str in predefined_timeframes:
-            return predefined_timeframes[timeframe_str]
-        
-        # Flexible regex pattern to parse any valid timeframe format
-        # Matches: <number><unit> where unit can be Min, Hour, Day, Week, Month
-        pattern = r'^(\d+)(Min|Hour|Day|Week|Month)$'
-        match = re.match(pattern, timeframe_str, re.IGNORECASE)
+        if timeframe_str in PREDEFINED_TIMEFRAMES:
+            return PREDEFINED_TIMEFRAMES[timeframe_str]
         
+        match = _TIMEFRAME_PATTERN.match(timeframe_str)
         if not match:
             return None
             
         amount = int(match.group(1))
-        unit_str = match.group(2).lower()
-        
-        # Map unit strings to TimeFrameUnit enums
-        unit_mapping = {
-            'min': TimeFrameUnit.Minute,
-            'hour': TimeFrameUnit.Hour,
-            'day': TimeFrameUnit.Day,
-            'week': TimeFrameUnit.Week,
-            'month': TimeFrameUnit.Month
-        }
-        
-        unit = unit_mapping.get(unit_str)
-        if unit is None:
-            return None
-            
-        # Validate amount based on unit type
-        if unit == TimeFrameUnit.Minute and amount > 59:
-            # Minutes should be reasonable (1-59)
-            return None
-        elif unit == TimeFrameUnit.Hour and amount > 23:
-            # Hours should be reasonable (1-23) 
-            return None
-        elif unit in [TimeFrameUnit.Day, TimeFrameUnit.Week, TimeFrameUnit.Month] and amount > 365:
-            # Days/weeks/months should be reasonable
+        unit, max_amount = TIMEFRAME_UNITS[match.group(2).lower()]
+        # Keep amounts reasonable: 1-59 minutes, 1-23 hours, up to 365 days/weeks/months
+        if amount > max_amount:
             return None
             
         return TimeFrame(amount, unit)
@@ -1985,6 +7786,45 @@ def parse_timeframe_with_enums(timeframe_str: str) -> Optional[TimeFrame]:
     except (ValueError, AttributeError, TypeError):
         return None
 
+# ============================================================================
+# Startup Timing
+# ============================================================================
+
+def _startup_report() -> str:
+    """Format the time spent in each startup phase."""
+    lines = ["Startup timing:"]
+    previous = _startup_marks[0][1]
+    for phase, stamp in _startup_marks[1:]:
+        lines.append(f"  {phase}: {(stamp - previous) * 1000:.1f} ms")
+        previous = stamp
+    lines.append(f"  total: {(previous - _startup_marks[0][1]) * 1000:.1f} ms")
+    return "\n".join(lines)
+
+_startup_marks.append(("tool registration", time.perf_counter()))
+if MCP_STARTUP_TIMING or "--startup-time" in sys.argv:
+    # stdout carries the stdio transport, so diagnostics go to stderr
+    print(_startup_report(), file=sys.stderr)
+
+def main() -> None:
+    """Run the server on the configured transport (stdio, sse or streamable-http)."""
+    parser = argparse.ArgumentParser(description="Alpaca MCP server")
+    parser.add_argument("--transport", choices=["stdio", "sse", "streamable-http"], default=MCP_TRANSPORT,
+                        help="stdio serves one client; sse and streamable-http serve many sessions from one process")
+    parser.add_argument("--host", default=MCP_HOST, help="Listen address for the network transports")
+    parser.add_argument("--port", type=int, default=MCP_PORT, help="Listen port for the network transports")
+    parser.add_argument("--startup-time", action="store_true", help="Report startup timing and exit")
+    args = parser.parse_args()
+    if args.startup_time:
+        # Measurement mode: report startup cost and exit without serving
+        sys.exit(0)
+    if args.transport != "stdio":
+        mcp.settings.host = args.host
+        mcp.settings.port = args.port
+    if MCP_HTTP_WARMUP_CONNECTIONS > 0:
+        _executor.submit(_warm_http_pool, [trade_client, stock_historical_data_client, option_historical_data_client],
+                         MCP_HTTP_WARMUP_CONNECTIONS)
+    mcp.run(transport=args.transport)
+
 # Run the server
 if __name__ == "__main__":
-    mcp.run(transport='stdio')
+    main()
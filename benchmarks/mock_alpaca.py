@@ -0,0 +1,173 @@
+"""
+Local mock of the Alpaca trading and market data REST APIs for benchmarking.
+
+Replays recorded responses from benchmarks/fixtures/*.json. Each fixture file holds a
+list of routes:
+
+    {"method": "GET", "path": "/v2/stocks/bars", "status": 200, "body": {...}}
+
+Routes match on method and path (query strings are ignored); a path may use shell
+wildcards such as "/v2/orders/*". In response bodies "${date}" / "${date+N}" expand
+to today's date (plus N days) and "${now}" / "${now+N}" to the current UTC time
+(plus N hours) when the fixtures are loaded, so recorded expirations and market
+clock transitions stay in the future.
+
+Both APIs are served from one address: the server's paths do not overlap, so point
+TRADE_API_URL and DATA_API_URL at the same mock.
+
+Usage:
+    python benchmarks/mock_alpaca.py [--port 8765] [--latency-ms 20]
+    python benchmarks/mock_alpaca.py --record benchmarks/fixtures/recorded.json
+
+With --record the mock forwards every request to the real paper trading and data
+APIs (market data paths go to the data host) and saves the first response per
+method and path, producing a fixture file from live traffic. Run the benchmark with
+real credentials and --mock-url pointing here to record a full set.
+"""
+
+import argparse
+import fnmatch
+import json
+import os
+import re
+import threading
+import time
+import urllib.error
+import urllib.request
+from datetime import date, datetime, timedelta, timezone
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+from typing import Any, Dict, List, Optional, Tuple
+from urllib.parse import urlsplit
+
+FIXTURE_DIR = os.path.join(os.path.dirname(os.path.abspath(__file__)), "fixtures")
+PAPER_TRADING_URL = "https://paper-api.alpaca.markets"
+DATA_URL = "https://data.alpaca.markets"
+# Market data paths; everything else belongs to the trading API
+DATA_PATH_PREFIXES = ("/v2/stocks", "/v1beta1")
+
+_TEMPLATE = re.compile(r"\$\{(date|now)([+-]\d+)?\}")
+
+def _expand(match: re.Match) -> str:
+    offset = int(match.group(2) or 0)
+    if match.group(1) == "date":
+        return (date.today() + timedelta(days=offset)).isoformat()
+    now = datetime.now(timezone.utc).replace(microsecond=0) + timedelta(hours=offset)
+    return now.isoformat().replace("+00:00", "Z")
+
+def load_fixtures(paths: List[str]) -> List[Dict[str, Any]]:
+    """Load route lists from fixture files, expanding date templates in their bodies."""
+    routes = []
+    for path in paths:
+        with open(path) as f:
+            routes.extend(json.loads(_TEMPLATE.sub(_expand, f.read())))
+    return routes
+
+class MockAlpacaServer(ThreadingHTTPServer):
+    """Threaded HTTP/1.1 server replaying (or recording) Alpaca API responses."""
+
+    daemon_threads = True
+
+    def __init__(self, address: Tuple[str, int], routes: List[Dict[str, Any]],
+                 latency: float = 0.0, record_path: Optional[str] = None):
+        super().__init__(address, _Handler)
+        self.routes = routes
+        self.latency = latency
+        self.record_path = record_path
+        self.requests_served = 0
+        self._lock = threading.Lock()
+
+    @property
+    def url(self) -> str:
+        host, port = self.server_address[:2]
+        return f"http://{host}:{port}"
+
+    def match(self, method: str, path: str) -> Optional[Dict[str, Any]]:
+        for route in self.routes:
+            if route["method"] == method and fnmatch.fnmatchcase(path, route["path"]):
+                return route
+        return None
+
+    def forward(self, method: str, target: str, headers: Dict[str, str], body: bytes) -> Tuple[int, bytes]:
+        """Send a request to the real API and keep its response as a new route."""
+        path = urlsplit(target).path
+        base = DATA_URL if path.startswith(DATA_PATH_PREFIXES) else PAPER_TRADING_URL
+        request = urllib.request.Request(base + target, data=body or None, method=method, headers={
+            k: v for k, v in headers.items() if k.lower().startswith("apca-") or k.lower() == "content-type"
+        })
+        try:
+            with urllib.request.urlopen(request, timeout=30) as response:
+                status, payload = response.status, response.read()
+        except urllib.error.HTTPError as e:
+            status, payload = e.code, e.read()
+        with self._lock:
+            if status < 400 and self.match(method, path) is None:
+                self.routes.append({
+                    "method": method, "path": path, "status": status,
+                    "body": json.loads(payload) if payload else None,
+                })
+                with open(self.record_path, "w") as f:
+                    json.dump(self.routes, f, indent=1)
+        return status, payload
+
+class _Handler(BaseHTTPRequestHandler):
+    protocol_version = "HTTP/1.1"  # Keep-alive, so the server's connection pool is exercised
+
+    def _respond(self, status: int, payload: bytes) -> None:
+        self.send_response(status)
+        self.send_header("Content-Type", "application/json")
+        self.send_header("Content-Length", str(len(payload)))
+        self.end_headers()
+        if self.command != "HEAD":
+            self.wfile.write(payload)
+
+    def _handle(self) -> None:
+        server: MockAlpacaServer = self.server
+        body = self.rfile.read(int(self.headers.get("Content-Length") or 0))
+        server.requests_served += 1
+        if self.command == "HEAD":  # Connection warm-up
+            return self._respond(200, b"")
+        if server.latency:
+            time.sleep(server.latency)
+        if server.record_path:
+            return self._respond(*server.forward(self.command, self.path, dict(self.headers), body))
+        route = server.match(self.command, urlsplit(self.path).path)
+        if route is None:
+            return self._respond(404, json.dumps({"code": 40410000, "message": f"no fixture for {self.path}"}).encode())
+        payload = b"" if route.get("body") is None else json.dumps(route["body"]).encode()
+        self._respond(route.get("status", 200), payload)
+
+    do_GET = do_POST = do_PATCH = do_PUT = do_DELETE = do_HEAD = _handle
+
+    def log_message(self, format, *args):
+        pass
+
+def start_mock_server(port: int = 0, latency_ms: float = 0.0, fixtures: Optional[List[str]] = None,
+                      record_path: Optional[str] = None) -> MockAlpacaServer:
+    """Start the mock on a background thread and return it; port 0 picks a free port."""
+    if fixtures is None:
+        fixtures = sorted(
+            os.path.join(FIXTURE_DIR, name) for name in os.listdir(FIXTURE_DIR) if name.endswith(".json")
+        )
+    routes = [] if record_path else load_fixtures(fixtures)
+    server = MockAlpacaServer(("127.0.0.1", port), routes, latency_ms / 1000, record_path)
+    threading.Thread(target=server.serve_forever, name="mock-alpaca", daemon=True).start()
+    return server
+
+def main() -> None:
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--port", type=int, default=8765)
+    parser.add_argument("--latency-ms", type=float, default=0.0, help="Delay added to every response")
+    parser.add_argument("--fixtures", nargs="*", help="Fixture files (default: benchmarks/fixtures/*.json)")
+    parser.add_argument("--record", metavar="PATH", help="Proxy to the real APIs and save responses to PATH")
+    args = parser.parse_args()
+
+    server = start_mock_server(args.port, args.latency_ms, args.fixtures, args.record)
+    mode = f"recording to {args.record}" if args.record else f"replaying {len(server.routes)} routes"
+    print(f"Mock Alpaca API on {server.url} ({mode}); Ctrl+C to stop")
+    try:
+        threading.Event().wait()
+    except KeyboardInterrupt:
+        server.shutdown()
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,249 @@
+"""
+Load-test the MCP tools against the mock Alpaca API (benchmarks/mock_alpaca.py).
+
+Each tool scenario is called --requests times by --concurrency concurrent callers,
+in-process and through the same instrumented tool wrappers the MCP transports use.
+Per tool it reports throughput, p50/p95/p99 latency (total and upstream), errors,
+mean response size and the process memory high-water mark after the run.
+
+Usage:
+    python benchmarks/run_benchmark.py
+    python benchmarks/run_benchmark.py --tools get_stock_bars,get_option_chain --concurrency 32 --latency-ms 25
+    python benchmarks/run_benchmark.py --mixed --requests 500 --no-cache --json
+    python benchmarks/run_benchmark.py --parsers
+
+--parsers times the server's argument parsers (timeframes, ISO dates, order
+requests) per call instead, memoized and uncached, without starting the mock.
+
+The server is configured for the run: both API URLs point at the mock, the order
+mirror and bar store are off (so every call reaches the mock), and the rate limit is
+lifted unless --rate-limit is given. --mock-url uses an already running mock instead,
+e.g. one started with --record to capture fixtures; the order scenarios then reach the
+real API, so record with paper credentials only.
+"""
+
+import argparse
+import asyncio
+import json
+import os
+import sys
+import time
+import timeit
+import tracemalloc
+from typing import Any, Dict, List, Optional
+
+try:
+    import resource
+except ImportError:  # Windows
+    resource = None
+
+BENCHMARK_DIR = os.path.dirname(os.path.abspath(__file__))
+sys.path.insert(0, BENCHMARK_DIR)
+sys.path.insert(0, os.path.dirname(BENCHMARK_DIR))
+
+from mock_alpaca import start_mock_server
+
+# Tool name -> keyword arguments for one call; the symbols match the bundled fixtures
+SCENARIOS: Dict[str, Dict[str, Any]] = {
+    "get_account_info": {},
+    "get_positions": {},
+    "get_open_position": {"symbol": "AAPL"},
+    "get_market_clock": {},
+    "get_orders": {"status": "all", "limit": 10},
+    "get_stock_bars": {"symbol": "AAPL", "days": 1, "timeframe": "1Min"},
+    "get_stock_bars_batch": {"symbols": ["AAPL", "MSFT"], "days": 1, "timeframe": "1Min"},
+    "get_stock_trades": {"symbol": "AAPL", "days": 1},
+    "get_stock_latest_trade": {"symbol": "AAPL"},
+    "get_stock_snapshot": {"symbol_or_symbols": ["AAPL", "MSFT"]},
+    "get_option_chain": {"underlying_symbol": "AAPL"},
+    "search_assets": {"query": "micro"},
+    "scan_market": {"preset": "most_active"},
+    "place_stock_order": {"symbol": "AAPL", "side": "buy", "quantity": 1},
+    "cancel_order_by_id": {"order_id": "61e69015-8549-4bfd-b9c3-01e75843f401"},
+}
+
+# Argument parsers timed by --parsers: name -> function returning (parser, args for one call)
+PARSER_CASES = {
+    "parse_timeframe_with_enums": lambda server: (server.parse_timeframe_with_enums, ("15Min",)),
+    "_parse_iso_datetime": lambda server: (server._parse_iso_datetime, ("2024-06-03T13:30:00Z",)),
+    "_orders_request": lambda server: (server._orders_request, (server.QueryOrderStatus.ALL, 10)),
+    "_build_stock_order_request": lambda server: (
+        server._build_stock_order_request, ("AAPL", "buy", 1, "limit", "day", 190.0)
+    ),
+}
+
+def _max_rss_mib() -> Optional[float]:
+    """Process peak resident set size so far, in MiB."""
+    if resource is None:
+        return None
+    peak = resource.getrusage(resource.RUSAGE_SELF).ru_maxrss
+    return peak / (1024 * 1024) if sys.platform == "darwin" else peak / 1024  # bytes on macOS, KiB elsewhere
+
+def configure_server(mock_url: str, args: argparse.Namespace):
+    """Point the server at the mock and import it; its settings are read at import time."""
+    os.environ.setdefault("ALPACA_API_KEY", "BENCHMARKKEY")
+    os.environ.setdefault("ALPACA_SECRET_KEY", "BENCHMARKSECRET")
+    os.environ.update({
+        "TRADE_API_URL": mock_url,
+        "DATA_API_URL": mock_url,
+        "MCP_ORDER_MIRROR": "False",
+        "MCP_BAR_STORE_PATH": "",
+        "MCP_RATE_LIMIT_PER_MIN": str(args.rate_limit or 1_000_000),
+        "MCP_METRICS_SAMPLES": str(max(args.requests, 1)),
+    })
+    if args.workers:
+        os.environ["MCP_MAX_WORKERS"] = str(args.workers)
+    import alpaca_mcp_server as server
+    if args.no_cache:
+        # response_cache shares this dict, so zeroing it disables caching for the run
+        for name in server.CACHE_TTLS:
+            server.CACHE_TTLS[name] = 0
+    return server
+
+async def _drive(server, calls: List[tuple], concurrency: int) -> float:
+    """Run (tool, kwargs) calls with `concurrency` callers; returns the wall time."""
+    queue = list(reversed(calls))
+
+    async def caller():
+        while queue:
+            tool, kwargs = queue.pop()
+            try:
+                # Module-level tool functions are the instrumented wrappers FastMCP registered
+                await getattr(server, tool)(**kwargs)
+            except Exception:
+                pass  # Counted as an error by the tool metrics
+
+    start = time.perf_counter()
+    await asyncio.gather(*(caller() for _ in range(concurrency)))
+    return time.perf_counter() - start
+
+def _summarize(server, tool: str, wall: float, rss: Optional[float], traced: Optional[int]) -> Dict[str, Any]:
+    metrics = server.tool_metrics
+    calls = metrics.calls.get(tool, 0)
+    quantiles = metrics.quantiles(tool) if calls else {phase: [0.0] * 3 for phase in server.METRIC_PHASES}
+    return {
+        "tool": tool,
+        "calls": calls,
+        "errors": sum(metrics.errors.get(tool, {}).values()),
+        "throughput": calls / wall if wall else 0.0,
+        "p50_ms": quantiles["total"][0] * 1000,
+        "p95_ms": quantiles["total"][1] * 1000,
+        "p99_ms": quantiles["total"][2] * 1000,
+        "upstream_p50_ms": quantiles["upstream"][0] * 1000,
+        "upstream_p99_ms": quantiles["upstream"][2] * 1000,
+        "mean_bytes": metrics.response_bytes.get(tool, 0) / calls if calls else 0.0,
+        "max_rss_mib": rss,
+        "traced_peak_kib": traced / 1024 if traced is not None else None,
+    }
+
+async def run(server, tools: List[str], args: argparse.Namespace) -> List[Dict[str, Any]]:
+    for tool in tools:  # Warm-up: client construction, connection pool, first-call imports
+        for _ in range(args.warmup):
+            await _drive(server, [(tool, SCENARIOS[tool])], 1)
+
+    phases = [tools] if args.mixed else [[tool] for tool in tools]
+    results = []
+    for phase in phases:
+        server.tool_metrics = server.ToolMetrics(max(args.requests, 1))
+        if args.trace_memory:
+            tracemalloc.reset_peak()
+        # Interleave the tools of a mixed phase so they contend for the pool and rate limiter
+        calls = [(tool, SCENARIOS[tool]) for _ in range(args.requests) for tool in phase]
+        wall = await _drive(server, calls, args.concurrency)
+        traced = tracemalloc.get_traced_memory()[1] if args.trace_memory else None
+        results.extend(_summarize(server, tool, wall, _max_rss_mib(), traced) for tool in phase)
+    return results
+
+def bench_parsers(server, iterations: int) -> List[Dict[str, Any]]:
+    """Per-call cost of each argument parser, memoized and (where memoized) uncached."""
+    results = []
+    for name, case in PARSER_CASES.items():
+        parser, parser_args = case(server)
+        memoized = timeit.timeit(lambda: parser(*parser_args), number=iterations) / iterations
+        uncached_parser = getattr(parser, "__wrapped__", None)
+        uncached = None
+        if uncached_parser is not None:
+            uncached = timeit.timeit(lambda: uncached_parser(*parser_args), number=iterations) / iterations
+        results.append({
+            "parser": name,
+            "us_per_call": memoized * 1e6,
+            "uncached_us_per_call": uncached * 1e6 if uncached is not None else None,
+        })
+    return results
+
+def _print_parser_table(results: List[Dict[str, Any]], iterations: int) -> None:
+    print(f"\n{iterations} calls per parser")
+    header = f"{'Parser':<30}{'us/call':>10}{'Uncached':>10}"
+    print(header)
+    print("-" * len(header))
+    for r in results:
+        uncached = f"{r['uncached_us_per_call']:.2f}" if r["uncached_us_per_call"] is not None else "n/a"
+        print(f"{r['parser']:<30}{r['us_per_call']:>10.2f}{uncached:>10}")
+
+def _print_table(results: List[Dict[str, Any]], args: argparse.Namespace, mock) -> None:
+    mode = "mixed" if args.mixed else "per tool"
+    print(f"\n{args.requests} requests per tool, concurrency {args.concurrency}, {mode}, "
+          f"mock latency {args.latency_ms:g} ms, cache {'off' if args.no_cache else 'on'}")
+    header = (f"{'Tool':<26}{'Calls':>7}{'Err':>5}{'Req/s':>9}{'p50 ms':>9}{'p95 ms':>9}{'p99 ms':>9}"
+              f"{'Up p50':>9}{'Up p99':>9}{'Bytes':>9}{'RSS MiB':>9}")
+    if args.trace_memory:
+        header += f"{'Peak KiB':>10}"
+    print(header)
+    print("-" * len(header))
+    for r in results:
+        rss = f"{r['max_rss_mib']:.1f}" if r["max_rss_mib"] is not None else "n/a"
+        line = (f"{r['tool']:<26}{r['calls']:>7}{r['errors']:>5}{r['throughput']:>9.1f}{r['p50_ms']:>9.2f}"
+                f"{r['p95_ms']:>9.2f}{r['p99_ms']:>9.2f}{r['upstream_p50_ms']:>9.2f}{r['upstream_p99_ms']:>9.2f}"
+                f"{r['mean_bytes']:>9.0f}{rss:>9}")
+        if args.trace_memory:
+            line += f"{r['traced_peak_kib']:>10.0f}"
+        print(line)
+    if mock is not None:
+        print(f"\nMock requests served: {mock.requests_served}")
+
+def main() -> None:
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--tools", help=f"Comma-separated scenarios (default: all of {', '.join(SCENARIOS)})")
+    parser.add_argument("--requests", type=int, default=200, help="Calls per tool (default: 200)")
+    parser.add_argument("--concurrency", type=int, default=16, help="Concurrent callers (default: 16)")
+    parser.add_argument("--warmup", type=int, default=3, help="Untimed calls per tool first (default: 3)")
+    parser.add_argument("--mixed", action="store_true", help="Run all tools interleaved in one phase")
+    parser.add_argument("--latency-ms", type=float, default=0.0, help="Simulated API latency per request")
+    parser.add_argument("--no-cache", action="store_true", help="Disable the response cache")
+    parser.add_argument("--rate-limit", type=int, help="Per-minute request budget (default: unlimited)")
+    parser.add_argument("--workers", type=int, help="MCP_MAX_WORKERS for the run")
+    parser.add_argument("--trace-memory", action="store_true",
+                        help="Report the Python allocation peak per phase (tracemalloc; slows the run)")
+    parser.add_argument("--mock-url", help="Use a running mock instead of starting one")
+    parser.add_argument("--parsers", action="store_true",
+                        help="Time the argument parsers (--requests calls each) instead of the tools")
+    parser.add_argument("--json", action="store_true", help="Print results as JSON")
+    args = parser.parse_args()
+
+    if args.parsers:
+        server = configure_server(args.mock_url or "http://127.0.0.1:9", args)
+        results = bench_parsers(server, max(args.requests, 1))
+        if args.json:
+            print(json.dumps(results, indent=2))
+        else:
+            _print_parser_table(results, max(args.requests, 1))
+        return
+
+    tools = [t.strip() for t in args.tools.split(",")] if args.tools else list(SCENARIOS)
+    unknown = [t for t in tools if t not in SCENARIOS]
+    if unknown:
+        parser.error(f"unknown scenarios: {', '.join(unknown)}")
+
+    mock = None if args.mock_url else start_mock_server(latency_ms=args.latency_ms)
+    server = configure_server(args.mock_url or mock.url, args)
+    if args.trace_memory:
+        tracemalloc.start()
+    results = asyncio.run(run(server, tools, args))
+
+    if args.json:
+        print(json.dumps(results, indent=2))
+    else:
+        _print_table(results, args, mock)
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,130 @@
+"""
+Unit tests for the option order pre-validation helpers.
+
+_parse_occ_symbol, _option_order_requirements and _round_option_price are pure functions,
+but a wrong answer from them blocks real orders locally or gets them rejected, so every
+strategy they classify and every tick band they price is covered here.
+
+Run with: python -m unittest discover tests
+"""
+
+import os
+import unittest
+from datetime import date
+from types import SimpleNamespace
+
+# The server reads its credentials at import time; clients are only built on first use
+os.environ.setdefault("ALPACA_API_KEY", "test-key")
+os.environ.setdefault("ALPACA_SECRET_KEY", "test-secret")
+
+import alpaca_mcp_server as server
+from alpaca.trading.enums import OrderSide
+from alpaca.trading.requests import OptionLegRequest
+
+def leg(symbol: str, side: OrderSide, ratio_qty: int = 1) -> OptionLegRequest:
+    return OptionLegRequest(symbol=symbol, side=side, ratio_qty=ratio_qty)
+
+def held(symbol: str, qty: float) -> SimpleNamespace:
+    return SimpleNamespace(symbol=symbol, qty=str(qty))
+
+def positions(*items: SimpleNamespace) -> dict:
+    return {item.symbol: item for item in items}
+
+CALL_150 = "AAPL260618C00150000"
+CALL_160 = "AAPL260618C00160000"
+CALL_150_LATER = "AAPL260918C00150000"
+PUT_140 = "AAPL260618P00140000"
+PUT_130 = "AAPL260618P00130000"
+
+class ParseOccSymbolTest(unittest.TestCase):
+    def test_parses_root_expiration_type_and_strike(self):
+        self.assertEqual(server._parse_occ_symbol(CALL_150), ("AAPL", date(2026, 6, 18), "C", 150.0))
+
+    def test_is_case_insensitive(self):
+        self.assertEqual(server._parse_occ_symbol("spy260618p00512500"), ("SPY", date(2026, 6, 18), "P", 512.5))
+
+    def test_accepts_roots_with_digits(self):
+        self.assertEqual(server._parse_occ_symbol("BRKB1260618C00400000")[0], "BRKB1")
+
+    def test_rejects_non_option_symbols(self):
+        for symbol in ("AAPL", "AAPL260618C150", "AAPL260618X00150000", "TOOLONGROOT260618C00150000"):
+            with self.subTest(symbol=symbol):
+                self.assertIsNone(server._parse_occ_symbol(symbol))
+
+    def test_rejects_impossible_dates(self):
+        self.assertIsNone(server._parse_occ_symbol("AAPL261332C00150000"))
+
+class OptionOrderRequirementsTest(unittest.TestCase):
+    def requirements(self, legs, quantity=1, held_positions=None):
+        return server._option_order_requirements(legs, quantity, held_positions or {})
+
+    def test_long_call_needs_level_2(self):
+        self.assertEqual(self.requirements([leg(CALL_150, OrderSide.BUY)]), (2, 0.0))
+
+    def test_covered_call_needs_level_1(self):
+        self.assertEqual(self.requirements([leg(CALL_150, OrderSide.SELL)], 2, positions(held("AAPL", 200))), (1, 0.0))
+
+    def test_call_without_enough_shares_is_uncovered(self):
+        self.assertEqual(self.requirements([leg(CALL_150, OrderSide.SELL)], 2, positions(held("AAPL", 150))), (4, 0.0))
+
+    def test_cash_secured_put_needs_level_1_and_collateral(self):
+        self.assertEqual(self.requirements([leg(PUT_140, OrderSide.SELL)], 3), (1, 140 * 100 * 3))
+
+    def test_vertical_spread_needs_level_3(self):
+        legs = [leg(CALL_150, OrderSide.BUY), leg(CALL_160, OrderSide.SELL)]
+        self.assertEqual(self.requirements(legs), (3, 0.0))
+
+    def test_put_spread_needs_level_3_without_collateral(self):
+        legs = [leg(PUT_130, OrderSide.BUY), leg(PUT_140, OrderSide.SELL)]
+        self.assertEqual(self.requirements(legs), (3, 0.0))
+
+    def test_short_leg_outliving_the_long_leg_is_uncovered(self):
+        legs = [leg(CALL_150, OrderSide.BUY), leg(CALL_150_LATER, OrderSide.SELL)]
+        self.assertEqual(self.requirements(legs)[0], 4)
+
+    def test_calendar_spread_with_a_later_long_leg_needs_level_3(self):
+        legs = [leg(CALL_150_LATER, OrderSide.BUY), leg(CALL_150, OrderSide.SELL)]
+        self.assertEqual(self.requirements(legs), (3, 0.0))
+
+    def test_ratio_spread_with_extra_short_contracts_is_uncovered(self):
+        legs = [leg(CALL_150, OrderSide.BUY), leg(CALL_160, OrderSide.SELL, ratio_qty=2)]
+        self.assertEqual(self.requirements(legs)[0], 4)
+
+    def test_short_put_in_a_multi_leg_order_is_not_cash_secured(self):
+        legs = [leg(CALL_150, OrderSide.BUY), leg(PUT_140, OrderSide.SELL)]
+        self.assertEqual(self.requirements(legs), (4, 0.0))
+
+    def test_selling_to_close_a_long_needs_no_level(self):
+        self.assertEqual(self.requirements([leg(CALL_150, OrderSide.SELL)], 2, positions(held(CALL_150, 2))), (0, 0.0))
+
+    def test_buying_to_close_a_short_needs_no_level(self):
+        self.assertEqual(self.requirements([leg(PUT_140, OrderSide.BUY)], 1, positions(held(PUT_140, -1))), (0, 0.0))
+
+    def test_closing_both_legs_of_a_spread_needs_no_level(self):
+        legs = [leg(CALL_150, OrderSide.SELL), leg(CALL_160, OrderSide.BUY)]
+        held_positions = positions(held(CALL_150, 1), held(CALL_160, -1))
+        self.assertEqual(self.requirements(legs, 1, held_positions), (0, 0.0))
+
+    def test_closing_more_than_held_opens_the_rest(self):
+        self.assertEqual(self.requirements([leg(CALL_150, OrderSide.BUY)], 3, positions(held(CALL_150, -1))), (2, 0.0))
+
+class RoundOptionPriceTest(unittest.TestCase):
+    def test_single_leg_below_3_rounds_to_nickels(self):
+        self.assertEqual(server._round_option_price(1.23, False), 1.25)
+        self.assertEqual(server._round_option_price(-2.12, False), -2.10)
+
+    def test_single_leg_from_3_rounds_to_dimes(self):
+        self.assertEqual(server._round_option_price(3.14, False), 3.10)
+        self.assertEqual(server._round_option_price(12.36, False), 12.40)
+
+    def test_prices_on_the_tick_are_unchanged(self):
+        for price in (0.05, 2.95, 3.0, 7.3):
+            with self.subTest(price=price):
+                self.assertEqual(server._round_option_price(price, False), price)
+
+    def test_multi_leg_net_prices_round_to_pennies(self):
+        self.assertEqual(server._round_option_price(1.234, True), 1.23)
+        self.assertEqual(server._round_option_price(-4.567, True), -4.57)
+
+if __name__ == "__main__":
+    unittest.main()